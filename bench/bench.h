@@ -0,0 +1,213 @@
+#ifndef BENCH_H
+#define BENCH_H
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <time.h>
+
+// Shared helpers for the bench_<module> programs built by `make bench`
+
+// Allocation counting. `make bench` links with -Wl,--wrap for malloc,
+// calloc and realloc, so every such call from the modules and the bench
+// passes through here. The __real_ symbols are weak, so a bench built
+// without those flags still links and simply reports no counts.
+extern void *__real_malloc(size_t size) __attribute__((weak));
+extern void *__real_calloc(size_t count, size_t size) __attribute__((weak));
+extern void *__real_realloc(void *ptr, size_t size) __attribute__((weak));
+
+static uint64_t bench_alloc_calls;
+static uint64_t bench_alloc_bytes;
+
+static inline void bench_count_alloc(size_t bytes) {
+  __atomic_fetch_add(&bench_alloc_calls, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&bench_alloc_bytes, bytes, __ATOMIC_RELAXED);
+}
+
+void *__wrap_malloc(size_t size) {
+  bench_count_alloc(size);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  bench_count_alloc(count * size);
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  bench_count_alloc(size);
+  return __real_realloc(ptr, size);
+}
+
+static inline uint64_t bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// A timed region: bench_begin reads the clock and allocation counters,
+// bench_end turns that into what elapsed and was allocated since
+typedef struct {
+  uint64_t ns;
+  uint64_t calls;
+  uint64_t bytes;
+} BenchWindow;
+
+static inline BenchWindow bench_begin(void) {
+  BenchWindow window;
+  window.calls = __atomic_load_n(&bench_alloc_calls, __ATOMIC_RELAXED);
+  window.bytes = __atomic_load_n(&bench_alloc_bytes, __ATOMIC_RELAXED);
+  window.ns = bench_now_ns();
+  return window;
+}
+
+static inline BenchWindow bench_end(BenchWindow begin) {
+  BenchWindow window;
+  window.ns = bench_now_ns() - begin.ns;
+  window.calls =
+      __atomic_load_n(&bench_alloc_calls, __ATOMIC_RELAXED) - begin.calls;
+  window.bytes =
+      __atomic_load_n(&bench_alloc_bytes, __ATOMIC_RELAXED) - begin.bytes;
+  return window;
+}
+
+// xorshift64*, deterministic across runs for a given seed
+static inline uint64_t bench_rand(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545F4914F6CDD1DULL;
+}
+
+static inline void bench_shuffle(int *values, int n, uint64_t *state) {
+  for (int i = n - 1; i > 0; i--) {
+    int j = (int)(bench_rand(state) % (uint64_t)(i + 1));
+    int tmp = values[i];
+    values[i] = values[j];
+    values[j] = tmp;
+  }
+}
+
+// Zipf(s) sampler over ranks [0, n) by inverse CDF lookup
+typedef struct {
+  double *cdf;
+  int n;
+} BenchZipf;
+
+static inline BenchZipf bench_zipf_create(int n, double s) {
+  BenchZipf zipf = {(double *)malloc(n * sizeof(double)), n};
+  double total = 0;
+  for (int i = 0; i < n; i++) {
+    total += 1.0 / pow(i + 1, s);
+    zipf.cdf[i] = total;
+  }
+  for (int i = 0; i < n; i++) {
+    zipf.cdf[i] /= total;
+  }
+  return zipf;
+}
+
+static inline int bench_zipf_next(BenchZipf *zipf, uint64_t *state) {
+  double u = (double)(bench_rand(state) >> 11) / 9007199254740992.0;
+  int lo = 0, hi = zipf->n - 1;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (zipf->cdf[mid] < u)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static inline void bench_zipf_destroy(BenchZipf *zipf) { free(zipf->cdf); }
+
+// Key sequences over n distinct keys 0, stride, 2 * stride, ...
+typedef enum {
+  BENCH_SORTED,      // Ascending
+  BENCH_RANDOM,      // A random permutation
+  BENCH_ZIPF,        // n Zipf(1.0) draws, repeats included; the hot keys
+                     // are scattered over the key space
+  BENCH_ADVERSARIAL, // Zigzag from both ends: smallest, largest, second
+                     // smallest, ... a degenerate path for unbalanced trees
+  BENCH_WORKLOADS
+} BenchWorkload;
+
+static inline const char *bench_workload_name(BenchWorkload workload) {
+  static const char *names[] = {"sorted", "random", "zipf", "adversarial"};
+  return names[workload];
+}
+
+static inline void bench_keys(BenchWorkload workload, int *keys, int n,
+                              int stride, uint64_t *state) {
+  for (int i = 0; i < n; i++) {
+    keys[i] = i * stride;
+  }
+  if (workload == BENCH_RANDOM) {
+    bench_shuffle(keys, n, state);
+  } else if (workload == BENCH_ZIPF) {
+    int *ranked = (int *)malloc(n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+      ranked[i] = keys[i];
+    }
+    bench_shuffle(ranked, n, state);
+    BenchZipf zipf = bench_zipf_create(n, 1.0);
+    for (int i = 0; i < n; i++) {
+      keys[i] = ranked[bench_zipf_next(&zipf, state)];
+    }
+    bench_zipf_destroy(&zipf);
+    free(ranked);
+  } else if (workload == BENCH_ADVERSARIAL) {
+    for (int i = 0; i < n; i++) {
+      keys[i] = (i % 2 ? n - 1 - i / 2 : i / 2) * stride;
+    }
+  }
+}
+
+// Peak resident set size of the process so far
+static inline long bench_peak_rss_kb(void) {
+  struct rusage usage;
+  return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : -1;
+}
+
+// Adds window to total, for results timed over several regions
+static inline void bench_accumulate(BenchWindow *total, BenchWindow window) {
+  total->ns += window.ns;
+  total->calls += window.calls;
+  total->bytes += window.bytes;
+}
+
+// Prints one result line for a window from bench_end. If the BENCH_JSON
+// environment variable names a file, the result is also appended to it as
+// one JSON object per line, with the peak RSS so far and the allocations
+// made in the window (null when the bench is built without counting), so
+// two runs can be diffed.
+static inline void bench_report(const char *name, long ops,
+                                BenchWindow window) {
+  uint64_t ns = window.ns;
+  double ns_per_op = ops ? (double)ns / ops : 0;
+  double ops_per_sec = ns ? ops * 1e9 / ns : 0;
+  printf("%-40s %10.1f ns/op %14.0f ops/s\n", name, ns_per_op, ops_per_sec);
+
+  const char *path = getenv("BENCH_JSON");
+  FILE *out = path && *path ? fopen(path, "a") : NULL;
+  if (!out)
+    return;
+  char calls[32] = "null", bytes[32] = "null";
+  if (__real_malloc) {
+    snprintf(calls, sizeof(calls), "%llu", (unsigned long long)window.calls);
+    snprintf(bytes, sizeof(bytes), "%llu", (unsigned long long)window.bytes);
+  }
+  fprintf(out,
+          "{\"name\": \"%s\", \"ops\": %ld, \"ns\": %llu, "
+          "\"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, "
+          "\"peak_rss_kb\": %ld, \"allocs\": %s, \"alloc_bytes\": %s}\n",
+          name, ops, (unsigned long long)ns, ns_per_op, ops_per_sec,
+          bench_peak_rss_kb(), calls, bytes);
+  fclose(out);
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include "bench.h"
+#include "bst.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_KEYS (1 << 16)
+#define NUM_LOOKUPS (1 << 21)
+
+typedef enum { MODE_PLAIN, MODE_TREAP, MODE_SPLAY } Mode;
+
+static const char *mode_names[] = {"plain", "treap", "splay"};
+
+static void build(BST *tree, Mode mode, int *keys, int n) {
+  for (int i = 0; i < n; i++) {
+    if (mode == MODE_PLAIN)
+      bst_insert(tree, keys[i]);
+    else if (mode == MODE_TREAP)
+      bst_treap_insert(tree, keys[i]);
+    else
+      bst_splay_insert(tree, keys[i]);
+  }
+}
+
+// Zipf-distributed lookups. Ranks map through their own shuffle, independent
+// of insertion order, so the hot keys are neither clustered in the key space
+// nor the first ones inserted (which would put them at the top of the plain
+// BST for free).
+static void bench_zipf_lookups(Mode mode, double s) {
+  uint64_t state = 42;
+  int *keys = malloc(NUM_KEYS * sizeof(int));
+  int *hot = malloc(NUM_KEYS * sizeof(int));
+  for (int i = 0; i < NUM_KEYS; i++) {
+    keys[i] = i * 2;
+    hot[i] = i * 2;
+  }
+  bench_shuffle(keys, NUM_KEYS, &state);
+  bench_shuffle(hot, NUM_KEYS, &state);
+
+  BST tree = {NULL, 0};
+  build(&tree, mode, keys, NUM_KEYS);
+
+  BenchZipf zipf = bench_zipf_create(NUM_KEYS, s);
+  int *queries = malloc(NUM_LOOKUPS * sizeof(int));
+  for (int i = 0; i < NUM_LOOKUPS; i++) {
+    queries[i] = hot[bench_zipf_next(&zipf, &state)];
+  }
+
+  long hits = 0;
+  BenchWindow start = bench_begin();
+  for (int i = 0; i < NUM_LOOKUPS; i++) {
+    BSTNode *found = mode == MODE_SPLAY ? bst_splay_search(&tree, queries[i])
+                                        : search(&tree, queries[i]);
+    hits += found != NULL;
+  }
+  BenchWindow elapsed = bench_end(start);
+  if (hits != NUM_LOOKUPS) {
+    fprintf(stderr, "lookup missed a key\n");
+    exit(1);
+  }
+
+  char name[64];
+  snprintf(name, sizeof(name), "bst/zipf_s%.1f/%s", s, mode_names[mode]);
+  bench_report(name, NUM_LOOKUPS, elapsed);
+
+  bench_zipf_destroy(&zipf);
+  free(queries);
+  free(hot);
+  free(keys);
+  free_tree(&tree);
+}
+
+// Checkpoint round trip through a temporary file
+static void bench_dump_load(int n) {
+  uint64_t state = 7;
+  int *keys = malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++) {
+    keys[i] = i * 3;
+  }
+  bench_shuffle(keys, n, &state);
+  BST tree = {NULL, 0};
+  for (int i = 0; i < n; i++) {
+    bst_treap_insert(&tree, keys[i]);
+  }
+
+  FILE *file = tmpfile();
+  BenchWindow start = bench_begin();
+  if (bst_dump(&tree, file) != 0) {
+    fprintf(stderr, "dump failed\n");
+    exit(1);
+  }
+  BenchWindow dump_window = bench_end(start);
+  start = bench_begin();
+  long bytes = ftell(file);
+  rewind(file);
+  BST loaded = {NULL, 0};
+  if (bst_load(&loaded, file) != 0 || loaded.size != n) {
+    fprintf(stderr, "load failed\n");
+    exit(1);
+  }
+  BenchWindow load_window = bench_end(start);
+  fclose(file);
+
+  char name[64];
+  snprintf(name, sizeof(name), "bst/dump/n%d", n);
+  bench_report(name, n, dump_window);
+  snprintf(name, sizeof(name), "bst/load/n%d", n);
+  bench_report(name, n, load_window);
+  printf("%-40s %10.2f bytes/key\n", "bst/dump/size", (double)bytes / n);
+
+  free(keys);
+  free_tree(&tree);
+  free_tree(&loaded);
+}
+
+// The plain BST under each workload. Sorted and zigzag keys degenerate it
+// into a path, so searches cost O(n) there and sizes stay moderate.
+static void bench_workload(BenchWorkload workload, int n) {
+  uint64_t state = 11;
+  int *keys = malloc(n * sizeof(int));
+  bench_keys(workload, keys, n, 2, &state);
+  int reps = (1 << 15) / n > 0 ? (1 << 15) / n : 1;
+  long hits = 0;
+  char name[64];
+  BST tree = {NULL, 0};
+
+  BenchWindow start = bench_begin();
+  for (int i = 0; i < n; i++)
+    bst_insert(&tree, keys[i]);
+  snprintf(name, sizeof(name), "bst/insert/%s/n%d",
+           bench_workload_name(workload), n);
+  bench_report(name, n, bench_end(start));
+
+  // Half hits and half misses (keys are even)
+  start = bench_begin();
+  for (int r = 0; r < reps; r++) {
+    for (int i = 0; i < n; i++)
+      hits += search(&tree, keys[i] + (i & 1)) != NULL;
+  }
+  snprintf(name, sizeof(name), "bst/search/%s/n%d",
+           bench_workload_name(workload), n);
+  bench_report(name, (long)reps * n, bench_end(start));
+
+  // Latest keys first: on a path these are the deepest
+  start = bench_begin();
+  for (int i = n - 1; i >= 0; i--)
+    delete_node(&tree, keys[i]);
+  snprintf(name, sizeof(name), "bst/delete_node/%s/n%d",
+           bench_workload_name(workload), n);
+  bench_report(name, n, bench_end(start));
+  if (!is_empty(&tree) || hits == 0) {
+    fprintf(stderr, "workload left the tree inconsistent\n");
+    exit(1);
+  }
+  free(keys);
+}
+
+int main() {
+  int sizes[] = {1 << 10, 1 << 12, 1 << 14};
+  for (int s = 0; s < 3; s++) {
+    for (int w = 0; w < BENCH_WORKLOADS; w++)
+      bench_workload((BenchWorkload)w, sizes[s]);
+  }
+  double skews[] = {0.8, 1.0, 1.2};
+  for (int i = 0; i < 3; i++) {
+    for (int mode = MODE_PLAIN; mode <= MODE_SPLAY; mode++) {
+      bench_zipf_lookups((Mode)mode, skews[i]);
+    }
+  }
+  bench_dump_load(1 << 20);
+  return 0;
+}
@@ -0,0 +1,148 @@
+#include "bench.h"
+#include "components.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SCALE 17
+#define EDGE_FACTOR 8
+#define REPEATS 3
+
+// Same R-MAT generator as bench_par_bfs
+static void rmat_edge(uint64_t *state, int scale, int *from, int *to) {
+  int u = 0, v = 0;
+  for (int bit = 0; bit < scale; bit++) {
+    double r = (double)(bench_rand(state) >> 11) / 9007199254740992.0;
+    if (r < 0.57) {
+    } else if (r < 0.76) {
+      v |= 1 << bit;
+    } else if (r < 0.95) {
+      u |= 1 << bit;
+    } else {
+      u |= 1 << bit;
+      v |= 1 << bit;
+    }
+  }
+  *from = u;
+  *to = v;
+}
+
+// Serial BFS labeling over both directions, the usual single-thread answer
+static size_t serial_components(const CSRGraph *graph, uint32_t *label,
+                                uint32_t *queue) {
+  size_t n = graph->num_nodes, count = 0;
+  for (size_t i = 0; i < n; i++)
+    label[i] = CSR_NONE;
+  for (uint32_t s = 0; s < n; s++) {
+    if (label[s] != CSR_NONE)
+      continue;
+    count++;
+    size_t head = 0, tail = 0;
+    queue[tail++] = s;
+    label[s] = s;
+    while (head < tail) {
+      uint32_t u = queue[head++];
+      for (int kind = CSR_INCOMING; kind <= CSR_OUTGOING; kind++) {
+        const uint32_t *nb = csr_neighbors(graph, (CSRKind)kind, u);
+        for (size_t j = 0; j < csr_degree(graph, (CSRKind)kind, u); j++) {
+          if (label[nb[j]] == CSR_NONE) {
+            label[nb[j]] = s;
+            queue[tail++] = nb[j];
+          }
+        }
+      }
+    }
+  }
+  return count;
+}
+
+static size_t serial_toposort(const CSRGraph *graph, uint32_t *order,
+                              uint32_t *indegree) {
+  size_t n = graph->num_nodes, tail = 0;
+  for (size_t i = 0; i < n; i++)
+    indegree[i] = (uint32_t)csr_degree(graph, CSR_INCOMING, (uint32_t)i);
+  for (uint32_t i = 0; i < n; i++)
+    if (!indegree[i])
+      order[tail++] = i;
+  for (size_t head = 0; head < tail; head++) {
+    uint32_t u = order[head];
+    const uint32_t *nb = csr_neighbors(graph, CSR_OUTGOING, u);
+    for (size_t j = 0; j < csr_degree(graph, CSR_OUTGOING, u); j++)
+      if (--indegree[nb[j]] == 0)
+        order[tail++] = nb[j];
+  }
+  return tail;
+}
+
+int main() {
+  int n = 1 << SCALE;
+  uint64_t state = 11;
+  GraphArena *arena = arena_create(n);
+  Node **nodes = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++)
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+  for (long i = 0; i < (long)n * EDGE_FACTOR; i++) {
+    int u, v;
+    rmat_edge(&state, SCALE, &u, &v);
+    // Pointing every edge at the higher index keeps the graph acyclic
+    if (u != v)
+      add_edge(nodes[u < v ? u : v], nodes[u < v ? v : u], true, false);
+  }
+  int *shuffle = malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++)
+    shuffle[i] = i;
+  bench_shuffle(shuffle, n, &state);
+  Node **view = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++)
+    view[i] = nodes[shuffle[i]];
+  CSRGraph *graph = csr_freeze(view, n);
+  long edges = (long)graph->offsets[CSR_OUTGOING][n];
+
+  uint32_t *out = malloc(n * sizeof(uint32_t));
+  uint32_t *scratch = malloc(n * sizeof(uint32_t));
+  int max_threads = parallel_default_threads();
+  if (max_threads < 8)
+    max_threads = 8;
+  size_t checksum = 0;
+  char name[64];
+
+  // ops are edges, so ops/s is edges processed per second
+  BenchWindow start = bench_begin();
+  for (int r = 0; r < REPEATS; r++)
+    checksum += serial_components(graph, out, scratch);
+  bench_report("components/rmat17/serial_bfs", REPEATS * edges,
+               bench_end(start));
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    start = bench_begin();
+    for (int r = 0; r < REPEATS; r++)
+      checksum += par_components(graph, CSR_OUTGOING, threads, out);
+    snprintf(name, sizeof(name), "components/rmat17/threads=%d", threads);
+    bench_report(name, REPEATS * edges, bench_end(start));
+  }
+
+  start = bench_begin();
+  for (int r = 0; r < REPEATS; r++)
+    checksum += serial_toposort(graph, out, scratch);
+  bench_report("toposort/rmat17/serial_kahn", REPEATS * edges,
+               bench_end(start));
+  TopoSortResult result;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    start = bench_begin();
+    for (int r = 0; r < REPEATS; r++) {
+      par_toposort(graph, threads, out, NULL, &result);
+      checksum += result.ordered;
+    }
+    snprintf(name, sizeof(name), "toposort/rmat17/threads=%d", threads);
+    bench_report(name, REPEATS * edges, bench_end(start));
+  }
+  printf("  (checksum %zu, %zu levels)\n", checksum, result.levels);
+
+  csr_destroy(graph);
+  arena_destroy(arena);
+  free(nodes);
+  free(view);
+  free(shuffle);
+  free(out);
+  free(scratch);
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "edgelist.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NUM_NODES (1 << 18)
+#define NUM_EDGES (1 << 22)
+
+// Power-law endpoints, as in web and social graphs
+static uint64_t skewed_node(uint64_t *state) {
+  uint64_t r = bench_rand(state);
+  int bits = 1 + (int)(r % 18);
+  return (bench_rand(state) & ((1ULL << bits) - 1)) % NUM_NODES;
+}
+
+// The line-by-line loader this module replaces: stdio, strtoull and one
+// add_edge per line
+static Graph *stdio_load(const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return NULL;
+  Graph *graph = graph_create(0);
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    char *end;
+    double a = (double)strtoull(line, &end, 10);
+    double b = (double)strtoull(end, &end, 10);
+    add_edge(graph_ensure_node(graph, a), graph_ensure_node(graph, b), false,
+             true);
+  }
+  fclose(file);
+  return graph;
+}
+
+int main() {
+  char path[] = "/tmp/bench_edgelistXXXXXX";
+  int fd = mkstemp(path);
+  FILE *file = fdopen(fd, "w");
+  uint64_t state = 11;
+  for (int i = 0; i < NUM_EDGES; i++) {
+    unsigned long long a = skewed_node(&state);
+    unsigned long long b = skewed_node(&state);
+    fprintf(file, "%llu %llu\n", a, b);
+  }
+  fclose(file);
+  long checksum = 0;
+
+  BenchWindow start = bench_begin();
+  Graph *graph = stdio_load(path);
+  bench_report("edgelist/stdio_add_edge", NUM_EDGES, bench_end(start));
+  checksum += (long)graph_num_nodes(graph);
+  graph_destroy(graph);
+
+  int threads[] = {1, 2, 4, parallel_default_threads()};
+  for (int i = 0; i < 4; i++) {
+    EdgeListOptions options = {false, true, threads[i]};
+    EdgeListStats stats;
+    char name[64];
+    start = bench_begin();
+    graph = edgelist_load(path, &options, &stats);
+    snprintf(name, sizeof(name), "edgelist/mmap_bulk/threads=%d", threads[i]);
+    bench_report(name, NUM_EDGES, bench_end(start));
+    checksum += (long)graph_num_nodes(graph) + (long)stats.duplicates;
+    graph_destroy(graph);
+  }
+
+  unlink(path);
+  printf("checksum %ld\n", checksum);
+  return 0;
+}
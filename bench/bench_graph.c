@@ -0,0 +1,106 @@
+#include "bench.h"
+#include "graph.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_NODES (1 << 20)
+#define NUM_LOOKUPS (1 << 22)
+#define NUM_EDGES (1 << 22)
+#define SCAN_LOOKUPS 256
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// The array a caller keeps without an index: found by scanning
+static Node *scan_find(Node **nodes, size_t count, double id) {
+  for (size_t i = 0; i < count; i++) {
+    if (nodes[i]->node_id == id)
+      return nodes[i];
+  }
+  return NULL;
+}
+
+static Node *sorted_find(const double *ids, Node **nodes, size_t count,
+                         double id) {
+  size_t lo = 0, hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (ids[mid] < id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < count && ids[lo] == id ? nodes[lo] : NULL;
+}
+
+int main() {
+  uint64_t state = 3;
+  // Sparse integer ids, as from an external key space
+  double *ids = malloc(NUM_NODES * sizeof(double));
+  for (int i = 0; i < NUM_NODES; i++)
+    ids[i] = (double)(bench_rand(&state) >> 11);
+  double *queries = malloc(NUM_LOOKUPS * sizeof(double));
+  for (int i = 0; i < NUM_LOOKUPS; i++)
+    queries[i] = ids[bench_rand(&state) % NUM_NODES];
+  Node **out = malloc(NUM_LOOKUPS * sizeof(Node *));
+  long checksum = 0;
+
+  BenchWindow start = bench_begin();
+  Graph *graph = graph_create(NUM_NODES);
+  for (int i = 0; i < NUM_NODES; i++)
+    graph_add_node(graph, NULL, ids[i]);
+  bench_report("graph/add_node", NUM_NODES, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < SCAN_LOOKUPS; i++)
+    checksum += scan_find(graph->nodes, graph->num_nodes, queries[i]) != NULL;
+  bench_report("graph/find/linear_scan", SCAN_LOOKUPS, bench_end(start));
+
+  double *sorted_ids = malloc(NUM_NODES * sizeof(double));
+  Node **sorted_nodes = malloc(NUM_NODES * sizeof(Node *));
+  for (int i = 0; i < NUM_NODES; i++)
+    sorted_ids[i] = ids[i];
+  qsort(sorted_ids, NUM_NODES, sizeof(double), compare_doubles);
+  for (int i = 0; i < NUM_NODES; i++)
+    sorted_nodes[i] = graph_find(graph, sorted_ids[i]);
+  start = bench_begin();
+  for (int i = 0; i < NUM_LOOKUPS; i++)
+    checksum += sorted_find(sorted_ids, sorted_nodes, NUM_NODES,
+                            queries[i]) != NULL;
+  bench_report("graph/find/binary_search", NUM_LOOKUPS,
+               bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_LOOKUPS; i++)
+    checksum += graph_find(graph, queries[i]) != NULL;
+  bench_report("graph/find/hash", NUM_LOOKUPS, bench_end(start));
+
+  start = bench_begin();
+  checksum += (long)graph_find_batch(graph, queries, NUM_LOOKUPS, out);
+  bench_report("graph/find/hash_batch", NUM_LOOKUPS, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_EDGES; i++)
+    checksum += graph_add_edge_by_id(graph, queries[i],
+                                     queries[(i * 7 + 1) % NUM_LOOKUPS], true,
+                                     false);
+  bench_report("graph/add_edge_by_id", NUM_EDGES, bench_end(start));
+
+  // Each removal unlinks about eight in and out neighbors, plus its share
+  // of the periodic sweep for one-way entries
+  start = bench_begin();
+  for (int i = 0; i < NUM_NODES / 2; i++)
+    checksum += graph_remove_node(graph, ids[i]);
+  bench_report("graph/remove_node", NUM_NODES / 2, bench_end(start));
+
+  printf("  (checksum %ld)\n", checksum);
+  graph_destroy(graph);
+  free(sorted_ids);
+  free(sorted_nodes);
+  free(ids);
+  free(queries);
+  free(out);
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include "bench.h"
+#include "lca.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_NODES (1 << 20)
+#define NUM_QUERIES (1 << 20)
+#define NAIVE_QUERIES (1 << 16)
+
+static int naive_depth(Node *node) {
+  int depth = 0;
+  for (; node->parent; node = node->parent)
+    depth++;
+  return depth;
+}
+
+static Node *naive_lca(Node *u, Node *v) {
+  int du = naive_depth(u), dv = naive_depth(v);
+  for (; du > dv; du--)
+    u = u->parent;
+  for (; dv > du; dv--)
+    v = v->parent;
+  while (u != v) {
+    u = u->parent;
+    v = v->parent;
+  }
+  return u;
+}
+
+// Random recursive tree when spine is 0; otherwise every node hangs within
+// `spine` positions of its predecessor, which makes depths grow as n / spine.
+static void bench_tree(const char *shape, int spine) {
+  GraphArena *arena = arena_create(NUM_NODES);
+  Node **nodes = malloc(NUM_NODES * sizeof(Node *));
+  uint64_t state = 23;
+  for (int i = 0; i < NUM_NODES; i++) {
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+    if (i == 0)
+      continue;
+    int lo = spine && i > spine ? i - spine : 0;
+    add_child(nodes[lo + bench_rand(&state) % (i - lo)], nodes[i]);
+  }
+  Node **queries = malloc(2 * NUM_QUERIES * sizeof(Node *));
+  for (int i = 0; i < 2 * NUM_QUERIES; i++)
+    queries[i] = nodes[bench_rand(&state) % NUM_NODES];
+  char name[64];
+  long checksum = 0;
+
+  BenchWindow start = bench_begin();
+  LCAIndex *index = lca_create(nodes[0]);
+  snprintf(name, sizeof(name), "lca/%s/build", shape);
+  bench_report(name, NUM_NODES, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NAIVE_QUERIES; i++)
+    checksum += (long)naive_lca(queries[2 * i], queries[2 * i + 1])->node_id;
+  snprintf(name, sizeof(name), "lca/%s/naive_lca", shape);
+  bench_report(name, NAIVE_QUERIES, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_QUERIES; i++)
+    checksum += (long)lca(index, queries[2 * i], queries[2 * i + 1])->node_id;
+  snprintf(name, sizeof(name), "lca/%s/lca", shape);
+  bench_report(name, NUM_QUERIES, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_QUERIES; i++)
+    checksum += lca_is_ancestor(index, queries[2 * i], queries[2 * i + 1]);
+  snprintf(name, sizeof(name), "lca/%s/is_ancestor", shape);
+  bench_report(name, NUM_QUERIES, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NAIVE_QUERIES; i++)
+    checksum += naive_depth(queries[i]);
+  snprintf(name, sizeof(name), "lca/%s/naive_depth", shape);
+  bench_report(name, NAIVE_QUERIES, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_QUERIES; i++)
+    checksum += lca_depth(index, queries[i]);
+  snprintf(name, sizeof(name), "lca/%s/depth", shape);
+  bench_report(name, NUM_QUERIES, bench_end(start));
+
+  // Grow by 1% one leaf at a time through the overlay
+  int extra = NUM_NODES / 100;
+  Node **leaves = malloc(extra * sizeof(Node *));
+  for (int i = 0; i < extra; i++) {
+    leaves[i] = arena_create_node(arena, NULL, -(double)i);
+    add_child(nodes[bench_rand(&state) % NUM_NODES], leaves[i]);
+  }
+  start = bench_begin();
+  for (int i = 0; i < extra; i++)
+    lca_attach(index, leaves[i]);
+  snprintf(name, sizeof(name), "lca/%s/attach", shape);
+  bench_report(name, extra, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_QUERIES; i++)
+    checksum += lca_distance(index, leaves[i % extra], queries[i]);
+  snprintf(name, sizeof(name), "lca/%s/overlay_distance", shape);
+  bench_report(name, NUM_QUERIES, bench_end(start));
+
+  printf("  (checksum %ld)\n", checksum);
+  lca_destroy(index);
+  arena_destroy(arena);
+  free(leaves);
+  free(queries);
+  free(nodes);
+}
+
+int main() {
+  bench_tree("random", 0);
+  bench_tree("deep", 1024);
+  return 0;
+}
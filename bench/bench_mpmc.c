@@ -0,0 +1,157 @@
+#include "bench.h"
+#include "mpmc.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ITEMS (1 << 21)
+#define QUEUE_CAPACITY 1024
+#define TREE_NODES (1 << 20)
+
+// Producers push NUM_ITEMS / producers nodes each, consumers drain until
+// everything arrived
+typedef struct {
+  MPMCQueue *queue;
+  pthread_mutex_t mutex; // Baseline: NodeQueue behind a lock
+  NodeQueue *locked;
+  int producers;
+  size_t batch;
+  Node **items;
+  atomic_long consumed;
+} Contention;
+
+static void mpmc_worker(int thread, void *ctx) {
+  Contention *c = (Contention *)ctx;
+  long per_producer = NUM_ITEMS / c->producers;
+  if (thread < c->producers) {
+    Node **mine = c->items + thread * per_producer;
+    long sent = 0;
+    while (sent < per_producer) {
+      size_t want = c->batch;
+      if ((long)want > per_producer - sent)
+        want = (size_t)(per_producer - sent);
+      size_t moved = mpmc_enqueue_batch(c->queue, mine + sent, want);
+      if (!moved)
+        sched_yield();
+      sent += (long)moved;
+    }
+    return;
+  }
+  Node *batch[64];
+  while (atomic_load(&c->consumed) < NUM_ITEMS) {
+    size_t moved = mpmc_dequeue_batch(c->queue, batch, c->batch);
+    if (!moved)
+      sched_yield();
+    atomic_fetch_add(&c->consumed, (long)moved);
+  }
+}
+
+static void locked_worker(int thread, void *ctx) {
+  Contention *c = (Contention *)ctx;
+  long per_producer = NUM_ITEMS / c->producers;
+  if (thread < c->producers) {
+    Node **mine = c->items + thread * per_producer;
+    for (long i = 0; i < per_producer; i++) {
+      pthread_mutex_lock(&c->mutex);
+      queue_enqueue(c->locked, mine[i]);
+      pthread_mutex_unlock(&c->mutex);
+    }
+    return;
+  }
+  while (atomic_load(&c->consumed) < NUM_ITEMS) {
+    pthread_mutex_lock(&c->mutex);
+    Node *node = queue_dequeue(c->locked);
+    pthread_mutex_unlock(&c->mutex);
+    if (node)
+      atomic_fetch_add(&c->consumed, 1);
+    else
+      sched_yield();
+  }
+}
+
+static void bench_contention(Node **items, int pairs, size_t batch,
+                             bool locked) {
+  Contention c;
+  c.queue = mpmc_create(QUEUE_CAPACITY);
+  pthread_mutex_init(&c.mutex, NULL);
+  c.locked = queue_create(QUEUE_CAPACITY);
+  c.producers = pairs;
+  c.batch = batch;
+  c.items = items;
+  atomic_init(&c.consumed, 0);
+
+  BenchWindow start = bench_begin();
+  if (parallel_run(2 * pairs, locked ? locked_worker : mpmc_worker, &c) != 0) {
+    fprintf(stderr, "parallel_run failed\n");
+    exit(1);
+  }
+  BenchWindow window = bench_end(start);
+
+  char name[64];
+  if (locked)
+    snprintf(name, sizeof(name), "mutex_queue/%dp%dc", pairs, pairs);
+  else
+    snprintf(name, sizeof(name), "mpmc/%dp%dc/batch=%zu", pairs, pairs,
+             batch);
+  bench_report(name, NUM_ITEMS, window);
+
+  mpmc_destroy(c.queue);
+  queue_destroy(c.locked);
+  pthread_mutex_destroy(&c.mutex);
+}
+
+static atomic_long visited;
+
+static void count_node(Node *node) {
+  (void)node;
+  atomic_fetch_add_explicit(&visited, 1, memory_order_relaxed);
+}
+
+static void count_node_ctx(Node *node, void *ctx) {
+  (void)ctx;
+  count_node(node);
+}
+
+// Random recursive tree: node i hangs under a uniformly chosen earlier node
+static void bench_traversal(void) {
+  uint64_t state = 7;
+  Node **nodes = malloc(TREE_NODES * sizeof(Node *));
+  for (int i = 0; i < TREE_NODES; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    if (i)
+      add_child(nodes[bench_rand(&state) % i], nodes[i]);
+  }
+
+  BenchWindow start = bench_begin();
+  bfs(nodes[0], count_node);
+  bench_report("bfs/random_tree", TREE_NODES, bench_end(start));
+  for (int threads = 1; threads <= 4; threads *= 2) {
+    char name[64];
+    snprintf(name, sizeof(name), "mpmc_traverse/random_tree/threads=%d",
+             threads);
+    start = bench_begin();
+    mpmc_traverse(nodes[0], threads, count_node_ctx, NULL);
+    bench_report(name, TREE_NODES, bench_end(start));
+  }
+
+  for (int i = 0; i < TREE_NODES; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+}
+
+int main() {
+  Node **items = malloc(NUM_ITEMS * sizeof(Node *));
+  Node *node = create_node(NULL, 0.0);
+  for (int i = 0; i < NUM_ITEMS; i++)
+    items[i] = node; // Only the pointer moves through the queue
+  for (int pairs = 1; pairs <= 4; pairs *= 2) {
+    bench_contention(items, pairs, 0, true);
+    bench_contention(items, pairs, 1, false);
+    bench_contention(items, pairs, 16, false);
+  }
+  destroy_node(node);
+  free(items);
+  bench_traversal();
+  return 0;
+}
@@ -0,0 +1,212 @@
+#include "bench.h"
+#include "node.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_NODES (1 << 19)
+#define EDGES_PER_NODE 2
+
+static long bfs_count;
+
+static void count_node(Node *node) {
+  (void)node;
+  bfs_count++;
+}
+
+// Random recursive tree plus random directed edges, built from malloc'd
+// nodes or from an arena
+static void bench_build(bool use_arena) {
+  const char *kind = use_arena ? "arena" : "malloc";
+  uint64_t state = 11;
+  Node **nodes = malloc(NUM_NODES * sizeof(Node *));
+  GraphArena *arena = use_arena ? arena_create(NUM_NODES) : NULL;
+  char name[64];
+
+  BenchWindow start = bench_begin();
+  for (int i = 0; i < NUM_NODES; i++) {
+    nodes[i] = use_arena ? arena_create_node(arena, NULL, (double)i)
+                         : create_node(NULL, (double)i);
+    if (i)
+      add_child(nodes[bench_rand(&state) % i], nodes[i]);
+  }
+  for (int i = 0; i < NUM_NODES; i++) {
+    for (int j = 0; j < EDGES_PER_NODE; j++)
+      add_edge(nodes[i], nodes[bench_rand(&state) % NUM_NODES], true, false);
+  }
+  snprintf(name, sizeof(name), "node/build/%s", kind);
+  bench_report(name, NUM_NODES, bench_end(start));
+
+  bfs_count = 0;
+  start = bench_begin();
+  bfs(nodes[0], count_node);
+  snprintf(name, sizeof(name), "node/bfs/%s", kind);
+  bench_report(name, bfs_count, bench_end(start));
+
+  start = bench_begin();
+  if (use_arena) {
+    arena_destroy(arena);
+  } else {
+    for (int i = 0; i < NUM_NODES; i++)
+      destroy_node(nodes[i]);
+  }
+  snprintf(name, sizeof(name), "node/destroy/%s", kind);
+  bench_report(name, NUM_NODES, bench_end(start));
+  free(nodes);
+}
+
+// Metric polling on a large tree that keeps growing: every round adds a
+// leaf, then reads height, size and diameter of the root
+static void bench_poll_metrics(void) {
+  uint64_t state = 13;
+  GraphArena *arena = arena_create(NUM_NODES);
+  Node **nodes = malloc(NUM_NODES * sizeof(Node *));
+  for (int i = 0; i < NUM_NODES; i++) {
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+    if (i)
+      add_child(nodes[bench_rand(&state) % i], nodes[i]);
+  }
+
+  BenchWindow start = bench_begin();
+  long checksum = height(nodes[0]) + num_nodes(nodes[0]) + diameter(nodes[0]);
+  bench_report("node/metrics/first_poll", 1, bench_end(start));
+
+  int rounds = 100000;
+  start = bench_begin();
+  for (int i = 0; i < rounds; i++) {
+    Node *leaf = arena_create_node(arena, NULL, -1.0);
+    add_child(nodes[bench_rand(&state) % NUM_NODES], leaf);
+    checksum += height(nodes[0]) + num_nodes(nodes[0]) + diameter(nodes[0]);
+  }
+  bench_report("node/metrics/insert_then_poll", rounds,
+               bench_end(start));
+  if (checksum == 42)
+    printf("\n");
+
+  arena_destroy(arena);
+  free(nodes);
+}
+
+// Parent of node i > 0 in the tree shape that stands for each workload:
+// a complete binary tree for sorted, a random recursive tree, a hub-heavy
+// tree whose parents are drawn from Zipf ranks, and a path as the
+// adversarial case for anything that walks depth-first
+static int shape_parent(BenchWorkload workload, int i, BenchZipf *zipf,
+                        uint64_t *state) {
+  switch (workload) {
+  case BENCH_SORTED:
+    return (i - 1) / 2;
+  case BENCH_RANDOM:
+    return (int)(bench_rand(state) % (uint64_t)i);
+  case BENCH_ZIPF:
+    return bench_zipf_next(zipf, state) % i;
+  default:
+    return i - 1;
+  }
+}
+
+static void bench_traversals(BenchWorkload workload, int n) {
+  uint64_t state = 5;
+  BenchZipf zipf = bench_zipf_create(n, 1.0);
+  GraphArena *arena = arena_create(n);
+  Node **nodes = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++) {
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+    if (i)
+      add_child(nodes[shape_parent(workload, i, &zipf, &state)], nodes[i]);
+  }
+  int reps = (1 << 20) / n > 0 ? (1 << 20) / n : 1;
+  const char *shape = bench_workload_name(workload);
+  long checksum = 0;
+  char name[64];
+
+  bfs_count = 0;
+  BenchWindow start = bench_begin();
+  for (int r = 0; r < reps; r++)
+    bfs(nodes[0], count_node);
+  snprintf(name, sizeof(name), "node/bfs/%s/n%d", shape, n);
+  bench_report(name, bfs_count, bench_end(start));
+
+  bfs_count = 0;
+  start = bench_begin();
+  for (int r = 0; r < reps; r++)
+    dfs(nodes[0], count_node);
+  snprintf(name, sizeof(name), "node/dfs/%s/n%d", shape, n);
+  bench_report(name, bfs_count, bench_end(start));
+
+  // Full recomputation: every node dirty again, deepest first so each
+  // node_invalidate stops at the previous one's path
+  start = bench_begin();
+  for (int r = 0; r < reps; r++) {
+    for (int i = n - 1; i >= 0; i--)
+      node_invalidate(nodes[i]);
+    checksum += height(nodes[0]);
+  }
+  snprintf(name, sizeof(name), "node/height/%s/n%d", shape, n);
+  bench_report(name, (long)reps * n, bench_end(start));
+  if (checksum == 42)
+    printf("\n");
+
+  bench_zipf_destroy(&zipf);
+  arena_destroy(arena);
+  free(nodes);
+}
+
+// Hub-heavy batch with repeats: add_edge per edge against one add_edges
+static void bench_bulk_edges(void) {
+  int count = 1 << 16;
+  size_t edges = 1 << 22;
+  uint64_t state = 21;
+  BenchZipf zipf = bench_zipf_create(count, 1.0);
+  GraphArena *arena = arena_create(2 * count);
+  Node **a = malloc(count * sizeof(Node *));
+  Node **b = malloc(count * sizeof(Node *));
+  Node **src = malloc(edges * sizeof(Node *));
+  Node **dst = malloc(edges * sizeof(Node *));
+  for (int i = 0; i < count; i++) {
+    a[i] = arena_create_node(arena, NULL, (double)i);
+    b[i] = arena_create_node(arena, NULL, (double)i);
+  }
+  int *from = malloc(edges * sizeof(int));
+  int *to = malloc(edges * sizeof(int));
+  for (size_t i = 0; i < edges; i++) {
+    from[i] = bench_zipf_next(&zipf, &state);
+    to[i] = (int)(bench_rand(&state) % (uint64_t)count);
+  }
+
+  BenchWindow start = bench_begin();
+  for (size_t i = 0; i < edges; i++)
+    add_edge(a[from[i]], a[to[i]], true, false);
+  bench_report("node/edges/add_edge", (long)edges, bench_end(start));
+
+  start = bench_begin();
+  for (size_t i = 0; i < edges; i++) {
+    src[i] = b[from[i]];
+    dst[i] = b[to[i]];
+  }
+  add_edges(src, dst, edges, true, false);
+  bench_report("node/edges/add_edges", (long)edges, bench_end(start));
+  if (a[0]->edges->size != b[0]->edges->size)
+    printf("mismatch\n");
+
+  bench_zipf_destroy(&zipf);
+  arena_destroy(arena);
+  free(a);
+  free(b);
+  free(src);
+  free(dst);
+  free(from);
+  free(to);
+}
+
+int main() {
+  bench_build(false);
+  bench_build(true);
+  bench_poll_metrics();
+  int sizes[] = {1 << 10, 1 << 14, 1 << 18};
+  for (int s = 0; s < 3; s++) {
+    for (int w = 0; w < BENCH_WORKLOADS; w++)
+      bench_traversals((BenchWorkload)w, sizes[s]);
+  }
+  bench_bulk_edges();
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "bench.h"
+#include "par_bfs.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SCALE 17
+#define EDGE_FACTOR 16
+#define NUM_SOURCES 4
+
+// R-MAT edge generator with the Graph500 quadrant probabilities; yields a
+// power-law degree distribution with a few very large hubs
+static void rmat_edge(uint64_t *state, int scale, int *from, int *to) {
+  int u = 0, v = 0;
+  for (int bit = 0; bit < scale; bit++) {
+    double r = (double)(bench_rand(state) >> 11) / 9007199254740992.0;
+    if (r < 0.57) {
+    } else if (r < 0.76) {
+      v |= 1 << bit;
+    } else if (r < 0.95) {
+      u |= 1 << bit;
+    } else {
+      u |= 1 << bit;
+      v |= 1 << bit;
+    }
+  }
+  *from = u;
+  *to = v;
+}
+
+int main() {
+  int n = 1 << SCALE;
+  uint64_t state = 42;
+  Node **nodes = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  for (long i = 0; i < (long)n * EDGE_FACTOR; i++) {
+    int u, v;
+    rmat_edge(&state, SCALE, &u, &v);
+    add_edge(nodes[u], nodes[v], true, false);
+  }
+  // Undo the vertex ordering R-MAT leaves behind (hubs at low indices)
+  int *order = malloc(n * sizeof(int));
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+  bench_shuffle(order, n, &state);
+  Node **shuffled = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++)
+    shuffled[i] = nodes[order[i]];
+  CSRGraph *graph = csr_freeze(shuffled, n);
+
+  uint32_t sources[NUM_SOURCES];
+  for (int i = 0; i < NUM_SOURCES; i++) {
+    do {
+      sources[i] = (uint32_t)(bench_rand(&state) % n);
+    } while (csr_degree(graph, CSR_OUTGOING, sources[i]) == 0);
+  }
+
+  int32_t *dist = malloc(n * sizeof(int32_t));
+  uint32_t *parent = malloc(n * sizeof(uint32_t));
+  int max_threads = parallel_default_threads();
+  if (max_threads < 8)
+    max_threads = 8;
+  // ops are traversed edges (out-degree sum of reached nodes), so ops/s is
+  // TEPS
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    long edges = 0;
+    BenchWindow total = {0, 0, 0};
+    for (int i = 0; i < NUM_SOURCES; i++) {
+      BenchWindow start = bench_begin();
+      par_bfs(graph, sources[i], threads, dist, parent);
+      bench_accumulate(&total, bench_end(start));
+      for (int j = 0; j < n; j++) {
+        if (dist[j] >= 0)
+          edges += (long)csr_degree(graph, CSR_OUTGOING, j);
+      }
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "par_bfs/rmat%d/threads=%d", SCALE, threads);
+    bench_report(name, edges, total);
+  }
+
+  free(dist);
+  free(parent);
+  csr_destroy(graph);
+  for (int i = 0; i < n; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  free(shuffled);
+  free(order);
+  return 0;
+}
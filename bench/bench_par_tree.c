@@ -0,0 +1,73 @@
+#include "bench.h"
+#include "par_tree.h"
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_NODES (1 << 20)
+#define REPEATS 5
+
+typedef enum { SHAPE_WIDE, SHAPE_DEEP } Shape;
+
+static const char *shape_names[] = {"wide", "deep"};
+
+// wide: random recursive tree (depth ~ ln n, many independent subtrees).
+// deep: a caterpillar, a spine of n/2 nodes each with one leaf, which has
+// almost no parallelism to find.
+static Node **build(Shape shape, GraphArena *arena) {
+  uint64_t state = 17;
+  Node **nodes = malloc(NUM_NODES * sizeof(Node *));
+  for (int i = 0; i < NUM_NODES; i++) {
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+    if (i == 0)
+      continue;
+    if (shape == SHAPE_WIDE)
+      add_child(nodes[bench_rand(&state) % i], nodes[i]);
+    else
+      add_child(nodes[(i - 1) & ~1], nodes[i]);
+  }
+  return nodes;
+}
+
+static void bench_shape(Shape shape, int max_threads) {
+  GraphArena *arena = arena_create(NUM_NODES);
+  Node **nodes = build(shape, arena);
+  char name[64];
+  TreeStats stats;
+  long checksum = 0;
+
+  BenchWindow start = bench_begin();
+  for (int r = 0; r < REPEATS; r++) {
+    par_tree_stats(NULL, nodes[0], &stats);
+    checksum += stats.diameter;
+  }
+  snprintf(name, sizeof(name), "par_tree/%s/serial", shape_names[shape]);
+  bench_report(name, (long)REPEATS * NUM_NODES, bench_end(start));
+
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    TaskPool *pool = taskpool_create(threads);
+    start = bench_begin();
+    for (int r = 0; r < REPEATS; r++) {
+      par_tree_stats(pool, nodes[0], &stats);
+      checksum += stats.diameter;
+    }
+    snprintf(name, sizeof(name), "par_tree/%s/threads=%d", shape_names[shape],
+             threads);
+    bench_report(name, (long)REPEATS * NUM_NODES, bench_end(start));
+    taskpool_destroy(pool);
+  }
+  if (checksum == 42)
+    printf("\n");
+
+  arena_destroy(arena);
+  free(nodes);
+}
+
+int main() {
+  int max_threads = parallel_default_threads();
+  if (max_threads < 4)
+    max_threads = 4;
+  bench_shape(SHAPE_WIDE, max_threads);
+  bench_shape(SHAPE_DEEP, max_threads);
+  return 0;
+}
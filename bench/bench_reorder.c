@@ -0,0 +1,121 @@
+#include "bench.h"
+#include "reorder.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TREE_NODES (1 << 20)
+#define GRID_SIDE 512
+#define REPEATS 3
+
+static double visited_sum;
+
+static void accumulate(Node *node) { visited_sum += node->node_id; }
+
+// Sums every node's neighbor ids along edges, in node list order
+static double sweep_edges(Node **nodes, size_t count) {
+  double sum = 0;
+  for (size_t i = 0; i < count; i++) {
+    NodeSet *edges = nodes[i]->edges;
+    for (size_t j = 0; j < edges->size; j++)
+      sum += edges->nodes[j]->node_id;
+  }
+  return sum;
+}
+
+static void bench_tree(const char *label, Node *root) {
+  char name[64];
+  BenchWindow start = bench_begin();
+  for (int r = 0; r < REPEATS; r++)
+    bfs(root, accumulate);
+  snprintf(name, sizeof(name), "reorder/tree/%s/bfs", label);
+  bench_report(name, (long)REPEATS * TREE_NODES, bench_end(start));
+  start = bench_begin();
+  for (int r = 0; r < REPEATS; r++)
+    dfs(root, accumulate);
+  snprintf(name, sizeof(name), "reorder/tree/%s/dfs", label);
+  bench_report(name, (long)REPEATS * TREE_NODES, bench_end(start));
+}
+
+static void bench_grid(const char *label, Node **nodes) {
+  char name[64];
+  size_t count = GRID_SIDE * GRID_SIDE;
+  BenchWindow start = bench_begin();
+  for (int r = 0; r < REPEATS; r++)
+    visited_sum += sweep_edges(nodes, count);
+  snprintf(name, sizeof(name), "reorder/grid/%s/edge_sweep", label);
+  bench_report(name, (long)REPEATS * count, bench_end(start));
+}
+
+static const char *method_names[] = {"bfs", "rcm", "degree"};
+
+int main() {
+  uint64_t state = 5;
+  // Tree: nodes are created in an order unrelated to the tree shape, as
+  // when a tree is assembled from an unordered stream
+  Node **nodes = malloc(TREE_NODES * sizeof(Node *));
+  int *shuffle = malloc(TREE_NODES * sizeof(int));
+  for (int i = 0; i < TREE_NODES; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    shuffle[i] = i;
+  }
+  bench_shuffle(shuffle, TREE_NODES, &state);
+  for (int i = 1; i < TREE_NODES; i++)
+    add_child(nodes[shuffle[bench_rand(&state) % i]], nodes[shuffle[i]]);
+  Node *root = nodes[shuffle[0]];
+  bench_tree("malloc", root);
+
+  Node **moved = malloc(TREE_NODES * sizeof(Node *));
+  GraphArena *previous = NULL;
+  for (int method = REORDER_BFS; method <= REORDER_DEGREE; method++) {
+    BenchWindow start = bench_begin();
+    GraphArena *arena =
+        reorder_nodes(nodes, TREE_NODES, (ReorderMethod)method, moved);
+    char name[64];
+    snprintf(name, sizeof(name), "reorder/tree/%s/relocate",
+             method_names[method]);
+    bench_report(name, TREE_NODES, bench_end(start));
+    arena_destroy(previous);
+    previous = arena;
+    for (int i = 0; i < TREE_NODES; i++) {
+      nodes[i] = moved[i];
+      if (!moved[i]->parent)
+        root = moved[i];
+    }
+    bench_tree(method_names[method], root);
+  }
+  arena_destroy(previous);
+
+  // Grid: a road-like mesh whose nodes were created in shuffled order
+  int count = GRID_SIDE * GRID_SIDE;
+  Node **grid = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++)
+    shuffle[i] = i;
+  bench_shuffle(shuffle, count, &state);
+  for (int i = 0; i < count; i++)
+    grid[shuffle[i]] = create_node(NULL, (double)shuffle[i]);
+  for (int i = 0; i < count; i++) {
+    if (i % GRID_SIDE + 1 < GRID_SIDE)
+      add_edge(grid[i], grid[i + 1], false, true);
+    if (i + GRID_SIDE < count)
+      add_edge(grid[i], grid[i + GRID_SIDE], false, true);
+  }
+  bench_grid("malloc", grid);
+  previous = NULL;
+  for (int method = REORDER_BFS; method <= REORDER_DEGREE; method++) {
+    GraphArena *arena =
+        reorder_nodes(grid, count, (ReorderMethod)method, moved);
+    arena_destroy(previous);
+    previous = arena;
+    for (int i = 0; i < count; i++)
+      grid[i] = moved[i];
+    bench_grid(method_names[method], grid);
+  }
+  arena_destroy(previous);
+  printf("  (checksum %.0f)\n", visited_sum);
+
+  free(nodes);
+  free(moved);
+  free(shuffle);
+  free(grid);
+  return 0;
+}
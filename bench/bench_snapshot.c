@@ -0,0 +1,85 @@
+#include "bench.h"
+#include "snapshot.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define NUM_NODES (1 << 19)
+#define EDGES_PER_NODE 8
+
+static bool encode_id(FILE *out, void *value, void *ctx) {
+  (void)ctx;
+  return fwrite(value, sizeof(int), 1, out) == 1;
+}
+
+static void *decode_id(const void *data, size_t size, void *ctx) {
+  (void)size;
+  (void)ctx;
+  return (void *)data;
+}
+
+static void count_visit(uint32_t node, void *ctx) {
+  (void)node;
+  (*(long *)ctx)++;
+}
+
+// The warm-up a restart pays without a snapshot: every node and edge
+// inserted again from the source data
+static Graph *build_graph(int *values) {
+  uint64_t state = 5;
+  Graph *graph = graph_create(NUM_NODES);
+  for (int i = 0; i < NUM_NODES; i++) {
+    values[i] = i;
+    graph_add_node(graph, &values[i], (double)i);
+  }
+  Node **nodes = graph->nodes;
+  for (int i = 0; i < NUM_NODES; i++) {
+    for (int j = 0; j < EDGES_PER_NODE; j++)
+      add_weighted_edge(nodes[i], nodes[bench_rand(&state) % NUM_NODES],
+                        (uint32_t)(bench_rand(&state) % 100), true, false);
+    if (i > 0)
+      add_child(nodes[bench_rand(&state) % (uint64_t)i], nodes[i]);
+  }
+  return graph;
+}
+
+int main() {
+  char path[] = "/tmp/bench_snapshotXXXXXX";
+  close(mkstemp(path));
+  int *values = malloc(NUM_NODES * sizeof(int));
+  long checksum = 0;
+
+  BenchWindow start = bench_begin();
+  Graph *graph = build_graph(values);
+  bench_report("snapshot/rebuild_add_edge", NUM_NODES, bench_end(start));
+
+  start = bench_begin();
+  snapshot_write(path, graph->nodes, graph->num_nodes, encode_id, NULL);
+  bench_report("snapshot/write", NUM_NODES, bench_end(start));
+  graph_destroy(graph);
+
+  // The file is still in the page cache, as after a quick restart
+  start = bench_begin();
+  Snapshot *snapshot = snapshot_open(path);
+  bench_report("snapshot/open", 1, bench_end(start));
+
+  start = bench_begin();
+  csr_bfs(&snapshot->graph, 0, count_visit, &checksum);
+  bench_report("snapshot/first_tree_bfs", NUM_NODES, bench_end(start));
+
+  start = bench_begin();
+  checksum += snapshot_validate(snapshot);
+  bench_report("snapshot/validate", NUM_NODES, bench_end(start));
+
+  start = bench_begin();
+  Graph *thawed = snapshot_to_graph(snapshot, decode_id, NULL);
+  bench_report("snapshot/to_graph", NUM_NODES, bench_end(start));
+  checksum += *(int *)thawed->nodes[NUM_NODES - 1]->value;
+  graph_destroy(thawed);
+
+  snapshot_close(snapshot);
+  unlink(path);
+  free(values);
+  printf("checksum %ld\n", checksum);
+  return 0;
+}
@@ -0,0 +1,189 @@
+#include "bench.h"
+#include "sssp.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define GRID_SIDE 512
+#define RMAT_SCALE 17
+#define RMAT_EDGE_FACTOR 8
+#define NUM_SOURCES 4
+#define NUM_PAIRS 64
+
+// Same R-MAT generator as bench_par_bfs
+static void rmat_edge(uint64_t *state, int scale, int *from, int *to) {
+  int u = 0, v = 0;
+  for (int bit = 0; bit < scale; bit++) {
+    double r = (double)(bench_rand(state) >> 11) / 9007199254740992.0;
+    if (r < 0.57) {
+    } else if (r < 0.76) {
+      v |= 1 << bit;
+    } else if (r < 0.95) {
+      u |= 1 << bit;
+    } else {
+      u |= 1 << bit;
+      v |= 1 << bit;
+    }
+  }
+  *from = u;
+  *to = v;
+}
+
+// Binary heap Dijkstra with lazy deletion, the textbook baseline
+typedef struct {
+  uint64_t key;
+  uint32_t node;
+} Entry;
+
+static void binary_dijkstra(const CSRGraph *graph, CSRKind kind,
+                            uint32_t source, uint64_t *dist, Entry *heap) {
+  for (size_t i = 0; i < graph->num_nodes; i++)
+    dist[i] = SSSP_INF;
+  size_t size = 0;
+  dist[source] = 0;
+  heap[size++] = (Entry){0, source};
+  while (size) {
+    Entry top = heap[0];
+    Entry last = heap[--size];
+    size_t i = 0;
+    for (size_t child = 1; child < size; child = 2 * i + 1) {
+      if (child + 1 < size && heap[child + 1].key < heap[child].key)
+        child++;
+      if (last.key <= heap[child].key)
+        break;
+      heap[i] = heap[child];
+      i = child;
+    }
+    heap[i] = last;
+    if (top.key != dist[top.node])
+      continue;
+    const uint32_t *neighbors = csr_neighbors(graph, kind, top.node);
+    const uint32_t *weights = csr_weights(graph, kind, top.node);
+    for (size_t j = 0; j < csr_degree(graph, kind, top.node); j++) {
+      uint32_t v = neighbors[j];
+      uint64_t d = top.key + (weights ? weights[j] : 1);
+      if (d >= dist[v])
+        continue;
+      dist[v] = d;
+      size_t k = size++;
+      for (; k > 0 && heap[(k - 1) / 2].key > d; k = (k - 1) / 2)
+        heap[k] = heap[(k - 1) / 2];
+      heap[k] = (Entry){d, v};
+    }
+  }
+}
+
+static void bench_graph(const char *name, CSRGraph *graph, CSRKind kind,
+                        uint64_t *state) {
+  size_t n = graph->num_nodes;
+  uint64_t *dist = malloc(n * sizeof(uint64_t));
+  uint32_t *parent = malloc(n * sizeof(uint32_t));
+  uint32_t *path = malloc(n * sizeof(uint32_t));
+  size_t edges = graph->offsets[kind][n];
+  Entry *heap = malloc((edges + 1) * sizeof(Entry));
+  uint32_t sources[NUM_SOURCES];
+  for (int i = 0; i < NUM_SOURCES; i++) {
+    do {
+      sources[i] = (uint32_t)(bench_rand(state) % n);
+    } while (csr_degree(graph, kind, sources[i]) == 0);
+  }
+  char label[64];
+  uint64_t checksum = 0;
+
+  BenchWindow start = bench_begin();
+  for (int i = 0; i < NUM_SOURCES; i++) {
+    binary_dijkstra(graph, kind, sources[i], dist, heap);
+    checksum += dist[n / 2];
+  }
+  snprintf(label, sizeof(label), "sssp/%s/binary_heap", name);
+  bench_report(label, (long)NUM_SOURCES * n, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_SOURCES; i++) {
+    sssp_dijkstra(graph, kind, sources[i], dist, parent);
+    checksum -= dist[n / 2];
+  }
+  snprintf(label, sizeof(label), "sssp/%s/radix_heap", name);
+  bench_report(label, (long)NUM_SOURCES * n, bench_end(start));
+
+  // Point to point: one full Dijkstra per query against the bidirectional
+  // search; ops are queries
+  uint32_t pairs[NUM_PAIRS][2];
+  for (int i = 0; i < NUM_PAIRS; i++) {
+    pairs[i][0] = sources[i % NUM_SOURCES];
+    pairs[i][1] = (uint32_t)(bench_rand(state) % n);
+  }
+  start = bench_begin();
+  for (int i = 0; i < NUM_PAIRS / 8; i++) {
+    sssp_dijkstra(graph, kind, pairs[i][0], dist, NULL);
+    checksum += dist[pairs[i][1]];
+  }
+  snprintf(label, sizeof(label), "sssp/%s/p2p_full", name);
+  bench_report(label, NUM_PAIRS / 8, bench_end(start));
+
+  SSSPSearch *search = sssp_search_create(graph, kind);
+  start = bench_begin();
+  for (int i = 0; i < NUM_PAIRS; i++) {
+    size_t len;
+    uint64_t d = sssp_search_path(search, pairs[i][0], pairs[i][1], path, &len);
+    if (i < NUM_PAIRS / 8)
+      checksum -= d;
+  }
+  snprintf(label, sizeof(label), "sssp/%s/p2p_bidirectional", name);
+  bench_report(label, NUM_PAIRS, bench_end(start));
+  // Both halves of the checksum cancel when the engines agree
+  printf("  (checksum %llu)\n", (unsigned long long)checksum);
+
+  sssp_search_destroy(search);
+  free(dist);
+  free(parent);
+  free(path);
+  free(heap);
+}
+
+int main() {
+  uint64_t state = 7;
+
+  // Road-like: a grid with bidirectional streets of varying length
+  int n = GRID_SIDE * GRID_SIDE;
+  GraphArena *arena = arena_create(n);
+  Node **nodes = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++)
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+  for (int y = 0; y < GRID_SIDE; y++) {
+    for (int x = 0; x < GRID_SIDE; x++) {
+      int i = y * GRID_SIDE + x;
+      if (x + 1 < GRID_SIDE)
+        add_weighted_edge(nodes[i], nodes[i + 1],
+                          1 + (uint32_t)(bench_rand(&state) % 1000), false,
+                          true);
+      if (y + 1 < GRID_SIDE)
+        add_weighted_edge(nodes[i], nodes[i + GRID_SIDE],
+                          1 + (uint32_t)(bench_rand(&state) % 1000), false,
+                          true);
+    }
+  }
+  CSRGraph *graph = csr_freeze(nodes, n);
+  bench_graph("grid512", graph, CSR_EDGES, &state);
+  csr_destroy(graph);
+  arena_destroy(arena);
+  free(nodes);
+
+  // Power-law: R-MAT with random arc weights
+  n = 1 << RMAT_SCALE;
+  arena = arena_create(n);
+  nodes = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++)
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+  for (long i = 0; i < (long)n * RMAT_EDGE_FACTOR; i++) {
+    int u, v;
+    rmat_edge(&state, RMAT_SCALE, &u, &v);
+    add_weighted_edge(nodes[u], nodes[v],
+                      1 + (uint32_t)(bench_rand(&state) % 255), true, false);
+  }
+  graph = csr_freeze(nodes, n);
+  bench_graph("rmat17", graph, CSR_OUTGOING, &state);
+  csr_destroy(graph);
+  arena_destroy(arena);
+  free(nodes);
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include "bench.h"
+#include "subtree.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_NODES (1 << 20)
+#define NUM_OPS (1 << 20)
+#define NAIVE_OPS (1 << 10)
+
+static double naive_sum(Node *node) {
+  double sum = subtree_project_double(node, NULL);
+  for (size_t i = 0; i < nodeset_size(node->children); i++)
+    sum += naive_sum(node->children->nodes[i]);
+  return sum;
+}
+
+int main() {
+  GraphArena *arena = arena_create(NUM_NODES);
+  Node **nodes = malloc(NUM_NODES * sizeof(Node *));
+  double *values = malloc(NUM_NODES * sizeof(double));
+  uint64_t state = 31;
+  for (int i = 0; i < NUM_NODES; i++) {
+    values[i] = (double)(bench_rand(&state) % 100);
+    nodes[i] = arena_create_node(arena, &values[i], (double)i);
+    if (i > 0)
+      add_child(nodes[bench_rand(&state) % i], nodes[i]);
+  }
+  // Queries lean toward the top of the tree, where subtrees are large
+  Node **targets = malloc(NUM_OPS * sizeof(Node *));
+  for (int i = 0; i < NUM_OPS; i++) {
+    uint64_t r = bench_rand(&state);
+    targets[i] = nodes[(r % NUM_NODES) >> (r >> 60)];
+  }
+  double checksum = 0.0;
+
+  BenchWindow start = bench_begin();
+  SubtreeIndex *index = subtree_create(nodes[0], subtree_project_double, NULL);
+  bench_report("subtree/build", NUM_NODES, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NAIVE_OPS; i++)
+    checksum += naive_sum(targets[i]);
+  bench_report("subtree/naive_sum", NAIVE_OPS, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_OPS; i++)
+    checksum += subtree_sum(index, targets[i]);
+  bench_report("subtree/sum", NUM_OPS, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_OPS; i++)
+    checksum += subtree_max(index, targets[i]);
+  bench_report("subtree/max", NUM_OPS, bench_end(start));
+
+  start = bench_begin();
+  for (int i = 0; i < NUM_OPS; i++) {
+    Node *node = nodes[bench_rand(&state) % NUM_NODES];
+    subtree_set(index, node, (double)(i % 100));
+  }
+  bench_report("subtree/update", NUM_OPS, bench_end(start));
+
+  // Update then query, the pattern a dfs per query would otherwise serve
+  start = bench_begin();
+  for (int i = 0; i < NUM_OPS; i++) {
+    subtree_set(index, nodes[bench_rand(&state) % NUM_NODES], 1.0);
+    checksum += subtree_sum(index, targets[i]);
+  }
+  bench_report("subtree/update_then_sum", NUM_OPS, bench_end(start));
+
+  printf("  (checksum %.0f)\n", checksum);
+  subtree_destroy(index);
+  arena_destroy(arena);
+  free(targets);
+  free(values);
+  free(nodes);
+  return 0;
+}
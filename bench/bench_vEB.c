@@ -0,0 +1,82 @@
+#include "bench.h"
+#include "vEB.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Query passes are repeated up to about this many operations
+#define QUERY_OPS (1 << 21)
+
+// insert does not expect a key twice, so repeats in the workload are
+// dropped (outside the timed region) and the first occurrences kept
+static int unique_keys(int *keys, int n, int universe) {
+  unsigned char *seen = calloc(universe, 1);
+  int kept = 0;
+  for (int i = 0; i < n; i++) {
+    if (!seen[keys[i]]) {
+      seen[keys[i]] = 1;
+      keys[kept++] = keys[i];
+    }
+  }
+  free(seen);
+  return kept;
+}
+
+// n keys spaced stride apart (at least 2, so key + 1 is always absent)
+static void bench_workload(BenchWorkload workload, int n, int stride) {
+  uint64_t state = 17;
+  int universe = n * stride;
+  int *keys = malloc(n * sizeof(int));
+  int *queries = malloc(n * sizeof(int));
+  bench_keys(workload, keys, n, stride, &state);
+  memcpy(queries, keys, n * sizeof(int));
+  int count = unique_keys(keys, n, universe);
+  int reps = QUERY_OPS / n > 0 ? QUERY_OPS / n : 1;
+  long checksum = 0;
+  char name[64];
+
+  BenchWindow start = bench_begin();
+  vEB *tree = create_vEB(universe);
+  for (int i = 0; i < count; i++)
+    insert(tree, keys[i]);
+  snprintf(name, sizeof(name), "vEB/insert/%s/n%d_u%d",
+           bench_workload_name(workload), n, universe);
+  bench_report(name, count, bench_end(start));
+
+  // Half hits and half misses, in the order of the workload
+  start = bench_begin();
+  for (int r = 0; r < reps; r++) {
+    for (int i = 0; i < n; i++)
+      checksum += isin(tree, queries[i] + (i & 1));
+  }
+  snprintf(name, sizeof(name), "vEB/isin/%s/n%d_u%d",
+           bench_workload_name(workload), n, universe);
+  bench_report(name, (long)reps * n, bench_end(start));
+
+  start = bench_begin();
+  for (int r = 0; r < reps; r++) {
+    for (int i = 0; i < n; i++)
+      checksum += successor(tree, queries[i] + 1);
+  }
+  snprintf(name, sizeof(name), "vEB/successor/%s/n%d_u%d",
+           bench_workload_name(workload), n, universe);
+  bench_report(name, (long)reps * n, bench_end(start));
+
+  if (checksum == 42)
+    printf("\n");
+  free_vEB(tree);
+  free(keys);
+  free(queries);
+}
+
+int main() {
+  // create_vEB splits by the integer square root at every level, so the
+  // universe must be 2^(2^k): 2^8 and 2^16, the latter sparse and dense
+  int sizes[] = {1 << 6, 1 << 10, 1 << 14};
+  int strides[] = {4, 64, 4};
+  for (int s = 0; s < 3; s++) {
+    for (int w = 0; w < BENCH_WORKLOADS; w++)
+      bench_workload((BenchWorkload)w, sizes[s], strides[s]);
+  }
+  return 0;
+}
@@ -1,10 +1,14 @@
 #ifndef BST_H
 #define BST_H
+#include <stdio.h>
 
 typedef struct BSTNode {
   int value;
   struct BSTNode *left;
   struct BSTNode *right;
+  struct BSTNode *parent; // Maintained by every BST operation
+  unsigned int priority; // Heap key for the treap operations
+  int size;              // Number of nodes in this subtree
 } BSTNode;
 
 // Operations
@@ -34,4 +38,40 @@ void delete_node(BST *tree, int value);
 int is_empty(BST *tree);
 void free_tree(BST *tree);
 
+// Treap operations (balanced by node priority, expected O(log n))
+// Priority of a value: a bijective integer hash, so equal inputs always
+// build the same shape and distinct values never tie. The persistent BST
+// uses it too.
+unsigned int bst_priority(int value);
+void bst_treap_insert(BST *tree, int value);
+void bst_treap_delete(BST *tree, int value);
+
+// Splay operations: every access rotates the touched node to the root, so
+// frequently used values stay near the top (amortized O(log n))
+BSTNode *bst_splay_search(BST *tree, int value);
+void bst_splay_insert(BST *tree, int value);
+
+// In-order stepping along parent links: no stack, O(1) amortized per step
+BSTNode *bst_first(BST *tree);
+BSTNode *bst_last(BST *tree);
+BSTNode *bst_next(BSTNode *node);
+BSTNode *bst_prev(BSTNode *node);
+
+// Streaming checkpoint format: sorted values, delta + varint encoded.
+// bst_load replaces the contents of tree with a height-balanced tree built in
+// linear time. Both return 0 on success and -1 on I/O or format errors.
+int bst_dump(BST *tree, FILE *out);
+int bst_load(BST *tree, FILE *in);
+
+// Split and join, O(height)
+// Moves values < pivot into left and values >= pivot into right, emptying
+// tree. left and right may alias tree.
+void bst_split(BST *tree, int pivot, BST *left, BST *right);
+// Appends right to left and empties right. Every value in left must be
+// smaller than every value in right; returns -1 and leaves both trees
+// untouched otherwise.
+int bst_join(BST *left, BST *right);
+// Removes every value in [low, high]
+void bst_delete_range(BST *tree, int low, int high);
+
 #endif
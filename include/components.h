@@ -0,0 +1,31 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+#include "csr.h"
+
+// Connected components over one adjacency kind, ignoring edge direction
+// (CSR_OUTGOING gives weakly connected components). Threads hook trees of
+// a lock-free union-find together with compare-and-swap, always linking the
+// larger root under the smaller, so every component ends up labeled with
+// its smallest node index. component receives num_nodes labels.
+// nthreads <= 0 uses every online processor. Returns the number of
+// components, or 0 on bad arguments or allocation failure.
+size_t par_components(const CSRGraph *graph, CSRKind kind, int nthreads,
+                      uint32_t *component);
+
+typedef struct TopoSortResult {
+  size_t ordered;   // Nodes written to order; num_nodes unless cyclic
+  size_t levels;    // Ready frontiers processed: the longest path in nodes
+  size_t cycle_len; // Nodes written to cycle, 0 if the graph is acyclic
+} TopoSortResult;
+
+// Kahn's topological sort along CSR_OUTGOING. Each frontier of nodes with
+// no remaining predecessors is expanded in parallel, so order lists the
+// frontiers one after another. If the graph has a cycle, the nodes on or
+// behind cycles are left out of order, and cycle (if not NULL, with room
+// for num_nodes entries) receives one cycle in edge direction. nthreads
+// <= 0 uses every online processor; one thread runs a plain serial pass.
+// Returns false on bad arguments or allocation failure.
+bool par_toposort(const CSRGraph *graph, int nthreads, uint32_t *order,
+                  uint32_t *cycle, TopoSortResult *result);
+
+#endif // COMPONENTS_H
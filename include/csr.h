@@ -0,0 +1,67 @@
+#ifndef CSR_H
+#define CSR_H
+#include "node.h"
+#include <stdint.h>
+
+#define CSR_NONE UINT32_MAX
+
+typedef enum {
+  CSR_EDGES,
+  CSR_INCOMING,
+  CSR_OUTGOING,
+  CSR_CHILDREN,
+  CSR_KINDS
+} CSRKind;
+
+// Frozen, read-only compressed sparse row view of a Node graph. Nodes get
+// dense indices; the neighbors of node i for a kind are
+// neighbors[kind][offsets[kind][i] .. offsets[kind][i + 1]). The view does
+// not track later changes to the Node graph. weights[kind] runs parallel to
+// neighbors[kind], or is NULL when every edge of that kind has
+// EDGE_DEFAULT_WEIGHT.
+typedef struct CSRGraph {
+  size_t num_nodes;
+  Node **nodes; // Dense index -> Node
+  double *node_ids;
+  uint32_t *parent; // CSR_NONE for roots and parents outside the view
+  uint64_t *offsets[CSR_KINDS];
+  uint32_t *neighbors[CSR_KINDS];
+  uint32_t *weights[CSR_KINDS];
+  NodeMap *index; // Node -> dense index
+  // Set by csr_freeze when CSR_CHILDREN is a forest: no node listed twice
+  // and no cycles. Tree queries then need no visited marks. Views built
+  // otherwise, like mapped snapshots, leave it false.
+  bool children_forest;
+} CSRGraph;
+
+// Freezes the given nodes in order; neighbors outside the list are dropped
+CSRGraph *csr_freeze(Node **nodes, size_t count);
+// Freezes everything reachable from root through any adjacency set or
+// parent link, numbered in BFS order
+CSRGraph *csr_freeze_from(Node *root);
+void csr_destroy(CSRGraph *graph);
+
+// Dense index of node, or CSR_NONE
+uint32_t csr_index_of(const CSRGraph *graph, Node *node);
+size_t csr_degree(const CSRGraph *graph, CSRKind kind, uint32_t node);
+const uint32_t *csr_neighbors(const CSRGraph *graph, CSRKind kind,
+                              uint32_t node);
+// Weights of csr_neighbors(graph, kind, node), or NULL if kind is unweighted
+const uint32_t *csr_weights(const CSRGraph *graph, CSRKind kind,
+                            uint32_t node);
+
+// Tree queries over CSR_CHILDREN, iterative; visit gets dense indices.
+// Each node is visited and counted once, even if it is listed under
+// several parents or the children sets form a cycle. Over a forest a query
+// costs time and memory in proportion to the subtree it walks; otherwise
+// it also clears one visited mark per node in the view. The walks stop
+// early, and csr_height and csr_num_nodes return -1, if they run out of
+// memory.
+void csr_dfs(const CSRGraph *graph, uint32_t start,
+             void (*visit)(uint32_t, void *), void *ctx);
+void csr_bfs(const CSRGraph *graph, uint32_t start,
+             void (*visit)(uint32_t, void *), void *ctx);
+int csr_height(const CSRGraph *graph, uint32_t root);
+int csr_num_nodes(const CSRGraph *graph, uint32_t root);
+
+#endif // CSR_H
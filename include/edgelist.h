@@ -0,0 +1,40 @@
+#ifndef EDGELIST_H
+#define EDGELIST_H
+#include "graph.h"
+
+// Text edge lists: one edge per line as "u v" or "u v w", fields separated
+// by spaces, tabs or commas. u and v are non-negative integer node ids (at
+// most 2^53, so they survive the trip through a double node_id) and w is an
+// unsigned 32-bit weight. Blank lines and lines starting with '#' or '%'
+// are skipped; both "\n" and "\r\n" line ends are accepted.
+typedef struct EdgeListOptions {
+  bool directed;      // Passed to add_edge for every line
+  bool bidirectional; // Likewise
+  int nthreads;       // <= 0 uses every online processor
+} EdgeListOptions;
+
+typedef struct EdgeListStats {
+  size_t edges;      // Edge lines read
+  size_t duplicates; // Adjacency entries dropped as repeats
+  size_t bad_line;   // First malformed line (1-based), 0 if none
+} EdgeListStats;
+
+// Builds a new Graph holding one node per distinct id, created in
+// ascending id order, with the adjacency that calling add_edge (or
+// add_weighted_edge, once any line carries a weight; lines without one
+// count as EDGE_DEFAULT_WEIGHT) for every line in file order would give.
+// Chunks of the text are parsed in parallel, then each thread builds the
+// sets of its own range of nodes in two passes over the edges: count the
+// entries, then gather them as node indices. Repeats are dropped against a
+// bitmap before each set is reserved at its exact size and filled; only
+// repeated weighted lines go through nodeset_add_weighted.
+// options may be NULL for undirected, one-way edges on every processor.
+// Returns NULL on malformed input (see stats->bad_line), I/O or allocation
+// failure; stats may be NULL.
+Graph *edgelist_parse(const char *data, size_t size,
+                      const EdgeListOptions *options, EdgeListStats *stats);
+// edgelist_parse over the file mapped with mmap
+Graph *edgelist_load(const char *path, const EdgeListOptions *options,
+                     EdgeListStats *stats);
+
+#endif // EDGELIST_H
@@ -0,0 +1,64 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+#include "node.h"
+#include <stdint.h>
+
+// Container that owns its nodes (allocated from one GraphArena) and
+// indexes them by node_id. The index is open addressing with linear
+// probing over the bit patterns of the ids. Each slot keeps the id next to
+// its node, so a lookup costs one cache miss and never touches the nodes it
+// skips, and the node's position in nodes, so removal is O(1) as well. Ids
+// compare like doubles: -0.0 and 0.0 are the same id, and NaN is never a
+// valid id.
+typedef struct GraphSlot {
+  uint64_t key; // Normalized id bits
+  Node *node;   // NULL when the slot is empty
+  size_t index; // Position in Graph.nodes
+} GraphSlot;
+
+typedef struct Graph {
+  GraphArena *arena;
+  Node **nodes; // Insertion order, except where removals moved the last in
+  size_t num_nodes;
+  size_t capacity;
+  GraphSlot *slots;
+  size_t mask;      // Slot count - 1
+  NodeSet *removed; // Tombstones awaiting graph_compact, or NULL
+} Graph;
+
+Graph *graph_create(size_t expected_nodes);
+// Destroys the graph and every node it owns
+void graph_destroy(Graph *graph);
+
+// Creates a node with a new id. Returns NULL if the id is NaN, already
+// taken, or on allocation failure.
+Node *graph_add_node(Graph *graph, void *value, double node_id);
+// Unlinks the node with this id from its neighbors (see unlink_node) and
+// moves the last node into its place in nodes. A one-way add_edge(other,
+// node, false, false) is not visible from node, so the node is kept as a
+// tombstone, with empty sets, until graph_compact clears such entries from
+// every owned node's edges set; only then is its arena slot reused. This
+// runs once the tombstones outnumber an eighth of the nodes, so a removal
+// costs O(degree) amortized. False if the id is absent or on allocation
+// failure.
+bool graph_remove_node(Graph *graph, double node_id);
+// Drops the remaining entries of removed nodes and destroys them now, for
+// callers that walk edges sets and must not meet a tombstone
+void graph_compact(Graph *graph);
+// Returns the node with this id, creating it with a NULL value if needed
+Node *graph_ensure_node(Graph *graph, double node_id);
+Node *graph_find(const Graph *graph, double node_id);
+// Looks up count ids into out (NULL where absent), overlapping the memory
+// accesses of neighboring lookups. Returns the number found.
+size_t graph_find_batch(const Graph *graph, const double *ids, size_t count,
+                        Node **out);
+size_t graph_num_nodes(const Graph *graph);
+// Moves every node into a new arena in the given order (a permutation of
+// graph->nodes) with arena_relocate, updating the node list and index
+bool graph_relocate(Graph *graph, Node **order);
+
+// add_edge between the nodes with ids a and b; false if either is absent
+bool graph_add_edge_by_id(Graph *graph, double a, double b, bool directed,
+                          bool bidirectional);
+
+#endif // GRAPH_H
@@ -0,0 +1,54 @@
+#ifndef LCA_H
+#define LCA_H
+#include "node.h"
+#include <stdint.h>
+
+// Ancestry index over the children tree under a root. Built nodes are
+// numbered in preorder, so "a is an ancestor of b" is an interval check,
+// and a sparse table of depth minima over the preorder answers lowest
+// common ancestor queries in O(1). Nodes attached after the build live in
+// an overlay with binary lifting (O(log n) queries) until the overlay
+// outgrows LCA_REBUILD_FRACTION of the tree, which triggers a full rebuild.
+typedef struct LCAIndex {
+  Node *root;
+  NodeMap *ids; // Node -> id; ids below num_built are preorder positions
+  // Built part, indexed by preorder id
+  size_t num_built;
+  Node **nodes;
+  uint32_t *parent;
+  uint32_t *last; // Last preorder id in the node's subtree
+  int *depth;
+  uint32_t **sparse; // sparse[k][i]: shallowest of ids i .. i + 2^k - 1
+  int levels;
+  // Overlay, indexed by id - num_built
+  size_t num_overlay;
+  size_t overlay_capacity;
+  Node **overlay_nodes;
+  uint32_t *anchor;      // Nearest built ancestor
+  int *overlay_depth;
+  uint32_t *overlay_up;  // LCA_LIFT_LEVELS jumps per node, within the overlay
+} LCAIndex;
+
+#define LCA_LIFT_LEVELS 32
+// Overlay nodes allowed per built node before lca_attach rebuilds
+#define LCA_REBUILD_FRACTION 0.5
+
+LCAIndex *lca_create(Node *root);
+void lca_destroy(LCAIndex *index);
+// Re-indexes the whole tree under the root. Returns false on allocation
+// failure, leaving the index empty.
+bool lca_rebuild(LCAIndex *index);
+// Indexes node and everything under it after add_child attached it below an
+// indexed node. Returns false if node's parent is not indexed or memory
+// runs out.
+bool lca_attach(LCAIndex *index, Node *node);
+
+// Queries return NULL/-1/false for nodes that are not indexed
+Node *lca(const LCAIndex *index, Node *u, Node *v);
+int lca_depth(const LCAIndex *index, Node *node);
+// True if ancestor is node or above it
+bool lca_is_ancestor(const LCAIndex *index, Node *ancestor, Node *node);
+// Edges on the path between u and v
+int lca_distance(const LCAIndex *index, Node *u, Node *v);
+
+#endif // LCA_H
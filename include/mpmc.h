@@ -0,0 +1,47 @@
+#ifndef MPMC_H
+#define MPMC_H
+#include "node.h"
+#include <stdatomic.h>
+
+#define MPMC_CACHE_LINE 64
+
+typedef struct MPMCCell {
+  atomic_size_t sequence;
+  Node *node;
+} MPMCCell;
+
+// Bounded lock-free multi-producer/multi-consumer ring of Node pointers
+// (Dmitry Vyukov's design). Every cell carries a sequence number telling
+// producers and consumers which lap of the ring it is ready for, so a
+// single CAS on the shared position claims a run of cells.
+typedef struct MPMCQueue {
+  MPMCCell *cells;
+  size_t mask; // Capacity - 1, capacity is a power of two
+  _Alignas(MPMC_CACHE_LINE) atomic_size_t enqueue_pos;
+  _Alignas(MPMC_CACHE_LINE) atomic_size_t dequeue_pos;
+} MPMCQueue;
+
+// Capacity is rounded up to a power of two, at least 2
+MPMCQueue *mpmc_create(size_t capacity);
+void mpmc_destroy(MPMCQueue *queue);
+size_t mpmc_capacity(const MPMCQueue *queue);
+// Returns false when the queue is full or node is NULL
+bool mpmc_enqueue(MPMCQueue *queue, Node *node);
+// Returns NULL when the queue is empty
+Node *mpmc_dequeue(MPMCQueue *queue);
+// Enqueue/dequeue up to count nodes with one claim; return how many moved.
+// Batches keep their order and are contiguous in the queue. Enqueued nodes
+// must not be NULL.
+size_t mpmc_enqueue_batch(MPMCQueue *queue, Node *const *nodes, size_t count);
+size_t mpmc_dequeue_batch(MPMCQueue *queue, Node **nodes, size_t count);
+// Snapshot; may be stale as soon as it returns
+size_t mpmc_size(const MPMCQueue *queue);
+
+// Visits every node of the tree under root once, from nthreads threads
+// sharing an MPMCQueue (nthreads <= 0 uses every online processor). Order is
+// unspecified and visit must be thread-safe. Returns the number of visited
+// nodes, 0 if the queue or the threads cannot be set up.
+size_t mpmc_traverse(Node *root, int nthreads, void (*visit)(Node *, void *),
+                     void *ctx);
+
+#endif // MPMC_H
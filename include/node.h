@@ -2,6 +2,7 @@
 #define NODE_H
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef struct Node {
   void *value;
@@ -13,26 +14,86 @@ typedef struct Node {
   // Tree structure
   struct Node *parent;
   struct NodeSet *children;
-
+  // Arena the node was allocated from, NULL for create_node
+  struct GraphArena *arena;
+  // Cached subtree aggregates, valid while aggregates_dirty is false. A
+  // dirty node's ancestors are always dirty too, and so is every node
+  // above a child that is listed under more than one parent.
+  int cached_height;
+  int cached_size;
+  int cached_leaves;
+  int cached_diameter;
+  bool aggregates_dirty;
 } Node;
 
+// Sets up to this size keep their members inside the NodeSet itself
+#define NODESET_INLINE_CAPACITY 4
+// Sets larger than this keep a hash index next to the member array
+#define NODESET_INDEX_THRESHOLD 32
+// Weight of edges added without one
+#define EDGE_DEFAULT_WEIGHT 1
+
+// Members stay in a dense array in insertion order for iteration. Small sets
+// are scanned with SIMD compares; past NODESET_INDEX_THRESHOLD an
+// open-addressing index of member positions makes lookups O(1). A NodeSet
+// points into itself, so it must not be copied by value.
 typedef struct NodeSet {
   Node **nodes;
   size_t size;
   size_t capacity;
+  size_t *index;     // Member position + 1 per slot, 0 when empty
+  size_t index_mask; // Slot count - 1
+  // Per-member edge weights parallel to nodes; NULL while every member
+  // has EDGE_DEFAULT_WEIGHT
+  uint32_t *weights;
+  // Spilled members live in storage owned by the node's arena (see
+  // arena_relocate); growing the set copies them out
+  bool borrowed;
+  Node *inline_nodes[NODESET_INLINE_CAPACITY];
 } NodeSet;
 
+// Growable ring buffer; slots are reused once dequeued
 typedef struct NodeQueue {
   Node **nodes;
-  size_t front;
-  size_t rear;
+  size_t front; // Slot of the oldest node
+  size_t rear;  // Slot the next node goes into
+  size_t size;
   size_t capacity;
 } NodeQueue;
 
-// Node creation and destruction
+// Hash map from Node pointers to dense indices, for building array-based
+// views of a graph
+typedef struct NodeMap {
+  Node **keys;
+  size_t *values;
+  size_t size;
+  size_t mask; // Slot count - 1
+} NodeMap;
+
+// Node creation and destruction. A node and its four sets are one
+// allocation; sets only allocate once they outgrow their inline storage.
 Node *create_node(void *value, double node_id);
 void destroy_node(Node *node);
 
+// Bump allocator for whole graphs: nodes are carved out of large chunks
+// and arena_destroy releases every node it handed out, destroyed or not.
+// destroy_node on an arena node frees its spilled set storage and recycles
+// the slot. Not thread-safe.
+typedef struct GraphArena GraphArena;
+GraphArena *arena_create(size_t expected_nodes);
+Node *arena_create_node(GraphArena *arena, void *value, double node_id);
+// Live (created and not destroyed) nodes
+size_t arena_num_nodes(const GraphArena *arena);
+// Moves count distinct nodes into a new arena: the nodes are laid out in
+// the given order in one contiguous chunk, and their spilled set members
+// in one shared array in the same order. References between the moved
+// nodes (set members and parents) are rewritten; references to other nodes
+// are kept. The old nodes are destroyed, so nothing outside the list may
+// still point at them. relocated[i] receives the new nodes[i]. Returns
+// NULL, leaving every node untouched, on allocation failure.
+GraphArena *arena_relocate(Node **nodes, size_t count, Node **relocated);
+void arena_destroy(GraphArena *arena);
+
 // Node accessors
 void *get_node_value(Node *node);
 Node *get_node_parent(Node *node);
@@ -40,9 +101,43 @@ NodeSet *get_node_children(Node *node);
 
 // Graph operations
 void add_edge(Node *self, Node *other, bool directed, bool bidirectional);
+// Same result as add_edge(src[i], dst[i], directed, bidirectional) for
+// every i in order, for large batches: each touched set is grown once to
+// its exact size, appended to without membership tests, and deduplicated
+// in one pass at the end (nodeset_dedup), so the cost is linear in count
+// plus the sizes of the touched sets. NULL entries are skipped. Returns
+// false, with no set changed, on allocation failure.
+bool add_edges(Node **src, Node **dst, size_t count, bool directed,
+               bool bidirectional);
+// Like add_edge, and stores weight with every adjacency entry it creates.
+// Adding an existing edge again overwrites its weight.
+void add_weighted_edge(Node *self, Node *other, uint32_t weight, bool directed,
+                       bool bidirectional);
+// Weight of the edge from self to other in self->edges; false if absent
+bool get_edge_weight(Node *self, Node *other, uint32_t *weight);
 void add_child(Node *self, Node *child);
+// Undoes add_edge with the same flags. Entries are swap-removed, O(1) in
+// indexed sets, so the last member of each set takes the removed one's
+// place.
+void remove_edge(Node *self, Node *other, bool directed, bool bidirectional);
+// Detaches child if self is its parent. Swap-removes like remove_edge, so
+// detaching every child of a large parent stays linear.
+void remove_child(Node *self, Node *child);
+// Removes node from every neighbor it can reach through its own sets (edges,
+// incoming, outgoing, children and parent) in O(degree), then empties its
+// sets. An entry made by a one-way add_edge(other, node, false, false) is
+// not visible from node and stays behind; graph_remove_node also clears
+// those. destroy_node does not unlink, so call this first on a node that
+// others still point at.
+void unlink_node(Node *node);
 
-// Tree properties
+// Tree properties. height, num_leaves, num_nodes and diameter are cached
+// per node: add_child marks the parent chain dirty and a query recomputes
+// only the dirty part of the subtree, so polling an unchanged tree is O(1).
+// A child added under a second parent is only reachable upwards through
+// its last parent, so the nodes above it are recomputed on every query.
+// Queries update the cache, so they must not run concurrently. They return
+// -1 if the recomputation runs out of memory.
 bool is_root(Node *node);
 bool is_leaf(Node *node);
 int height(Node *node);
@@ -50,6 +145,9 @@ int depth(Node *node);
 int num_leaves(Node *node);
 int num_nodes(Node *node);
 int diameter(Node *node);
+// Marks node and its ancestors dirty; needed only after changing a
+// children set without add_child
+void node_invalidate(Node *node);
 
 // Traversal with callbacks
 void dfs(Node *start, void (*result)(Node *));
@@ -57,6 +155,27 @@ void bfs(Node *start, void (*result)(Node *));
 void preorder(Node *node, void (*result)(Node *));
 void postorder(Node *node, void (*result)(Node *));
 
+// Visitor-driven traversals over children, iterative so deep trees are
+// safe. The visitor's result steers the walk: VISIT_SKIP leaves out the
+// node's subtree (it has no effect in postorder, where the subtree has
+// already been visited) and VISIT_STOP ends the walk. They return true if
+// the visitor stopped the walk; the walk also ends early, returning false,
+// if its stack or queue cannot grow.
+typedef enum { VISIT_CONTINUE, VISIT_SKIP, VISIT_STOP } VisitResult;
+typedef VisitResult (*NodeVisitor)(Node *node, void *ctx);
+bool dfs_visit(Node *start, NodeVisitor visit, void *ctx);
+bool bfs_visit(Node *start, NodeVisitor visit, void *ctx);
+bool preorder_visit(Node *node, NodeVisitor visit, void *ctx);
+bool postorder_visit(Node *node, NodeVisitor visit, void *ctx);
+
+// Numbers the children tree under root in preorder, children in order, for
+// indexes that turn subtrees into id ranges: nodes[id] is the node with
+// that id, parent[id] its parent's id (UINT32_MAX for root), last[id] the
+// last id in its subtree, and ids maps each node to its id. At most
+// capacity nodes are numbered. Returns the count, 0 on allocation failure.
+size_t preorder_flatten(Node *root, size_t capacity, Node **nodes,
+                        uint32_t *parent, uint32_t *last, NodeMap *ids);
+
 // Comparison function for integers
 int compare_ints(const void *a, const void *b);
 
@@ -65,10 +184,32 @@ NodeSet *nodeset_create(size_t initial_capacity);
 void nodeset_destroy(NodeSet *set);
 bool nodeset_contains(NodeSet *set, Node *node);
 void nodeset_add(NodeSet *set, Node *node);
+// Adds node with a weight, or updates the weight of an existing member
+void nodeset_add_weighted(NodeSet *set, Node *node, uint32_t weight);
+// Weight of the member at position i
+uint32_t nodeset_weight(NodeSet *set, size_t i);
+bool nodeset_get_weight(NodeSet *set, Node *node, uint32_t *weight);
+// Bulk construction: after nodeset_reserve, members (and weights, if
+// requested) may be written straight into nodes[size++]; nodeset_dedup
+// must follow. It keeps the first position of each member with the weight
+// of its last copy, as repeated nodeset_add_weighted calls would, rebuilds
+// the lookup index, and returns the number of copies removed.
+bool nodeset_reserve(NodeSet *set, size_t capacity, bool weighted);
+size_t nodeset_dedup(NodeSet *set);
 void nodeset_remove(NodeSet *set, Node *node);
+// O(1) removal that moves the last member into the hole; for sets whose
+// order does not matter
+void nodeset_swap_remove(NodeSet *set, Node *node);
 size_t nodeset_size(NodeSet *set);
 bool nodeset_is_empty(NodeSet *set);
 
+// NodeMap operations
+NodeMap *nodemap_create(size_t expected_size);
+void nodemap_destroy(NodeMap *map);
+bool nodemap_put(NodeMap *map, Node *node, size_t value);
+bool nodemap_get(const NodeMap *map, Node *node, size_t *value);
+size_t nodemap_size(const NodeMap *map);
+
 // NodeQueue operations
 NodeQueue *queue_create(size_t capacity);
 void queue_destroy(NodeQueue *queue);
@@ -0,0 +1,30 @@
+#ifndef PAGERANK_H
+#define PAGERANK_H
+#include "csr.h"
+
+typedef struct PageRankOptions {
+  double damping;     // Chance of following an edge rather than jumping
+  double tolerance;   // Stop once an iteration moves the ranks less (L1)
+  int max_iterations; // Stop after this many iterations regardless
+  int nthreads;       // <= 0 uses every online processor
+} PageRankOptions;
+
+typedef struct PageRankResult {
+  int iterations; // Iterations run
+  double delta;   // L1 change of the last one
+} PageRankResult;
+
+// PageRank over the directed edges (add_edge with directed set) of a
+// frozen graph. Each iteration pulls: node v sums the contributions
+// rank[u] / outdegree(u) of its CSR_INCOMING neighbors, so every thread
+// writes only its own nodes and needs no atomics. Threads take ranges of
+// equal edge count, and the sums are unrolled into independent (SIMD where
+// available) accumulators. Rank held by nodes without outgoing edges is
+// spread evenly over all nodes, so the ranks always sum to 1. options may
+// be NULL for damping 0.85, tolerance 1e-6, at most 100 iterations on
+// every processor. rank receives num_nodes values. Returns false on bad
+// options or allocation failure.
+bool pagerank(const CSRGraph *graph, const PageRankOptions *options,
+              double *rank, PageRankResult *result);
+
+#endif // PAGERANK_H
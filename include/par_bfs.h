@@ -0,0 +1,17 @@
+#ifndef PAR_BFS_H
+#define PAR_BFS_H
+#include "csr.h"
+
+// Level-synchronous parallel BFS from source along CSR_OUTGOING. Each level
+// runs either top-down (frontier nodes claim their unvisited out-neighbors)
+// or bottom-up (unvisited nodes look for a frontier node among their
+// CSR_INCOMING neighbors), switching to bottom-up while the frontier's edges
+// are a large share of the unexplored ones. Fills dist with hop counts (-1
+// when unreached) and parent with BFS parents (CSR_NONE for the source and
+// unreached nodes). nthreads <= 0 uses every online processor.
+// Returns the number of reached nodes, or 0 on bad arguments or allocation
+// failure.
+size_t par_bfs(const CSRGraph *graph, uint32_t source, int nthreads,
+               int32_t *dist, uint32_t *parent);
+
+#endif // PAR_BFS_H
@@ -0,0 +1,52 @@
+#ifndef PAR_TREE_H
+#define PAR_TREE_H
+#include "node.h"
+#include "taskpool.h"
+
+// Largest accumulator tree_reduce handles, in bytes
+#define TREE_REDUCE_MAX_SIZE 64
+
+// Bottom-up reduction over children. Node results and partial results over
+// runs of siblings share one accumulator type: identity() makes an empty
+// one, combine() folds other into acc (it must be associative; siblings
+// are combined in order) and finish() turns the combined results of a
+// node's children into the node's own result, in place.
+typedef struct TreeReduceOps {
+  size_t size;
+  void (*identity)(void *acc, void *ctx);
+  void (*combine)(void *acc, const void *other, void *ctx);
+  void (*finish)(Node *node, void *acc, void *ctx);
+} TreeReduceOps;
+
+// Reduces the tree under root into result using the pool's workers.
+// Sibling ranges are split off as tasks only while some worker is idle, so
+// the spawn cutoff adapts to the tree's shape and the load. The walk is
+// iterative, so deep trees are safe. Callbacks run concurrently. Returns
+// false on bad arguments or allocation failure.
+bool tree_reduce(TaskPool *pool, Node *root, const TreeReduceOps *ops,
+                 void *ctx, void *result);
+
+// Subtree metrics in one pass, with the same definitions as the serial
+// height/num_nodes/num_leaves/diameter in node.h
+typedef struct TreeStats {
+  int height;
+  int size;
+  int leaves;
+  int diameter;
+} TreeStats;
+
+bool par_tree_stats(TaskPool *pool, Node *root, TreeStats *stats);
+// Each returns -1 on failure, 0 for an empty tree
+int par_height(TaskPool *pool, Node *root);
+int par_num_nodes(TaskPool *pool, Node *root);
+int par_num_leaves(TaskPool *pool, Node *root);
+int par_diameter(TaskPool *pool, Node *root);
+
+// Postorder visit where sibling subtrees may run in parallel; a node is
+// visited after all of its children. visit must be thread-safe. VISIT_STOP
+// prevents visits that have not started yet and makes this return true;
+// VISIT_SKIP has no effect.
+bool par_postorder_visit(TaskPool *pool, Node *root, NodeVisitor visit,
+                         void *ctx);
+
+#endif // PAR_TREE_H
@@ -0,0 +1,28 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <pthread.h>
+#include <stdbool.h>
+
+// Reusable thread barrier; pthread_barrier_t is not available everywhere
+typedef struct ParallelBarrier {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int count;
+  int waiting;
+  unsigned long phase;
+} ParallelBarrier;
+
+void parallel_barrier_init(ParallelBarrier *barrier, int count);
+void parallel_barrier_destroy(ParallelBarrier *barrier);
+// Returns true in exactly one of the waiting threads
+bool parallel_barrier_wait(ParallelBarrier *barrier);
+
+// Runs fn(thread, ctx) for thread = 0 .. nthreads - 1 and waits for all of
+// them; the calling thread runs thread 0. fn runs only once every thread
+// has started, so it may wait on barriers. Returns -1, without running fn,
+// if memory or a thread cannot be had.
+int parallel_run(int nthreads, void (*fn)(int thread, void *ctx), void *ctx);
+// Online processor count, at least 1
+int parallel_default_threads(void);
+
+#endif // PARALLEL_H
@@ -0,0 +1,63 @@
+#ifndef PBST_H
+#define PBST_H
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Persistent BST. Every update path-copies the O(height) nodes it touches
+// into a new version and leaves older versions intact. Published nodes are
+// never modified, so any number of threads can read a version they hold
+// without locks while a writer keeps producing new ones. Nodes are shared
+// between versions and reclaimed by reference counting once no version
+// reaches them.
+typedef struct PBSTNode {
+  int value;
+  unsigned int priority;
+  atomic_uint refcount;
+  struct PBSTNode *left;
+  struct PBSTNode *right;
+} PBSTNode;
+
+// A version is a counted reference to a root; {NULL, 0} is the empty tree,
+// and so is a NULL version pointer
+typedef struct {
+  PBSTNode *root;
+  int size;
+} PBST;
+
+// Updates return a new version and never modify the one passed in. Both
+// versions must eventually be released. If memory runs out, the partial
+// copy is released and the result is the version passed in, retained.
+PBST pbst_insert(const PBST *version, int value);
+PBST pbst_delete(const PBST *version, int value);
+
+// Version lifetime. A PBST value is owned by one thread at a time; to hand
+// versions to other threads, publish them through a PBSTHandle.
+PBST pbst_retain(const PBST *version);
+void pbst_release(PBST *version);
+
+// Shared slot holding the latest published version. Readers retain it
+// inside a short epoch-counted section, and a publisher frees the version
+// it replaced only once both epochs have drained, so no reader can be
+// retaining a root that is being released.
+typedef struct {
+  _Atomic(PBST *) current;
+  atomic_uint epoch;
+  atomic_uint readers[2];
+} PBSTHandle;
+
+// Starts out holding the empty tree; NULL if out of memory
+PBSTHandle *pbst_handle_create(void);
+// Releases the current version; no thread may still use the handle
+void pbst_handle_destroy(PBSTHandle *handle);
+// Makes version (retained) the current one and releases the previous one.
+// Waits for readers already inside pbst_acquire, never for ones holding a
+// version. Returns false, leaving the handle as it was, if out of memory.
+bool pbst_publish(PBSTHandle *handle, const PBST *version);
+// The current version, retained; lock-free, and safe during pbst_publish
+PBST pbst_acquire(PBSTHandle *handle);
+
+// Lock-free reads
+PBSTNode *pbst_search(const PBST *version, int value);
+void pbst_inorder(PBSTNode *node, PBSTNode **output, int *index);
+
+#endif
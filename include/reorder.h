@@ -0,0 +1,28 @@
+#ifndef REORDER_H
+#define REORDER_H
+#include "csr.h"
+#include "graph.h"
+
+// Node orders that put nodes used together next to each other in memory
+typedef enum {
+  REORDER_BFS,    // Breadth-first from each root: siblings end up adjacent
+  REORDER_RCM,    // Reverse Cuthill-McKee: minimizes adjacency bandwidth
+  REORDER_DEGREE, // Hubs first, by descending degree
+} ReorderMethod;
+
+// Computes an order over a frozen graph: order[new position] = old index.
+// BFS and RCM treat every adjacency kind and the parent link as undirected
+// edges. Returns false on bad arguments or allocation failure.
+bool reorder_compute(const CSRGraph *graph, ReorderMethod method,
+                     uint32_t *order);
+
+// Orders count nodes and moves them into one contiguous arena in that
+// order with arena_relocate; the same conditions apply. relocated receives
+// the new nodes in their new order. The old nodes are destroyed.
+GraphArena *reorder_nodes(Node **nodes, size_t count, ReorderMethod method,
+                          Node **relocated);
+
+// Reorders every node a Graph owns, keeping its id index valid
+bool reorder_graph(Graph *graph, ReorderMethod method);
+
+#endif // REORDER_H
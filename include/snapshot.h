@@ -0,0 +1,56 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "csr.h"
+#include "graph.h"
+#include <stdio.h>
+
+#define SNAPSHOT_VERSION 1
+
+// Binary image of a frozen Node graph in the CSRGraph layout: node ids,
+// parent links, offsets, neighbors and weights of the four adjacency kinds,
+// and an optional blob of encoded values. Every section is 8-byte aligned,
+// so the file can be mapped and used in place. Numbers are stored in the
+// writer's byte order, which the reader checks.
+
+// Writes value's bytes to out; returning false aborts the snapshot
+typedef bool (*SnapshotEncode)(FILE *out, void *value, void *ctx);
+// Rebuilds a value from the bytes its SnapshotEncode wrote
+typedef void *(*SnapshotDecode)(const void *data, size_t size, void *ctx);
+
+// Freezes nodes like csr_freeze and writes them to path. Values go through
+// encode, or are left out when it is NULL. The file is written under a
+// temporary name and renamed into place, so readers never see half of
+// one. Returns false on I/O or allocation failure, or if encode fails.
+bool snapshot_write(const char *path, Node **nodes, size_t count,
+                    SnapshotEncode encode, void *ctx);
+
+typedef struct Snapshot {
+  // Read-only view whose arrays point into the mapping. It has no Node
+  // objects: nodes and index are NULL, so csr_index_of finds nothing.
+  CSRGraph graph;
+  const uint64_t *value_offsets; // num_nodes + 1, NULL without values
+  const unsigned char *values;
+  void *map;
+  size_t map_size;
+} Snapshot;
+
+// Maps a snapshot. Only the header and section bounds are checked, so
+// opening costs the same for any size; pages load as the view touches
+// them. Returns NULL if the file is missing, truncated or not a snapshot
+// of this version and byte order.
+Snapshot *snapshot_open(const char *path);
+void snapshot_close(Snapshot *snapshot);
+// Checks every offset, neighbor and parent index, in one pass over the
+// file. Worth running on snapshots from untrusted sources.
+bool snapshot_validate(const Snapshot *snapshot);
+// Encoded value of a node, or NULL if the snapshot has no values
+const void *snapshot_value(const Snapshot *snapshot, uint32_t node,
+                           size_t *size);
+// Rebuilds a mutable Graph from the snapshot, in index order, decoding
+// each value with decode (NULL values if decode is NULL or the snapshot
+// has none). Sets are filled at their exact size in one pass. Returns NULL
+// if two nodes share an id, or on allocation failure.
+Graph *snapshot_to_graph(const Snapshot *snapshot, SnapshotDecode decode,
+                         void *ctx);
+
+#endif // SNAPSHOT_H
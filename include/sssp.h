@@ -0,0 +1,41 @@
+#ifndef SSSP_H
+#define SSSP_H
+#include "csr.h"
+#include <stdint.h>
+
+// Distance of nodes that cannot be reached
+#define SSSP_INF UINT64_MAX
+
+// Shortest paths over one adjacency kind of a frozen graph, using its
+// integer edge weights (EDGE_DEFAULT_WEIGHT where none were given).
+// Dijkstra runs on a radix heap: keys only grow, so each entry moves down
+// its 65 buckets at most once and pops cost amortized O(log C).
+
+// Single source. dist receives num_nodes distances (SSSP_INF if
+// unreachable); parent, if not NULL, receives the predecessor on a
+// shortest path (CSR_NONE for the source and unreachable nodes). Returns
+// false for a bad source or on allocation failure.
+bool sssp_dijkstra(const CSRGraph *graph, CSRKind kind, uint32_t source,
+                   uint64_t *dist, uint32_t *parent);
+
+// Reusable state for point-to-point queries. The search runs Dijkstra
+// forward from the source and backward from the target until the two
+// frontiers prove a shortest path, so it touches a small part of a large
+// graph. Backward steps use the reverse kind: CSR_INCOMING for
+// CSR_OUTGOING and vice versa, and CSR_EDGES itself, which assumes edges
+// were added bidirectionally. Per-node state is reset lazily, so a query
+// costs nothing for nodes it never reaches. Not thread-safe; use one
+// search per thread.
+typedef struct SSSPSearch SSSPSearch;
+
+// Returns NULL for CSR_CHILDREN, which has no reverse kind, or on
+// allocation failure
+SSSPSearch *sssp_search_create(const CSRGraph *graph, CSRKind kind);
+void sssp_search_destroy(SSSPSearch *search);
+// Shortest distance from source to target, or SSSP_INF. If path is not
+// NULL it receives the node indices from source to target, and path_len
+// their count; path needs room for num_nodes entries.
+uint64_t sssp_search_path(SSSPSearch *search, uint32_t source,
+                          uint32_t target, uint32_t *path, size_t *path_len);
+
+#endif // SSSP_H
@@ -0,0 +1,54 @@
+#ifndef SUBTREE_H
+#define SUBTREE_H
+#include "node.h"
+#include <stdint.h>
+
+// Reads the number a node contributes to subtree aggregates
+typedef double (*SubtreeProjection)(Node *node, void *ctx);
+
+typedef struct SubtreeAggregate {
+  double sum;
+  double max;
+} SubtreeAggregate;
+
+// Subtree sum and max over the children tree under a root. Nodes are
+// numbered in preorder, so every subtree is one contiguous range, and a
+// segment tree over that order answers range aggregates and point updates in
+// O(log n). Values are projected from each node once at build time;
+// afterwards subtree_set or subtree_refresh keep them current. Adding or
+// moving nodes needs subtree_rebuild.
+typedef struct SubtreeIndex {
+  Node *root;
+  SubtreeProjection project;
+  void *ctx;
+  NodeMap *ids; // Node -> preorder position
+  size_t size;
+  Node **nodes;
+  uint32_t *last;         // Last preorder position in the node's subtree
+  SubtreeAggregate *tree; // Leaves at size .. 2 * size - 1
+} SubtreeIndex;
+
+// Projection for nodes whose value points to a double; NULL counts as 0
+double subtree_project_double(Node *node, void *ctx);
+
+// Returns NULL when root or project is NULL or on allocation failure
+SubtreeIndex *subtree_create(Node *root, SubtreeProjection project,
+                             void *ctx);
+void subtree_destroy(SubtreeIndex *index);
+// Re-flattens the tree and re-projects every node
+bool subtree_rebuild(SubtreeIndex *index);
+
+// Point updates; false if the node is not indexed
+bool subtree_set(SubtreeIndex *index, Node *node, double value);
+bool subtree_refresh(SubtreeIndex *index, Node *node);
+
+// Queries return NAN for nodes that are not indexed
+double subtree_value(const SubtreeIndex *index, Node *node);
+double subtree_sum(const SubtreeIndex *index, Node *node);
+double subtree_max(const SubtreeIndex *index, Node *node);
+bool subtree_aggregate(const SubtreeIndex *index, Node *node,
+                       SubtreeAggregate *out);
+// Number of nodes in the subtree, 0 if not indexed
+size_t subtree_count(const SubtreeIndex *index, Node *node);
+
+#endif
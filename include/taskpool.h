@@ -0,0 +1,45 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+#include <stdatomic.h>
+#include <stdbool.h>
+
+// Unit of work; embed it at the start of a larger struct carrying the
+// task's arguments and results. The memory must stay valid until
+// taskpool_wait returns for it.
+typedef struct Task {
+  void (*run)(struct Task *task);
+  atomic_bool done;
+} Task;
+
+// Fork-join pool of worker threads with work stealing: every worker owns a
+// Chase-Lev deque, pushes and pops spawned tasks at its bottom, and steals
+// from the top of the others' deques when it runs dry. Idle workers sleep
+// while no taskpool_run is in progress.
+typedef struct TaskPool TaskPool;
+
+// nthreads <= 0 uses every online processor; the thread that calls
+// taskpool_run counts as one of them. NULL if memory or a worker thread
+// cannot be had.
+TaskPool *taskpool_create(int nthreads);
+void taskpool_destroy(TaskPool *pool);
+int taskpool_threads(const TaskPool *pool);
+
+// Runs root on the calling thread as a pool worker and returns once it and
+// everything it spawned has finished. One taskpool_run at a time per pool.
+void taskpool_run(TaskPool *pool, Task *root);
+// From inside a task: makes task available to other workers. Runs it
+// immediately when called outside the pool or when the deque is full.
+void taskpool_spawn(TaskPool *pool, Task *task);
+// From inside a task: runs other tasks until task has finished. Tasks
+// should be waited for in the reverse order they were spawned.
+void taskpool_wait(TaskPool *pool, Task *task);
+// From inside a task: if task is still at the bottom of the caller's deque
+// (nobody stole it), removes it and returns true; the caller then does the
+// work itself instead of waiting. Lets iterative code avoid running its own
+// spawned tasks as nested calls.
+bool taskpool_take_back(TaskPool *pool, Task *task);
+// True while some worker is looking for work and the caller's deque is
+// empty; lets tasks split lazily instead of using a fixed cutoff
+bool taskpool_hungry(TaskPool *pool);
+
+#endif // TASKPOOL_H
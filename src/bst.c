@@ -1,14 +1,39 @@
 #include "bst.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+unsigned int bst_priority(int value) {
+  unsigned int x = (unsigned int)value;
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
+static int node_size(BSTNode *node) { return node ? node->size : 0; }
+
+static void update_size(BSTNode *node) {
+  node->size = 1 + node_size(node->left) + node_size(node->right);
+}
+
+static void set_parent(BSTNode *child, BSTNode *parent) {
+  if (child)
+    child->parent = parent;
+}
+
 // Create a new node
 BSTNode *create_node(int value) {
   BSTNode *new_node = (BSTNode *)malloc(sizeof(BSTNode));
   new_node->value = value;
   new_node->left = NULL;
   new_node->right = NULL;
+  new_node->parent = NULL;
+  new_node->priority = bst_priority(value);
+  new_node->size = 1;
   return new_node;
 }
 
@@ -32,6 +57,7 @@ void bst_insert(BST *tree, int value) {
     if (value < current->value) {
       if (current->left == NULL) {
         current->left = create_node(value);
+        current->left->parent = current;
         tree->size++;
         break;
       } else {
@@ -40,15 +66,19 @@ void bst_insert(BST *tree, int value) {
     } else if (value > current->value) {
       if (current->right == NULL) {
         current->right = create_node(value);
+        current->right->parent = current;
         tree->size++;
         break;
       } else {
         current = current->right;
       }
     } else {
-      break;
+      return;
     }
   }
+  for (; current; current = current->parent) {
+    current->size++;
+  }
 }
 
 BSTNode *search(BST *tree, int value) {
@@ -81,8 +111,10 @@ BSTNode *delete_node_recursive(BSTNode *root, int value) {
 
   if (value < root->value) {
     root->left = delete_node_recursive(root->left, value);
+    set_parent(root->left, root);
   } else if (value > root->value) {
     root->right = delete_node_recursive(root->right, value);
+    set_parent(root->right, root);
   } else {
     // Node to be deleted found
 
@@ -106,8 +138,10 @@ BSTNode *delete_node_recursive(BSTNode *root, int value) {
       BSTNode *temp = find_min(root->right);
       root->value = temp->value;
       root->right = delete_node_recursive(root->right, temp->value);
+      set_parent(root->right, root);
     }
   }
+  update_size(root);
   return root;
 }
 
@@ -122,6 +156,7 @@ void delete_node(BST *tree, int value) {
   }
 
   tree->root = delete_node_recursive(tree->root, value);
+  set_parent(tree->root, NULL);
   tree->size--;
 }
 
@@ -133,6 +168,505 @@ void free_tree(BST *tree) {
   tree->size = 0;
 }
 
+// Rotations keep parent links inside the rotated pair; the new top inherits
+// the old top's parent, and the caller relinks that parent's child pointer
+static BSTNode *rotate_right(BSTNode *node) {
+  BSTNode *left = node->left;
+  node->left = left->right;
+  set_parent(node->left, node);
+  left->right = node;
+  left->parent = node->parent;
+  node->parent = left;
+  update_size(node);
+  update_size(left);
+  return left;
+}
+
+static BSTNode *rotate_left(BSTNode *node) {
+  BSTNode *right = node->right;
+  node->right = right->left;
+  set_parent(node->right, node);
+  right->left = node;
+  right->parent = node->parent;
+  node->parent = right;
+  update_size(node);
+  update_size(right);
+  return right;
+}
+
+// Joins two subtrees where every value in left is smaller than every value in
+// right, keeping the higher priority on top
+static BSTNode *join_nodes(BSTNode *left, BSTNode *right) {
+  if (left == NULL)
+    return right;
+  if (right == NULL)
+    return left;
+  if (left->priority > right->priority) {
+    left->right = join_nodes(left->right, right);
+    left->right->parent = left;
+    update_size(left);
+    return left;
+  }
+  right->left = join_nodes(left, right->left);
+  right->left->parent = right;
+  update_size(right);
+  return right;
+}
+
+// Splits root into values < pivot (<= pivot when inclusive) and the rest
+static void split_nodes(BSTNode *root, int pivot, int inclusive,
+                        BSTNode **left, BSTNode **right) {
+  if (root == NULL) {
+    *left = NULL;
+    *right = NULL;
+    return;
+  }
+  if (root->value < pivot || (inclusive && root->value == pivot)) {
+    split_nodes(root->right, pivot, inclusive, &root->right, right);
+    set_parent(root->right, root);
+    *left = root;
+  } else {
+    split_nodes(root->left, pivot, inclusive, left, &root->left);
+    set_parent(root->left, root);
+    *right = root;
+  }
+  update_size(root);
+}
+
+// Search path recorded for splaying, kept on the stack for typical depths
+typedef struct {
+  BSTNode **nodes;
+  int depth;
+  int capacity;
+  BSTNode *inline_nodes[64];
+} SplayPath;
+
+static void path_push(SplayPath *path, BSTNode *node) {
+  if (path->depth == path->capacity) {
+    BSTNode **grown =
+        (BSTNode **)malloc(2 * path->capacity * sizeof(BSTNode *));
+    memcpy(grown, path->nodes, path->depth * sizeof(BSTNode *));
+    if (path->nodes != path->inline_nodes)
+      free(path->nodes);
+    path->nodes = grown;
+    path->capacity *= 2;
+  }
+  path->nodes[path->depth++] = node;
+}
+
+// Records the search path for value; the last node is the match, or the
+// node where the search fell off the tree
+static void path_search(SplayPath *path, BSTNode *root, int value) {
+  path->nodes = path->inline_nodes;
+  path->depth = 0;
+  path->capacity = 64;
+  BSTNode *current = root;
+  while (current) {
+    path_push(path, current);
+    if (value == current->value)
+      break;
+    current = value < current->value ? current->left : current->right;
+  }
+}
+
+// Rotates the last node of the path up to the root and returns it
+static BSTNode *splay(SplayPath *path) {
+  BSTNode **nodes = path->nodes;
+  int depth = path->depth;
+  BSTNode *node = nodes[depth - 1];
+  while (depth > 1) {
+    BSTNode *parent = nodes[depth - 2];
+    if (depth == 2) {
+      // Zig
+      node = parent->left == node ? rotate_right(parent) : rotate_left(parent);
+      break;
+    }
+    BSTNode *grand = nodes[depth - 3];
+    int node_left = parent->left == node;
+    int parent_left = grand->left == parent;
+    BSTNode *sub;
+    if (node_left == parent_left) {
+      // Zig-zig
+      sub = parent_left ? rotate_right(grand) : rotate_left(grand);
+      sub = parent_left ? rotate_right(sub) : rotate_left(sub);
+    } else if (node_left) {
+      // Zig-zag
+      grand->right = rotate_right(parent);
+      sub = rotate_left(grand);
+    } else {
+      grand->left = rotate_left(parent);
+      sub = rotate_right(grand);
+    }
+    depth -= 2;
+    nodes[depth - 1] = sub;
+    if (depth > 1) {
+      BSTNode *above = nodes[depth - 2];
+      if (above->left == grand)
+        above->left = sub;
+      else
+        above->right = sub;
+    }
+  }
+  if (path->nodes != path->inline_nodes)
+    free(path->nodes);
+  return node;
+}
+
+BSTNode *bst_splay_search(BST *tree, int value) {
+  if (tree == NULL || tree->root == NULL) {
+    return NULL;
+  }
+  SplayPath path;
+  path_search(&path, tree->root, value);
+  tree->root = splay(&path);
+  return tree->root->value == value ? tree->root : NULL;
+}
+
+void bst_splay_insert(BST *tree, int value) {
+  if (tree->root == NULL) {
+    tree->root = create_node(value);
+    tree->size = 1;
+    return;
+  }
+  SplayPath path;
+  path_search(&path, tree->root, value);
+  BSTNode *last = path.nodes[path.depth - 1];
+  if (last->value != value) {
+    BSTNode *new_node = create_node(value);
+    if (value < last->value)
+      last->left = new_node;
+    else
+      last->right = new_node;
+    new_node->parent = last;
+    for (int i = 0; i < path.depth; i++) {
+      path.nodes[i]->size++;
+    }
+    path_push(&path, new_node);
+    tree->size++;
+  }
+  tree->root = splay(&path);
+}
+
+static BSTNode *treap_insert_recursive(BSTNode *root, int value) {
+  if (root == NULL) {
+    return create_node(value);
+  }
+  if (value < root->value) {
+    root->left = treap_insert_recursive(root->left, value);
+    root->left->parent = root;
+    if (root->left->priority > root->priority)
+      return rotate_right(root);
+  } else {
+    root->right = treap_insert_recursive(root->right, value);
+    root->right->parent = root;
+    if (root->right->priority > root->priority)
+      return rotate_left(root);
+  }
+  update_size(root);
+  return root;
+}
+
+static BSTNode *treap_delete_recursive(BSTNode *root, int value) {
+  if (value < root->value) {
+    root->left = treap_delete_recursive(root->left, value);
+    set_parent(root->left, root);
+  } else if (value > root->value) {
+    root->right = treap_delete_recursive(root->right, value);
+    set_parent(root->right, root);
+  } else {
+    BSTNode *joined = join_nodes(root->left, root->right);
+    free(root);
+    return joined;
+  }
+  update_size(root);
+  return root;
+}
+
+void bst_treap_insert(BST *tree, int value) {
+  if (tree == NULL || search(tree, value) != NULL) {
+    return;
+  }
+  tree->root = treap_insert_recursive(tree->root, value);
+  tree->root->parent = NULL;
+  tree->size++;
+}
+
+void bst_treap_delete(BST *tree, int value) {
+  if (tree == NULL || search(tree, value) == NULL) {
+    return;
+  }
+  tree->root = treap_delete_recursive(tree->root, value);
+  set_parent(tree->root, NULL);
+  tree->size--;
+}
+
+void bst_split(BST *tree, int pivot, BST *left, BST *right) {
+  BSTNode *left_root, *right_root;
+  split_nodes(tree->root, pivot, 0, &left_root, &right_root);
+  tree->root = NULL;
+  tree->size = 0;
+  set_parent(left_root, NULL);
+  set_parent(right_root, NULL);
+  left->root = left_root;
+  left->size = node_size(left_root);
+  right->root = right_root;
+  right->size = node_size(right_root);
+}
+
+int bst_join(BST *left, BST *right) {
+  if (right->root == NULL) {
+    return 0;
+  }
+  if (left->root != NULL) {
+    BSTNode *max = left->root;
+    while (max->right != NULL) {
+      max = max->right;
+    }
+    if (max->value >= find_min(right->root)->value) {
+      return -1;
+    }
+  }
+  left->root = join_nodes(left->root, right->root);
+  left->root->parent = NULL;
+  left->size += right->size;
+  right->root = NULL;
+  right->size = 0;
+  return 0;
+}
+
+void bst_delete_range(BST *tree, int low, int high) {
+  if (tree == NULL || low > high) {
+    return;
+  }
+  BSTNode *below, *rest, *range, *above;
+  split_nodes(tree->root, low, 0, &below, &rest);
+  split_nodes(rest, high, 1, &range, &above);
+  free_node(range);
+  set_parent(below, NULL);
+  set_parent(above, NULL);
+  tree->root = join_nodes(below, above);
+  set_parent(tree->root, NULL);
+  tree->size = node_size(tree->root);
+}
+
+BSTNode *bst_first(BST *tree) {
+  return tree->root ? find_min(tree->root) : NULL;
+}
+
+BSTNode *bst_last(BST *tree) {
+  BSTNode *node = tree->root;
+  while (node && node->right != NULL) {
+    node = node->right;
+  }
+  return node;
+}
+
+BSTNode *bst_next(BSTNode *node) {
+  if (node == NULL)
+    return NULL;
+  if (node->right != NULL)
+    return find_min(node->right);
+  while (node->parent && node->parent->right == node) {
+    node = node->parent;
+  }
+  return node->parent;
+}
+
+BSTNode *bst_prev(BSTNode *node) {
+  if (node == NULL)
+    return NULL;
+  if (node->left != NULL) {
+    node = node->left;
+    while (node->right != NULL) {
+      node = node->right;
+    }
+    return node;
+  }
+  while (node->parent && node->parent->left == node) {
+    node = node->parent;
+  }
+  return node->parent;
+}
+
+// Checkpoint streams: "BSTD", format version, node count, then the sorted
+// values as a zigzag first value and (delta - 1) for each following value,
+// all LEB128 varints
+#define DUMP_MAGIC "BSTD"
+#define DUMP_VERSION 1
+#define DUMP_BUFFER_SIZE 65536
+
+typedef struct {
+  FILE *file;
+  size_t length;
+  size_t position;
+  int error;
+  unsigned char buffer[DUMP_BUFFER_SIZE];
+} DumpStream;
+
+static void stream_flush(DumpStream *stream) {
+  if (stream->length &&
+      fwrite(stream->buffer, 1, stream->length, stream->file) !=
+          stream->length)
+    stream->error = 1;
+  stream->length = 0;
+}
+
+static void stream_write_varint(DumpStream *stream, unsigned long long value) {
+  if (stream->length + 10 > DUMP_BUFFER_SIZE)
+    stream_flush(stream);
+  while (value >= 0x80) {
+    stream->buffer[stream->length++] = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  stream->buffer[stream->length++] = (unsigned char)value;
+}
+
+static int stream_read_byte(DumpStream *stream) {
+  if (stream->position == stream->length) {
+    stream->length = fread(stream->buffer, 1, DUMP_BUFFER_SIZE, stream->file);
+    stream->position = 0;
+    if (stream->length == 0) {
+      stream->error = 1;
+      return 0;
+    }
+  }
+  return stream->buffer[stream->position++];
+}
+
+static unsigned long long stream_read_varint(DumpStream *stream) {
+  unsigned long long value = 0;
+  for (int shift = 0; shift < 64 && !stream->error; shift += 7) {
+    int byte = stream_read_byte(stream);
+    value |= (unsigned long long)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+  stream->error = 1;
+  return 0;
+}
+
+int bst_dump(BST *tree, FILE *out) {
+  DumpStream *stream = (DumpStream *)malloc(sizeof(DumpStream));
+  if (!stream)
+    return -1;
+  stream->file = out;
+  stream->length = 0;
+  stream->position = 0;
+  stream->error = 0;
+
+  memcpy(stream->buffer, DUMP_MAGIC, 4);
+  stream->buffer[4] = DUMP_VERSION;
+  stream->length = 5;
+  stream_write_varint(stream, (unsigned long long)tree->size);
+
+  // In-order walk with an explicit stack of at most height entries
+  int capacity = 64, top = 0;
+  BSTNode **stack = (BSTNode **)malloc(capacity * sizeof(BSTNode *));
+  BSTNode *current = tree->root;
+  unsigned int previous = 0;
+  int first = 1;
+  while (stack && (current || top > 0)) {
+    while (current) {
+      if (top == capacity) {
+        capacity *= 2;
+        BSTNode **grown =
+            (BSTNode **)realloc(stack, capacity * sizeof(BSTNode *));
+        if (!grown) {
+          stream->error = 1;
+          break;
+        }
+        stack = grown;
+      }
+      stack[top++] = current;
+      current = current->left;
+    }
+    if (stream->error)
+      break;
+    current = stack[--top];
+    unsigned int value = (unsigned int)current->value;
+    if (first) {
+      // Zigzag keeps small negative first values short
+      stream_write_varint(stream,
+                          (value << 1) ^ (unsigned int)(current->value >> 31));
+      first = 0;
+    } else {
+      stream_write_varint(stream, value - previous - 1);
+    }
+    previous = value;
+    current = current->right;
+  }
+  if (!stack)
+    stream->error = 1;
+  free(stack);
+
+  stream_flush(stream);
+  int result = stream->error || fflush(out) != 0 ? -1 : 0;
+  free(stream);
+  return result;
+}
+
+// Builds a perfectly balanced subtree from the next n values of the stream,
+// left subtree first so values are consumed in sorted order
+static BSTNode *load_balanced(DumpStream *stream, int n, long long *previous) {
+  if (n == 0 || stream->error)
+    return NULL;
+  BSTNode *left = load_balanced(stream, n / 2, previous);
+  unsigned long long encoded = stream_read_varint(stream);
+  long long value;
+  if (*previous == LLONG_MIN) {
+    value = (long long)(encoded >> 1) ^ -(long long)(encoded & 1);
+  } else {
+    value = *previous + 1 + (long long)encoded;
+  }
+  if (value < INT_MIN || value > INT_MAX || encoded > UINT_MAX)
+    stream->error = 1;
+  *previous = value;
+
+  BSTNode *node = create_node((int)value);
+  node->left = left;
+  node->right = load_balanced(stream, n - n / 2 - 1, previous);
+  set_parent(node->left, node);
+  set_parent(node->right, node);
+  update_size(node);
+  return node;
+}
+
+int bst_load(BST *tree, FILE *in) {
+  DumpStream *stream = (DumpStream *)malloc(sizeof(DumpStream));
+  if (!stream)
+    return -1;
+  stream->file = in;
+  stream->length = 0;
+  stream->position = 0;
+  stream->error = 0;
+
+  char magic[4];
+  for (int i = 0; i < 4; i++) {
+    magic[i] = (char)stream_read_byte(stream);
+  }
+  int version = stream_read_byte(stream);
+  unsigned long long count = stream_read_varint(stream);
+  if (stream->error || memcmp(magic, DUMP_MAGIC, 4) != 0 ||
+      version != DUMP_VERSION || count > INT_MAX) {
+    free(stream);
+    return -1;
+  }
+
+  long long previous = LLONG_MIN;
+  BSTNode *root = load_balanced(stream, (int)count, &previous);
+  int error = stream->error;
+  free(stream);
+  if (error) {
+    free_node(root);
+    return -1;
+  }
+
+  free_tree(tree);
+  tree->root = root;
+  tree->size = (int)count;
+  return 0;
+}
+
 // Fixed array-based traversal functions
 void inorder(BSTNode *node, BSTNode **output, int *index) {
   if (!node)
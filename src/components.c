@@ -0,0 +1,390 @@
+#include "components.h"
+#include "parallel.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Work units handed out per atomic claim
+#define COMPONENTS_CHUNK 256
+
+// Static share of [0, count) for a thread
+static void thread_range(size_t count, int thread, int nthreads, size_t *start,
+                         size_t *end) {
+  *start = count * thread / nthreads;
+  *end = count * (thread + 1) / nthreads;
+}
+
+typedef struct {
+  const CSRGraph *graph;
+  CSRKind kind;
+  int nthreads;
+  _Atomic uint32_t *parent;
+  uint32_t *component;
+  atomic_size_t next_chunk;
+  size_t *roots; // Per thread
+  ParallelBarrier barrier;
+} ComponentsState;
+
+// Root of node's tree, halving the path on the way. Concurrent halving is
+// safe: a parent pointer only ever moves to an ancestor.
+static uint32_t find_root(_Atomic uint32_t *parent, uint32_t node) {
+  uint32_t up = atomic_load_explicit(&parent[node], memory_order_relaxed);
+  while (up != node) {
+    uint32_t grand = atomic_load_explicit(&parent[up], memory_order_relaxed);
+    if (grand != up)
+      atomic_compare_exchange_weak_explicit(&parent[node], &up, grand,
+                                            memory_order_relaxed,
+                                            memory_order_relaxed);
+    node = up;
+    up = atomic_load_explicit(&parent[node], memory_order_relaxed);
+  }
+  return node;
+}
+
+static void unite(_Atomic uint32_t *parent, uint32_t a, uint32_t b) {
+  while (1) {
+    a = find_root(parent, a);
+    b = find_root(parent, b);
+    if (a == b)
+      return;
+    if (a < b) {
+      uint32_t tmp = a;
+      a = b;
+      b = tmp;
+    }
+    // Hook the larger root; fails if a stopped being a root meanwhile
+    uint32_t expected = a;
+    if (atomic_compare_exchange_strong_explicit(&parent[a], &expected, b,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed))
+      return;
+  }
+}
+
+static void components_worker(int thread, void *ctx) {
+  ComponentsState *state = (ComponentsState *)ctx;
+  size_t n = state->graph->num_nodes;
+  const uint64_t *offsets = state->graph->offsets[state->kind];
+  const uint32_t *neighbors = state->graph->neighbors[state->kind];
+  size_t start, end;
+
+  thread_range(n, thread, state->nthreads, &start, &end);
+  for (size_t i = start; i < end; i++) {
+    atomic_store_explicit(&state->parent[i], (uint32_t)i,
+                          memory_order_relaxed);
+  }
+  parallel_barrier_wait(&state->barrier);
+
+  while ((start = atomic_fetch_add(&state->next_chunk, COMPONENTS_CHUNK)) <
+         n) {
+    end = start + COMPONENTS_CHUNK < n ? start + COMPONENTS_CHUNK : n;
+    for (size_t u = start; u < end; u++) {
+      for (uint64_t j = offsets[u]; j < offsets[u + 1]; j++) {
+        // Edges inside one tree are the common case; skip the CAS loop
+        uint32_t v = neighbors[j];
+        if (atomic_load_explicit(&state->parent[v], memory_order_relaxed) !=
+            atomic_load_explicit(&state->parent[u], memory_order_relaxed))
+          unite(state->parent, (uint32_t)u, v);
+      }
+    }
+  }
+  parallel_barrier_wait(&state->barrier);
+
+  size_t roots = 0;
+  thread_range(n, thread, state->nthreads, &start, &end);
+  for (size_t i = start; i < end; i++) {
+    state->component[i] = find_root(state->parent, (uint32_t)i);
+    roots += state->component[i] == i;
+  }
+  state->roots[thread] = roots;
+}
+
+size_t par_components(const CSRGraph *graph, CSRKind kind, int nthreads,
+                      uint32_t *component) {
+  if (!graph || !component || kind >= CSR_KINDS || graph->num_nodes == 0)
+    return 0;
+  if (nthreads <= 0)
+    nthreads = parallel_default_threads();
+
+  ComponentsState state;
+  memset(&state, 0, sizeof(state));
+  state.graph = graph;
+  state.kind = kind;
+  state.nthreads = nthreads;
+  state.component = component;
+  state.parent = (_Atomic uint32_t *)malloc(graph->num_nodes *
+                                            sizeof(_Atomic uint32_t));
+  state.roots = (size_t *)calloc(nthreads, sizeof(size_t));
+  atomic_init(&state.next_chunk, 0);
+
+  size_t count = 0;
+  if (state.parent && state.roots) {
+    parallel_barrier_init(&state.barrier, nthreads);
+    if (parallel_run(nthreads, components_worker, &state) == 0) {
+      for (int i = 0; i < nthreads; i++) {
+        count += state.roots[i];
+      }
+    }
+    parallel_barrier_destroy(&state.barrier);
+  }
+  free((void *)state.parent);
+  free(state.roots);
+  return count;
+}
+
+// Nodes one thread made ready in the current frontier
+typedef struct {
+  uint32_t *nodes;
+  size_t size;
+  size_t capacity;
+} LocalReady;
+
+typedef struct {
+  const CSRGraph *graph;
+  int nthreads;
+  uint32_t *order; // Doubles as the queue: frontiers are appended in turn
+  _Atomic uint32_t *indegree;
+  size_t begin; // Current frontier is order[begin .. end)
+  size_t end;
+  size_t *offsets; // Where each thread's ready nodes go in order
+  LocalReady *locals;
+  atomic_size_t next_chunk;
+  atomic_bool failed;
+  size_t levels;
+  ParallelBarrier barrier;
+} TopoState;
+
+static void make_ready(TopoState *state, LocalReady *local, uint32_t node) {
+  if (local->size == local->capacity) {
+    size_t capacity = local->capacity ? 2 * local->capacity : 1024;
+    uint32_t *grown =
+        (uint32_t *)realloc(local->nodes, capacity * sizeof(uint32_t));
+    if (!grown) {
+      atomic_store(&state->failed, true);
+      return;
+    }
+    local->nodes = grown;
+    local->capacity = capacity;
+  }
+  local->nodes[local->size++] = node;
+}
+
+// Runs in one thread between frontiers: places the ready nodes after the
+// current frontier
+static void plan_next_frontier(TopoState *state) {
+  size_t total = 0;
+  for (int i = 0; i < state->nthreads; i++) {
+    state->offsets[i] = state->end + total;
+    total += state->locals[i].size;
+  }
+  state->begin = state->end;
+  state->end += total;
+  if (total)
+    state->levels++;
+  atomic_store(&state->next_chunk, 0);
+}
+
+static void topo_worker(int thread, void *ctx) {
+  TopoState *state = (TopoState *)ctx;
+  LocalReady *local = &state->locals[thread];
+  const uint64_t *offsets = state->graph->offsets[CSR_OUTGOING];
+  const uint32_t *targets = state->graph->neighbors[CSR_OUTGOING];
+  size_t n = state->graph->num_nodes;
+  size_t start, end;
+
+  thread_range(n, thread, state->nthreads, &start, &end);
+  for (size_t i = start; i < end; i++) {
+    atomic_store_explicit(&state->indegree[i], 0, memory_order_relaxed);
+  }
+  parallel_barrier_wait(&state->barrier);
+  thread_range(offsets[n], thread, state->nthreads, &start, &end);
+  for (size_t j = start; j < end; j++) {
+    atomic_fetch_add_explicit(&state->indegree[targets[j]], 1,
+                              memory_order_relaxed);
+  }
+  parallel_barrier_wait(&state->barrier);
+  // The first frontier: every node without predecessors
+  thread_range(n, thread, state->nthreads, &start, &end);
+  for (size_t i = start; i < end; i++) {
+    if (!atomic_load_explicit(&state->indegree[i], memory_order_relaxed))
+      make_ready(state, local, (uint32_t)i);
+  }
+
+  while (1) {
+    if (parallel_barrier_wait(&state->barrier))
+      plan_next_frontier(state);
+    parallel_barrier_wait(&state->barrier);
+    if (state->begin == state->end || atomic_load(&state->failed))
+      break;
+    if (local->size)
+      memcpy(state->order + state->offsets[thread], local->nodes,
+             local->size * sizeof(uint32_t));
+    local->size = 0;
+    parallel_barrier_wait(&state->barrier);
+
+    // The last predecessor to finish makes a node ready
+    while ((start = atomic_fetch_add(&state->next_chunk, COMPONENTS_CHUNK)) <
+           state->end - state->begin) {
+      end = start + COMPONENTS_CHUNK;
+      if (end > state->end - state->begin)
+        end = state->end - state->begin;
+      for (size_t i = state->begin + start; i < state->begin + end; i++) {
+        uint32_t node = state->order[i];
+        for (uint64_t j = offsets[node]; j < offsets[node + 1]; j++) {
+          if (atomic_fetch_sub_explicit(&state->indegree[targets[j]], 1,
+                                        memory_order_acq_rel) == 1)
+            make_ready(state, local, targets[j]);
+        }
+      }
+    }
+  }
+}
+
+// Walks backward from a node left out of the order. Every such node still
+// has a predecessor that was left out, so the walk must close a cycle.
+static size_t find_cycle(const CSRGraph *graph, _Atomic uint32_t *indegree,
+                         uint32_t *cycle) {
+  size_t n = graph->num_nodes;
+  uint32_t start = 0;
+  while (start < n && !atomic_load(&indegree[start])) {
+    start++;
+  }
+  uint32_t *seen = (uint32_t *)malloc(n * sizeof(uint32_t));
+  if (start == n || !seen) {
+    free(seen);
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    seen[i] = CSR_NONE;
+  }
+  // Backward edges come from CSR_INCOMING; trust only those confirmed by
+  // the predecessor's CSR_OUTGOING list
+  size_t len = 0;
+  uint32_t node = start;
+  while (seen[node] == CSR_NONE) {
+    seen[node] = (uint32_t)len;
+    cycle[len++] = node;
+    uint32_t next = CSR_NONE;
+    const uint32_t *preds = csr_neighbors(graph, CSR_INCOMING, node);
+    size_t degree = csr_degree(graph, CSR_INCOMING, node);
+    for (size_t j = 0; next == CSR_NONE && j < degree; j++) {
+      uint32_t pred = preds[j];
+      if (!atomic_load(&indegree[pred]))
+        continue;
+      const uint32_t *succs = csr_neighbors(graph, CSR_OUTGOING, pred);
+      for (size_t k = 0; k < csr_degree(graph, CSR_OUTGOING, pred); k++) {
+        if (succs[k] == node) {
+          next = pred;
+          break;
+        }
+      }
+    }
+    if (next == CSR_NONE) {
+      free(seen);
+      return 0;
+    }
+    node = next;
+  }
+  // cycle[seen[node] .. len) runs against the edges; reverse it in place
+  size_t first = seen[node];
+  free(seen);
+  size_t cycle_len = len - first;
+  memmove(cycle, cycle + first, cycle_len * sizeof(uint32_t));
+  for (size_t i = 0; i < cycle_len / 2; i++) {
+    uint32_t tmp = cycle[i];
+    cycle[i] = cycle[cycle_len - 1 - i];
+    cycle[cycle_len - 1 - i] = tmp;
+  }
+  return cycle_len;
+}
+
+// One thread needs no barriers or read-modify-writes; relaxed loads and
+// stores compile to plain moves
+static void serial_toposort(TopoState *state) {
+  const uint64_t *offsets = state->graph->offsets[CSR_OUTGOING];
+  const uint32_t *targets = state->graph->neighbors[CSR_OUTGOING];
+  _Atomic uint32_t *indegree = state->indegree;
+  size_t n = state->graph->num_nodes;
+  for (size_t i = 0; i < n; i++) {
+    atomic_store_explicit(&indegree[i], 0, memory_order_relaxed);
+  }
+  for (uint64_t j = 0; j < offsets[n]; j++) {
+    uint32_t count =
+        atomic_load_explicit(&indegree[targets[j]], memory_order_relaxed);
+    atomic_store_explicit(&indegree[targets[j]], count + 1,
+                          memory_order_relaxed);
+  }
+  size_t tail = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (!atomic_load_explicit(&indegree[i], memory_order_relaxed))
+      state->order[tail++] = (uint32_t)i;
+  }
+  // Frontier boundaries only matter for the level count
+  size_t level_end = tail;
+  state->levels = tail ? 1 : 0;
+  for (size_t head = 0; head < tail; head++) {
+    if (head == level_end) {
+      level_end = tail;
+      state->levels++;
+    }
+    uint32_t node = state->order[head];
+    for (uint64_t j = offsets[node]; j < offsets[node + 1]; j++) {
+      uint32_t count =
+          atomic_load_explicit(&indegree[targets[j]], memory_order_relaxed) -
+          1;
+      atomic_store_explicit(&indegree[targets[j]], count,
+                            memory_order_relaxed);
+      if (!count)
+        state->order[tail++] = targets[j];
+    }
+  }
+  state->end = tail;
+}
+
+bool par_toposort(const CSRGraph *graph, int nthreads, uint32_t *order,
+                  uint32_t *cycle, TopoSortResult *result) {
+  if (!graph || !order || !result)
+    return false;
+  memset(result, 0, sizeof(TopoSortResult));
+  if (graph->num_nodes == 0)
+    return true;
+  if (nthreads <= 0)
+    nthreads = parallel_default_threads();
+
+  TopoState state;
+  memset(&state, 0, sizeof(state));
+  state.graph = graph;
+  state.nthreads = nthreads;
+  state.order = order;
+  state.indegree = (_Atomic uint32_t *)malloc(graph->num_nodes *
+                                              sizeof(_Atomic uint32_t));
+  state.offsets = (size_t *)malloc(nthreads * sizeof(size_t));
+  state.locals = (LocalReady *)calloc(nthreads, sizeof(LocalReady));
+  atomic_init(&state.next_chunk, 0);
+  atomic_init(&state.failed, false);
+
+  bool ok = false;
+  if (state.indegree && nthreads == 1) {
+    serial_toposort(&state);
+    ok = true;
+  } else if (state.indegree && state.offsets && state.locals) {
+    parallel_barrier_init(&state.barrier, nthreads);
+    ok = parallel_run(nthreads, topo_worker, &state) == 0 &&
+         !atomic_load(&state.failed);
+    parallel_barrier_destroy(&state.barrier);
+  }
+  if (ok) {
+    result->ordered = state.end;
+    result->levels = state.levels;
+    if (state.end < graph->num_nodes && cycle)
+      result->cycle_len = find_cycle(graph, state.indegree, cycle);
+  }
+
+  for (int i = 0; state.locals && i < nthreads; i++) {
+    free(state.locals[i].nodes);
+  }
+  free((void *)state.indegree);
+  free(state.offsets);
+  free(state.locals);
+  return ok;
+}
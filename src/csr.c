@@ -0,0 +1,367 @@
+#include "csr.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static NodeSet *node_set(Node *node, CSRKind kind) {
+  switch (kind) {
+  case CSR_EDGES:
+    return node->edges;
+  case CSR_INCOMING:
+    return node->incoming;
+  case CSR_OUTGOING:
+    return node->outgoing;
+  default:
+    return node->children;
+  }
+}
+
+// Whether no node is listed as a child twice and every node is reached
+// from one listed nowhere, i.e. CSR_CHILDREN has no cycle. False if the
+// check runs out of memory, which only costs the walks their shortcut.
+static bool children_form_forest(const CSRGraph *graph) {
+  size_t n = graph->num_nodes;
+  const uint64_t *offsets = graph->offsets[CSR_CHILDREN];
+  const uint32_t *children = graph->neighbors[CSR_CHILDREN];
+  if (n > 0 && offsets[n] >= n)
+    return false;
+  uint8_t *listed = (uint8_t *)calloc(n ? n : 1, 1);
+  uint32_t *stack = (uint32_t *)malloc((n ? n : 1) * sizeof(uint32_t));
+  bool forest = listed && stack;
+  for (uint64_t i = 0; forest && i < offsets[n]; i++) {
+    forest = !listed[children[i]];
+    listed[children[i]] = 1;
+  }
+  // With one lister each, a node on a cycle is only reached from the cycle
+  size_t reached = 0;
+  for (size_t i = 0; forest && i < n; i++) {
+    if (listed[i])
+      continue;
+    size_t top = 0;
+    stack[top++] = (uint32_t)i;
+    while (top > 0) {
+      uint32_t node = stack[--top];
+      reached++;
+      for (uint64_t j = offsets[node]; j < offsets[node + 1]; j++) {
+        stack[top++] = children[j];
+      }
+    }
+  }
+  free(listed);
+  free(stack);
+  return forest && reached == n;
+}
+
+// Builds the view over nodes[0..count) once every node is in index
+static CSRGraph *freeze_indexed(Node **nodes, size_t count, NodeMap *index) {
+  CSRGraph *graph = (CSRGraph *)calloc(1, sizeof(CSRGraph));
+  if (!graph) {
+    nodemap_destroy(index);
+    free(nodes);
+    return NULL;
+  }
+  graph->num_nodes = count;
+  graph->nodes = nodes;
+  graph->index = index;
+  graph->node_ids = (double *)malloc(count * sizeof(double));
+  graph->parent = (uint32_t *)malloc(count * sizeof(uint32_t));
+  if (!graph->node_ids || !graph->parent) {
+    csr_destroy(graph);
+    return NULL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    size_t parent;
+    graph->node_ids[i] = nodes[i]->node_id;
+    graph->parent[i] = nodemap_get(index, nodes[i]->parent, &parent)
+                           ? (uint32_t)parent
+                           : CSR_NONE;
+  }
+
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    size_t total = 0;
+    bool weighted = false;
+    for (size_t i = 0; i < count; i++) {
+      NodeSet *set = node_set(nodes[i], (CSRKind)kind);
+      total += nodeset_size(set);
+      weighted |= set->weights != NULL;
+    }
+    uint64_t *offsets = (uint64_t *)malloc((count + 1) * sizeof(uint64_t));
+    uint32_t *neighbors = (uint32_t *)malloc((total ? total : 1) *
+                                             sizeof(uint32_t));
+    graph->offsets[kind] = offsets;
+    graph->neighbors[kind] = neighbors;
+    uint32_t *weights = NULL;
+    if (weighted) {
+      weights = (uint32_t *)malloc((total ? total : 1) * sizeof(uint32_t));
+      graph->weights[kind] = weights;
+    }
+    if (!offsets || !neighbors || (weighted && !weights)) {
+      csr_destroy(graph);
+      return NULL;
+    }
+
+    uint64_t cursor = 0;
+    for (size_t i = 0; i < count; i++) {
+      NodeSet *set = node_set(nodes[i], (CSRKind)kind);
+      offsets[i] = cursor;
+      for (size_t j = 0; j < nodeset_size(set); j++) {
+        size_t neighbor;
+        if (!nodemap_get(index, set->nodes[j], &neighbor))
+          continue;
+        if (weights)
+          weights[cursor] = nodeset_weight(set, j);
+        neighbors[cursor++] = (uint32_t)neighbor;
+      }
+    }
+    offsets[count] = cursor;
+  }
+  graph->children_forest = children_form_forest(graph);
+  return graph;
+}
+
+CSRGraph *csr_freeze(Node **nodes, size_t count) {
+  if (!nodes || count >= CSR_NONE)
+    return NULL;
+  Node **copy = (Node **)malloc((count ? count : 1) * sizeof(Node *));
+  NodeMap *index = nodemap_create(count);
+  if (!copy || !index) {
+    free(copy);
+    nodemap_destroy(index);
+    return NULL;
+  }
+  for (size_t i = 0; i < count; i++) {
+    copy[i] = nodes[i];
+    nodemap_put(index, nodes[i], i);
+  }
+  return freeze_indexed(copy, count, index);
+}
+
+// Nodes found so far by csr_freeze_from, which double as its BFS queue
+typedef struct {
+  Node **nodes;
+  size_t count;
+  size_t capacity;
+  NodeMap *index;
+} Collector;
+
+static bool collect(Collector *collector, Node *node) {
+  if (!node || nodemap_get(collector->index, node, NULL))
+    return true;
+  if (collector->count == collector->capacity) {
+    size_t capacity = 2 * collector->capacity;
+    Node **grown =
+        (Node **)realloc(collector->nodes, capacity * sizeof(Node *));
+    if (!grown || collector->count >= CSR_NONE)
+      return false;
+    collector->nodes = grown;
+    collector->capacity = capacity;
+  }
+  collector->nodes[collector->count] = node;
+  return nodemap_put(collector->index, node, collector->count++);
+}
+
+CSRGraph *csr_freeze_from(Node *root) {
+  if (!root)
+    return NULL;
+  Collector collector = {(Node **)malloc(64 * sizeof(Node *)), 0, 64,
+                         nodemap_create(64)};
+  bool ok = collector.nodes && collector.index && collect(&collector, root);
+  for (size_t head = 0; ok && head < collector.count; head++) {
+    Node *node = collector.nodes[head];
+    ok = collect(&collector, node->parent);
+    for (int kind = 0; ok && kind < CSR_KINDS; kind++) {
+      NodeSet *set = node_set(node, (CSRKind)kind);
+      for (size_t j = 0; ok && j < nodeset_size(set); j++) {
+        ok = collect(&collector, set->nodes[j]);
+      }
+    }
+  }
+  if (!ok) {
+    free(collector.nodes);
+    nodemap_destroy(collector.index);
+    return NULL;
+  }
+  return freeze_indexed(collector.nodes, collector.count, collector.index);
+}
+
+void csr_destroy(CSRGraph *graph) {
+  if (graph) {
+    for (int kind = 0; kind < CSR_KINDS; kind++) {
+      free(graph->offsets[kind]);
+      free(graph->neighbors[kind]);
+      free(graph->weights[kind]);
+    }
+    free(graph->nodes);
+    free(graph->node_ids);
+    free(graph->parent);
+    nodemap_destroy(graph->index);
+    free(graph);
+  }
+}
+
+uint32_t csr_index_of(const CSRGraph *graph, Node *node) {
+  size_t index;
+  if (!graph || !nodemap_get(graph->index, node, &index))
+    return CSR_NONE;
+  return (uint32_t)index;
+}
+
+size_t csr_degree(const CSRGraph *graph, CSRKind kind, uint32_t node) {
+  return graph->offsets[kind][node + 1] - graph->offsets[kind][node];
+}
+
+const uint32_t *csr_neighbors(const CSRGraph *graph, CSRKind kind,
+                              uint32_t node) {
+  return graph->neighbors[kind] + graph->offsets[kind][node];
+}
+
+const uint32_t *csr_weights(const CSRGraph *graph, CSRKind kind,
+                            uint32_t node) {
+  if (!graph->weights[kind])
+    return NULL;
+  return graph->weights[kind] + graph->offsets[kind][node];
+}
+
+// add_child does not keep CSR_CHILDREN a tree: a child may be listed under
+// several parents, or children may form a cycle. Unless the view is known
+// to be a forest, the walks below mark nodes as they are queued, so each
+// node is queued at most once and num_nodes bounds their stacks and queues.
+
+// Stack or queue of a walk. It starts small and doubles as needed, so a
+// walk over a forest touches memory in proportion to its subtree.
+typedef struct {
+  uint32_t *items;
+  size_t capacity;
+  uint8_t *seen; // NULL over a forest
+} Walk;
+
+static bool walk_init(Walk *walk, const CSRGraph *graph) {
+  walk->capacity = 64;
+  walk->items = (uint32_t *)malloc(walk->capacity * sizeof(uint32_t));
+  walk->seen = NULL;
+  if (!graph->children_forest)
+    walk->seen = (uint8_t *)calloc(graph->num_nodes, 1);
+  return walk->items && (graph->children_forest || walk->seen);
+}
+
+static void walk_release(Walk *walk) {
+  free(walk->items);
+  free(walk->seen);
+}
+
+// Makes room for size items
+static bool walk_reserve(Walk *walk, size_t size) {
+  if (size <= walk->capacity)
+    return true;
+  size_t capacity = walk->capacity;
+  while (capacity < size) {
+    capacity *= 2;
+  }
+  uint32_t *items =
+      (uint32_t *)realloc(walk->items, capacity * sizeof(uint32_t));
+  if (!items)
+    return false;
+  walk->items = items;
+  walk->capacity = capacity;
+  return true;
+}
+
+// Whether node is reached for the first time, marking it if so
+static bool walk_first(Walk *walk, uint32_t node) {
+  if (!walk->seen)
+    return true;
+  if (walk->seen[node])
+    return false;
+  walk->seen[node] = 1;
+  return true;
+}
+
+void csr_dfs(const CSRGraph *graph, uint32_t start,
+             void (*visit)(uint32_t, void *), void *ctx) {
+  if (!graph || start >= graph->num_nodes || !visit)
+    return;
+  const uint64_t *offsets = graph->offsets[CSR_CHILDREN];
+  const uint32_t *children = graph->neighbors[CSR_CHILDREN];
+  Walk walk;
+  if (!walk_init(&walk, graph)) {
+    walk_release(&walk);
+    return;
+  }
+  size_t top = 0;
+  walk.items[top++] = start;
+  walk_first(&walk, start);
+  while (top > 0) {
+    uint32_t node = walk.items[--top];
+    visit(node, ctx);
+    if (!walk_reserve(&walk, top + (offsets[node + 1] - offsets[node])))
+      break;
+    // Push in reverse so the first child is visited first
+    for (uint64_t i = offsets[node + 1]; i > offsets[node]; i--) {
+      uint32_t child = children[i - 1];
+      if (walk_first(&walk, child))
+        walk.items[top++] = child;
+    }
+  }
+  walk_release(&walk);
+}
+
+// Runs a BFS from start, calling visit (if any) on each node. Returns the
+// node count and stores the number of levels below start in *levels, or
+// returns 0 if the queue cannot grow. A node reachable along several paths
+// counts once, at the first level it is reached.
+static size_t level_walk(const CSRGraph *graph, uint32_t start,
+                         void (*visit)(uint32_t, void *), void *ctx,
+                         int *levels) {
+  const uint64_t *offsets = graph->offsets[CSR_CHILDREN];
+  const uint32_t *children = graph->neighbors[CSR_CHILDREN];
+  Walk walk;
+  if (!walk_init(&walk, graph)) {
+    walk_release(&walk);
+    return 0;
+  }
+  size_t head = 0, tail = 0;
+  walk.items[tail++] = start;
+  walk_first(&walk, start);
+  *levels = -1;
+  while (head < tail) {
+    size_t level_end = tail;
+    (*levels)++;
+    for (; head < level_end; head++) {
+      uint32_t node = walk.items[head];
+      if (visit)
+        visit(node, ctx);
+      if (!walk_reserve(&walk, tail + (offsets[node + 1] - offsets[node]))) {
+        walk_release(&walk);
+        return 0;
+      }
+      for (uint64_t i = offsets[node]; i < offsets[node + 1]; i++) {
+        if (walk_first(&walk, children[i]))
+          walk.items[tail++] = children[i];
+      }
+    }
+  }
+  walk_release(&walk);
+  return tail;
+}
+
+void csr_bfs(const CSRGraph *graph, uint32_t start,
+             void (*visit)(uint32_t, void *), void *ctx) {
+  if (!graph || start >= graph->num_nodes || !visit)
+    return;
+  int levels;
+  level_walk(graph, start, visit, ctx, &levels);
+}
+
+int csr_height(const CSRGraph *graph, uint32_t root) {
+  if (!graph || root >= graph->num_nodes)
+    return 0;
+  int levels;
+  return level_walk(graph, root, NULL, NULL, &levels) ? levels : -1;
+}
+
+int csr_num_nodes(const CSRGraph *graph, uint32_t root) {
+  if (!graph || root >= graph->num_nodes)
+    return 0;
+  int levels;
+  size_t count = level_walk(graph, root, NULL, NULL, &levels);
+  return count ? (int)count : -1;
+}
@@ -0,0 +1,746 @@
+#include "edgelist.h"
+#include "parallel.h"
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Parse chunks per thread, so one slow region does not hold up the rest
+#define EDGELIST_CHUNKS_PER_THREAD 4
+// Upper bound on a chunk, which keeps edge positions within 32 bits
+#define EDGELIST_MAX_CHUNK ((size_t)1 << 30)
+// Largest id a double holds exactly
+#define EDGELIST_MAX_ID ((uint64_t)1 << 53)
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define EDGELIST_SWAR 1
+#endif
+
+// Adjacency kinds a line can add to, in add_edge order
+enum { KIND_EDGES, KIND_OUTGOING, KIND_INCOMING, KINDS };
+
+typedef struct {
+  const char *begin, *end; // Whole lines
+  uint64_t *src, *dst;     // Ids after parsing, node indices after resolving
+  uint32_t *weights;       // NULL until the chunk meets a weighted line
+  size_t count, capacity;
+  uint64_t max_id;
+  const char *error;   // Start of the first malformed line
+  bool failed;         // Out of memory
+  uint32_t *owned;     // Positions of the edges each thread builds from
+  size_t *owned_start; // nthreads + 1 offsets into owned
+} EdgeChunk;
+
+typedef struct {
+  const char *data;
+  size_t size;
+  bool directed, bidirectional;
+  int nthreads;
+  EdgeChunk *chunks;
+  size_t num_chunks;
+  atomic_size_t next_chunk;
+  // Ids become node indices by rank: through a bitmap with per-word ranks
+  // when the ids are dense enough, otherwise the sorted distinct ids
+  _Atomic uint64_t *bitmap;
+  uint64_t *ranks;
+  uint64_t *ids;
+  size_t num_nodes;
+  Graph *graph;
+  bool weighted;
+  atomic_size_t duplicates;
+  atomic_bool failed;
+} EdgeListState;
+
+static const uint64_t POW10[9] = {1,      10,      100,      1000,     10000,
+                                  100000, 1000000, 10000000, 100000000};
+
+static bool is_digit(char c) { return (unsigned char)(c - '0') < 10; }
+
+static bool is_separator(char c) { return c == ' ' || c == '\t' || c == ','; }
+
+#ifdef EDGELIST_SWAR
+// Value of eight digits (already minus '0', first digit in the low byte),
+// combining neighbors pairwise in three multiply-shift steps
+static uint64_t eight_digits(uint64_t x) {
+  x = (x * 10 + (x >> 8)) & 0x00FF00FF00FF00FFULL;
+  x = (x * 100 + (x >> 16)) & 0x0000FFFF0000FFFFULL;
+  return (x * 10000 + (x >> 32)) & 0xFFFFFFFFULL;
+}
+#endif
+
+// Reads a run of decimal digits, eight bytes per step where limit allows.
+// *digits receives the run length; the value wraps if the run is too long
+// for it, which callers rule out by length.
+static const char *parse_digits(const char *p, const char *limit,
+                                uint64_t *value, int *digits) {
+  uint64_t v = 0;
+  int n = 0;
+#ifdef EDGELIST_SWAR
+  while (limit - p >= 8) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    x -= 0x3030303030303030ULL;
+    // High bit of each byte that was below '0' or above '9'. Borrows and
+    // carries only travel upward, so the lowest flagged byte is exact.
+    uint64_t bad = (x | (x + 0x7676767676767676ULL)) & 0x8080808080808080ULL;
+    int run = bad ? __builtin_ctzll(bad) >> 3 : 8;
+    if (run == 0)
+      break;
+    // Shifting the digits to the top pads them with leading zeros
+    if (run < 8)
+      x <<= 8 * (8 - run);
+    v = v * POW10[run] + eight_digits(x);
+    n += run;
+    p += run;
+    if (run < 8) {
+      *value = v;
+      *digits = n;
+      return p;
+    }
+  }
+#endif
+  for (; p < limit && is_digit(*p); p++, n++) {
+    v = v * 10 + (uint64_t)(*p - '0');
+  }
+  *value = v;
+  *digits = n;
+  return p;
+}
+
+static bool chunk_grow(EdgeChunk *chunk) {
+  size_t capacity = 2 * chunk->capacity;
+  uint64_t *src = (uint64_t *)realloc(chunk->src, capacity * sizeof(uint64_t));
+  if (src)
+    chunk->src = src;
+  uint64_t *dst = (uint64_t *)realloc(chunk->dst, capacity * sizeof(uint64_t));
+  if (dst)
+    chunk->dst = dst;
+  if (!src || !dst)
+    return false;
+  if (chunk->weights) {
+    uint32_t *weights =
+        (uint32_t *)realloc(chunk->weights, capacity * sizeof(uint32_t));
+    if (!weights)
+      return false;
+    chunk->weights = weights;
+  }
+  chunk->capacity = capacity;
+  return true;
+}
+
+// Switches the chunk to explicit weights, all EDGE_DEFAULT_WEIGHT so far
+static bool chunk_weights_init(EdgeChunk *chunk) {
+  chunk->weights = (uint32_t *)malloc(chunk->capacity * sizeof(uint32_t));
+  if (!chunk->weights)
+    return false;
+  for (size_t i = 0; i < chunk->count; i++) {
+    chunk->weights[i] = EDGE_DEFAULT_WEIGHT;
+  }
+  return true;
+}
+
+static void parse_chunk(const EdgeListState *state, EdgeChunk *chunk) {
+  const char *p = chunk->begin;
+  const char *end = chunk->end;
+  const char *limit = state->data + state->size;
+
+  chunk->capacity = (size_t)(end - p) / 8 + 16;
+  chunk->src = (uint64_t *)malloc(chunk->capacity * sizeof(uint64_t));
+  chunk->dst = (uint64_t *)malloc(chunk->capacity * sizeof(uint64_t));
+  if (!chunk->src || !chunk->dst) {
+    chunk->failed = true;
+    return;
+  }
+  while (p < end) {
+    const char *line = p;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+      p++;
+    }
+    if (p == end)
+      break;
+    if (*p == '#' || *p == '%') {
+      const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+      p = newline ? newline + 1 : end;
+      continue;
+    }
+    if (*p == '\r' && (p + 1 == end || p[1] == '\n'))
+      p++;
+    if (p == end)
+      break;
+    if (*p == '\n') {
+      p++;
+      continue; // Blank line
+    }
+
+    uint64_t fields[3];
+    int num_fields = 0;
+    while (num_fields < 3) {
+      int digits;
+      p = parse_digits(p, limit, &fields[num_fields], &digits);
+      if (digits == 0)
+        break;
+      if (digits > (num_fields < 2 ? 16 : 10)) {
+        num_fields = -1;
+        break;
+      }
+      num_fields++;
+      const char *field_end = p;
+      while (p < end && is_separator(*p)) {
+        p++;
+      }
+      if (p == end || *p == '\n' || *p == '\r' || p == field_end)
+        break;
+    }
+    if (p < end && *p == '\r')
+      p++;
+    if (p < end && *p == '\n') {
+      p++;
+    } else if (p < end) {
+      num_fields = -1;
+    }
+    if (num_fields < 2 || fields[0] > EDGELIST_MAX_ID ||
+        fields[1] > EDGELIST_MAX_ID ||
+        (num_fields == 3 && fields[2] > UINT32_MAX)) {
+      chunk->error = line;
+      return;
+    }
+
+    if (chunk->count == chunk->capacity && !chunk_grow(chunk)) {
+      chunk->failed = true;
+      return;
+    }
+    if (num_fields == 3 && !chunk->weights && !chunk_weights_init(chunk)) {
+      chunk->failed = true;
+      return;
+    }
+    chunk->src[chunk->count] = fields[0];
+    chunk->dst[chunk->count] = fields[1];
+    if (chunk->weights)
+      chunk->weights[chunk->count] =
+          num_fields == 3 ? (uint32_t)fields[2] : EDGE_DEFAULT_WEIGHT;
+    chunk->count++;
+    if (fields[0] > chunk->max_id)
+      chunk->max_id = fields[0];
+    if (fields[1] > chunk->max_id)
+      chunk->max_id = fields[1];
+  }
+}
+
+static void parse_worker(int thread, void *ctx) {
+  (void)thread;
+  EdgeListState *state = (EdgeListState *)ctx;
+  size_t c;
+  while ((c = atomic_fetch_add(&state->next_chunk, 1)) < state->num_chunks) {
+    parse_chunk(state, &state->chunks[c]);
+  }
+}
+
+// Splits the text at line starts into chunks of about equal size
+static bool split_chunks(EdgeListState *state) {
+  size_t count = (size_t)state->nthreads * EDGELIST_CHUNKS_PER_THREAD;
+  if (count < state->size / EDGELIST_MAX_CHUNK + 1)
+    count = state->size / EDGELIST_MAX_CHUNK + 1;
+  state->chunks = (EdgeChunk *)calloc(count, sizeof(EdgeChunk));
+  if (!state->chunks)
+    return false;
+  state->num_chunks = count;
+  const char *data = state->data;
+  const char *end = data + state->size;
+  const char *begin = data;
+  for (size_t c = 0; c < count; c++) {
+    const char *split = data + state->size * (c + 1) / count;
+    if (split < begin)
+      split = begin;
+    if (c + 1 < count && split > data && split < end && split[-1] != '\n') {
+      const char *newline =
+          (const char *)memchr(split, '\n', (size_t)(end - split));
+      split = newline ? newline + 1 : end;
+    }
+    state->chunks[c].begin = begin;
+    state->chunks[c].end = split;
+    begin = split;
+  }
+  return true;
+}
+
+static void mark_id(_Atomic uint64_t *bitmap, uint64_t id) {
+  uint64_t bit = 1ULL << (id & 63);
+  // Skipping bits already set keeps shared words from bouncing
+  if (!(atomic_load_explicit(&bitmap[id >> 6], memory_order_relaxed) & bit))
+    atomic_fetch_or_explicit(&bitmap[id >> 6], bit, memory_order_relaxed);
+}
+
+static void mark_worker(int thread, void *ctx) {
+  (void)thread;
+  EdgeListState *state = (EdgeListState *)ctx;
+  size_t c;
+  while ((c = atomic_fetch_add(&state->next_chunk, 1)) < state->num_chunks) {
+    EdgeChunk *chunk = &state->chunks[c];
+    for (size_t i = 0; i < chunk->count; i++) {
+      mark_id(state->bitmap, chunk->src[i]);
+      mark_id(state->bitmap, chunk->dst[i]);
+    }
+  }
+}
+
+// LSD radix sort over the bytes that max_id spans
+static bool sort_ids(uint64_t *ids, size_t n, uint64_t max_id) {
+  uint64_t *tmp = (uint64_t *)malloc(n * sizeof(uint64_t));
+  if (!tmp)
+    return false;
+  uint64_t *from = ids, *to = tmp;
+  for (int shift = 0; shift < 64 && (max_id >> shift); shift += 8) {
+    size_t offsets[256] = {0};
+    for (size_t i = 0; i < n; i++) {
+      offsets[(from[i] >> shift) & 255]++;
+    }
+    size_t sum = 0;
+    for (int b = 0; b < 256; b++) {
+      size_t count = offsets[b];
+      offsets[b] = sum;
+      sum += count;
+    }
+    for (size_t i = 0; i < n; i++) {
+      to[offsets[(from[i] >> shift) & 255]++] = from[i];
+    }
+    uint64_t *swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from != ids)
+    memcpy(ids, from, n * sizeof(uint64_t));
+  free(tmp);
+  return true;
+}
+
+// Numbers the distinct ids 0 .. num_nodes - 1 in ascending order
+static bool rank_ids(EdgeListState *state, size_t edges, uint64_t max_id) {
+  size_t words = (size_t)(max_id >> 6) + 1;
+  if (words <= edges + 1) {
+    state->bitmap =
+        (_Atomic uint64_t *)calloc(words, sizeof(_Atomic uint64_t));
+    state->ranks = (uint64_t *)malloc(words * sizeof(uint64_t));
+    if (!state->bitmap || !state->ranks)
+      return false;
+    atomic_store(&state->next_chunk, 0);
+    if (parallel_run(state->nthreads, mark_worker, state) < 0)
+      return false;
+    size_t rank = 0;
+    for (size_t w = 0; w < words; w++) {
+      state->ranks[w] = rank;
+      rank += (size_t)__builtin_popcountll(
+          atomic_load_explicit(&state->bitmap[w], memory_order_relaxed));
+    }
+    state->num_nodes = rank;
+    return true;
+  }
+  state->ids = (uint64_t *)malloc(2 * edges * sizeof(uint64_t));
+  if (!state->ids)
+    return false;
+  size_t n = 0;
+  for (size_t c = 0; c < state->num_chunks; c++) {
+    EdgeChunk *chunk = &state->chunks[c];
+    memcpy(state->ids + n, chunk->src, chunk->count * sizeof(uint64_t));
+    n += chunk->count;
+    memcpy(state->ids + n, chunk->dst, chunk->count * sizeof(uint64_t));
+    n += chunk->count;
+  }
+  if (!sort_ids(state->ids, n, max_id))
+    return false;
+  size_t distinct = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (distinct == 0 || state->ids[i] != state->ids[distinct - 1])
+      state->ids[distinct++] = state->ids[i];
+  }
+  state->num_nodes = distinct;
+  return true;
+}
+
+static bool create_nodes(EdgeListState *state) {
+  state->graph = graph_create(state->num_nodes);
+  if (!state->graph)
+    return false;
+  if (state->ids) {
+    for (size_t i = 0; i < state->num_nodes; i++) {
+      if (!graph_add_node(state->graph, NULL, (double)state->ids[i]))
+        return false;
+    }
+    return true;
+  }
+  for (size_t w = 0; state->graph->num_nodes < state->num_nodes; w++) {
+    uint64_t bits =
+        atomic_load_explicit(&state->bitmap[w], memory_order_relaxed);
+    while (bits) {
+      uint64_t id = ((uint64_t)w << 6) | (uint64_t)__builtin_ctzll(bits);
+      if (!graph_add_node(state->graph, NULL, (double)id))
+        return false;
+      bits &= bits - 1;
+    }
+  }
+  return true;
+}
+
+static uint64_t id_index(const EdgeListState *state, uint64_t id) {
+  if (state->bitmap) {
+    uint64_t bits =
+        atomic_load_explicit(&state->bitmap[id >> 6], memory_order_relaxed);
+    return state->ranks[id >> 6] +
+           (uint64_t)__builtin_popcountll(bits & ((1ULL << (id & 63)) - 1));
+  }
+  size_t lo = 0, hi = state->num_nodes;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (state->ids[mid] < id)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Thread that fills the sets of the node with this index
+static int owner(const EdgeListState *state, uint64_t index) {
+  return (int)(index * (uint64_t)state->nthreads / state->num_nodes);
+}
+
+// Turns ids into node indices and, with several threads, lists the edges
+// each thread needs in file order, so no thread scans every edge
+static void resolve_worker(int thread, void *ctx) {
+  (void)thread;
+  EdgeListState *state = (EdgeListState *)ctx;
+  bool dst_role = state->directed || state->bidirectional;
+  int nthreads = state->nthreads;
+  size_t c;
+  while ((c = atomic_fetch_add(&state->next_chunk, 1)) < state->num_chunks) {
+    EdgeChunk *chunk = &state->chunks[c];
+    for (size_t i = 0; i < chunk->count; i++) {
+      chunk->src[i] = id_index(state, chunk->src[i]);
+      chunk->dst[i] = id_index(state, chunk->dst[i]);
+    }
+    if (nthreads == 1 || chunk->count == 0)
+      continue;
+    chunk->owned_start = (size_t *)calloc((size_t)nthreads + 1, sizeof(size_t));
+    size_t *start = chunk->owned_start;
+    if (!start) {
+      atomic_store(&state->failed, true);
+      continue;
+    }
+    for (size_t i = 0; i < chunk->count; i++) {
+      int a = owner(state, chunk->src[i]);
+      start[a + 1]++;
+      if (dst_role) {
+        int b = owner(state, chunk->dst[i]);
+        start[b + 1] += b != a;
+      }
+    }
+    for (int t = 0; t < nthreads; t++) {
+      start[t + 1] += start[t];
+    }
+    chunk->owned = (uint32_t *)malloc(start[nthreads] * sizeof(uint32_t));
+    if (!chunk->owned) {
+      atomic_store(&state->failed, true);
+      continue;
+    }
+    // Fill through the starts, then shift them back into place
+    for (size_t i = 0; i < chunk->count; i++) {
+      int a = owner(state, chunk->src[i]);
+      chunk->owned[start[a]++] = (uint32_t)i;
+      if (dst_role) {
+        int b = owner(state, chunk->dst[i]);
+        if (b != a)
+          chunk->owned[start[b]++] = (uint32_t)i;
+      }
+    }
+    memmove(start + 1, start, (size_t)nthreads * sizeof(size_t));
+    start[0] = 0;
+  }
+}
+
+static NodeSet *kind_set(Node *node, int kind) {
+  return kind == KIND_EDGES      ? node->edges
+         : kind == KIND_OUTGOING ? node->outgoing
+                                 : node->incoming;
+}
+
+// One thread's share of the nodes. The entries each node and kind
+// receives are gathered as node indices first, then deduplicated against a
+// bitmap over all nodes and copied into the set.
+typedef struct {
+  size_t start, end;
+  size_t *offsets;   // Per node and kind, into targets; one extra at the end
+  uint32_t *targets; // Node index of every entry
+  uint32_t *weights; // Alongside targets, NULL when unweighted
+  uint64_t *seen;
+} BuildRange;
+
+// Counts or records one entry of node at's set of this kind
+static void visit(BuildRange *range, bool fill, uint64_t at, int kind,
+                  uint64_t other, uint32_t weight) {
+  size_t slot = (at - range->start) * KINDS + (size_t)kind;
+  if (!fill) {
+    range->offsets[slot + 1]++;
+    return;
+  }
+  size_t pos = range->offsets[slot]++;
+  range->targets[pos] = (uint32_t)other;
+  if (range->weights)
+    range->weights[pos] = weight;
+}
+
+// Counts (fill false) or records (fill true) the entries each node in the
+// range receives, walking the thread's edges in file order
+static void build_pass(const EdgeListState *state, int thread,
+                       BuildRange *range, bool fill) {
+  for (size_t c = 0; c < state->num_chunks; c++) {
+    const EdgeChunk *chunk = &state->chunks[c];
+    size_t n = chunk->count;
+    const uint32_t *owned = NULL;
+    if (chunk->owned) {
+      owned = chunk->owned + chunk->owned_start[thread];
+      n = chunk->owned_start[thread + 1] - chunk->owned_start[thread];
+    }
+    for (size_t k = 0; k < n; k++) {
+      size_t i = owned ? owned[k] : k;
+      uint64_t s = chunk->src[i];
+      uint64_t d = chunk->dst[i];
+      uint32_t w = chunk->weights ? chunk->weights[i] : EDGE_DEFAULT_WEIGHT;
+      if (s >= range->start && s < range->end) {
+        visit(range, fill, s, KIND_EDGES, d, w);
+        if (state->directed)
+          visit(range, fill, s, KIND_OUTGOING, d, w);
+      }
+      if (d >= range->start && d < range->end) {
+        if (state->directed)
+          visit(range, fill, d, KIND_INCOMING, s, w);
+        if (state->bidirectional)
+          visit(range, fill, d, KIND_EDGES, s, w);
+      }
+    }
+  }
+}
+
+// Bitmap updates that report whether the bit was set before
+static bool test_and_set(uint64_t *seen, uint32_t index) {
+  uint64_t bit = 1ULL << (index & 63);
+  bool was_set = seen[index >> 6] & bit;
+  seen[index >> 6] |= bit;
+  return was_set;
+}
+
+static bool test_and_clear(uint64_t *seen, uint32_t index) {
+  uint64_t bit = 1ULL << (index & 63);
+  bool was_set = seen[index >> 6] & bit;
+  seen[index >> 6] &= ~bit;
+  return was_set;
+}
+
+// Copies one node and kind's entries into its (fresh) set, first
+// occurrences in order. Returns the number of repeats dropped, or
+// SIZE_MAX on allocation failure.
+static size_t fill_set(const EdgeListState *state, BuildRange *range,
+                       size_t slot, NodeSet *set) {
+  Node **nodes = state->graph->nodes;
+  const uint32_t *targets = range->targets + range->offsets[slot];
+  const uint32_t *weights =
+      range->weights ? range->weights + range->offsets[slot] : NULL;
+  size_t count = range->offsets[slot + 1] - range->offsets[slot];
+
+  // Marking counts the distinct entries for the reservation; the copy
+  // then takes each entry whose mark is still there and clears it
+  size_t distinct = 0;
+  for (size_t i = 0; i < count; i++) {
+    distinct += !test_and_set(range->seen, targets[i]);
+  }
+  if (!nodeset_reserve(set, set->size + distinct, weights != NULL))
+    return SIZE_MAX;
+  for (size_t i = 0; i < count; i++) {
+    if (test_and_clear(range->seen, targets[i])) {
+      if (weights)
+        set->weights[set->size] = weights[i];
+      set->nodes[set->size++] = nodes[targets[i]];
+    }
+  }
+  // Large sets need their index; nodeset_dedup builds it
+  if (set->size > NODESET_INDEX_THRESHOLD)
+    nodeset_dedup(set);
+  // Repeats overwrite the weight in order, so the last one sticks
+  if (weights && distinct < count) {
+    for (size_t i = 0; i < count; i++) {
+      if (test_and_set(range->seen, targets[i]))
+        nodeset_add_weighted(set, nodes[targets[i]], weights[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+      test_and_clear(range->seen, targets[i]);
+    }
+  }
+  return count - distinct;
+}
+
+static void build_worker(int thread, void *ctx) {
+  EdgeListState *state = (EdgeListState *)ctx;
+  size_t n = state->num_nodes;
+  size_t t = (size_t)state->nthreads;
+  BuildRange range = {0};
+  range.start = ((size_t)thread * n + t - 1) / t;
+  range.end = (((size_t)thread + 1) * n + t - 1) / t;
+  if (range.start >= range.end)
+    return;
+  size_t slots = (range.end - range.start) * KINDS;
+  bool ok = false;
+  range.offsets = (size_t *)calloc(slots + 1, sizeof(size_t));
+  range.seen = (uint64_t *)calloc(n / 64 + 1, sizeof(uint64_t));
+  if (range.offsets && range.seen) {
+    build_pass(state, thread, &range, false);
+    for (size_t slot = 0; slot < slots; slot++) {
+      range.offsets[slot + 1] += range.offsets[slot];
+    }
+    size_t total = range.offsets[slots];
+    range.targets = (uint32_t *)malloc(total * sizeof(uint32_t) + 1);
+    if (state->weighted)
+      range.weights = (uint32_t *)malloc(total * sizeof(uint32_t) + 1);
+    ok = range.targets && (!state->weighted || range.weights);
+  }
+  if (ok) {
+    // Fill through the offsets, then shift them back into place
+    build_pass(state, thread, &range, true);
+    memmove(range.offsets + 1, range.offsets, slots * sizeof(size_t));
+    range.offsets[0] = 0;
+    size_t duplicates = 0;
+    for (size_t slot = 0; ok && slot < slots; slot++) {
+      Node *node = state->graph->nodes[range.start + slot / KINDS];
+      size_t dropped =
+          fill_set(state, &range, slot, kind_set(node, (int)(slot % KINDS)));
+      ok = dropped != SIZE_MAX;
+      duplicates += dropped;
+    }
+    atomic_fetch_add(&state->duplicates, duplicates);
+  }
+  if (!ok)
+    atomic_store(&state->failed, true);
+  free(range.offsets);
+  free(range.targets);
+  free(range.weights);
+  free(range.seen);
+}
+
+static void state_release(EdgeListState *state) {
+  for (size_t c = 0; c < state->num_chunks; c++) {
+    free(state->chunks[c].src);
+    free(state->chunks[c].dst);
+    free(state->chunks[c].weights);
+    free(state->chunks[c].owned);
+    free(state->chunks[c].owned_start);
+  }
+  free(state->chunks);
+  free((void *)state->bitmap);
+  free(state->ranks);
+  free(state->ids);
+}
+
+// First line number of a position in the text
+static size_t line_number(const char *data, const char *at) {
+  size_t line = 1;
+  for (const char *p = data;
+       (p = (const char *)memchr(p, '\n', (size_t)(at - p))); p++) {
+    line++;
+  }
+  return line;
+}
+
+static bool edgelist_build(EdgeListState *state, EdgeListStats *stats) {
+  if (!split_chunks(state) ||
+      parallel_run(state->nthreads, parse_worker, state) < 0)
+    return false;
+  size_t edges = 0;
+  uint64_t max_id = 0;
+  for (size_t c = 0; c < state->num_chunks; c++) {
+    EdgeChunk *chunk = &state->chunks[c];
+    if (chunk->error) {
+      stats->bad_line = line_number(state->data, chunk->error);
+      return false;
+    }
+    if (chunk->failed)
+      return false;
+    edges += chunk->count;
+    if (chunk->max_id > max_id)
+      max_id = chunk->max_id;
+    state->weighted |= chunk->weights != NULL;
+  }
+  stats->edges = edges;
+
+  // Adjacency is gathered as 32-bit node indices
+  if (!rank_ids(state, edges, max_id) || state->num_nodes > UINT32_MAX ||
+      !create_nodes(state))
+    return false;
+  if (state->num_nodes == 0)
+    return true;
+  atomic_store(&state->next_chunk, 0);
+  if (parallel_run(state->nthreads, resolve_worker, state) < 0 ||
+      atomic_load(&state->failed) ||
+      parallel_run(state->nthreads, build_worker, state) < 0 ||
+      atomic_load(&state->failed))
+    return false;
+  stats->duplicates = atomic_load(&state->duplicates);
+  return true;
+}
+
+Graph *edgelist_parse(const char *data, size_t size,
+                      const EdgeListOptions *options, EdgeListStats *stats) {
+  EdgeListStats local;
+  if (!stats)
+    stats = &local;
+  memset(stats, 0, sizeof(*stats));
+  if (!data && size)
+    return NULL;
+
+  EdgeListState state;
+  memset(&state, 0, sizeof(state));
+  state.data = data;
+  state.size = size;
+  state.nthreads = parallel_default_threads();
+  if (options) {
+    state.directed = options->directed;
+    state.bidirectional = options->bidirectional;
+    if (options->nthreads > 0)
+      state.nthreads = options->nthreads;
+  }
+  atomic_init(&state.next_chunk, 0);
+  atomic_init(&state.duplicates, 0);
+  atomic_init(&state.failed, false);
+  if (!edgelist_build(&state, stats)) {
+    graph_destroy(state.graph);
+    state.graph = NULL;
+  }
+  state_release(&state);
+  return state.graph;
+}
+
+Graph *edgelist_load(const char *path, const EdgeListOptions *options,
+                     EdgeListStats *stats) {
+  if (!path)
+    return NULL;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = (size_t)st.st_size;
+  if (size == 0) {
+    close(fd);
+    return edgelist_parse("", 0, options, stats);
+  }
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return NULL;
+  madvise(data, size, MADV_SEQUENTIAL);
+  Graph *graph = edgelist_parse((const char *)data, size, options, stats);
+  munmap(data, size);
+  return graph;
+}
@@ -0,0 +1,268 @@
+#include "graph.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Lookups probe this many ids ahead in graph_find_batch
+#define GRAPH_BATCH 16
+
+// Tombstones are swept once they outnumber the live nodes / this
+#define GRAPH_COMPACT_RATIO 8
+
+// Bit pattern of an id, with -0.0 folded into 0.0
+static uint64_t id_bits(double node_id) {
+  uint64_t bits;
+  if (node_id == 0.0)
+    node_id = 0.0;
+  memcpy(&bits, &node_id, sizeof(bits));
+  return bits;
+}
+
+static size_t hash_bits(uint64_t x) {
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+// Slot holding key, or the empty slot where it belongs
+static size_t find_slot(const Graph *graph, uint64_t key, size_t slot) {
+  while (graph->slots[slot].node && graph->slots[slot].key != key) {
+    slot = (slot + 1) & graph->mask;
+  }
+  return slot;
+}
+
+// Inserts every node into an empty table
+static void index_fill(Graph *graph) {
+  for (size_t i = 0; i < graph->num_nodes; i++) {
+    uint64_t key = id_bits(graph->nodes[i]->node_id);
+    size_t slot = find_slot(graph, key, hash_bits(key) & graph->mask);
+    graph->slots[slot].key = key;
+    graph->slots[slot].node = graph->nodes[i];
+    graph->slots[slot].index = i;
+  }
+}
+
+static bool index_resize(Graph *graph, size_t slots) {
+  GraphSlot *table = (GraphSlot *)calloc(slots, sizeof(GraphSlot));
+  if (!table)
+    return false;
+  free(graph->slots);
+  graph->slots = table;
+  graph->mask = slots - 1;
+  index_fill(graph);
+  return true;
+}
+
+Graph *graph_create(size_t expected_nodes) {
+  Graph *graph = (Graph *)calloc(1, sizeof(Graph));
+  if (!graph)
+    return NULL;
+  size_t slots = 16;
+  while (slots < 2 * expected_nodes) {
+    slots *= 2;
+  }
+  graph->capacity = expected_nodes ? expected_nodes : 16;
+  graph->arena = arena_create(expected_nodes);
+  graph->nodes = (Node **)malloc(graph->capacity * sizeof(Node *));
+  if (!graph->arena || !graph->nodes || !index_resize(graph, slots)) {
+    graph_destroy(graph);
+    return NULL;
+  }
+  return graph;
+}
+
+void graph_destroy(Graph *graph) {
+  if (!graph)
+    return;
+  nodeset_destroy(graph->removed);
+  arena_destroy(graph->arena);
+  free(graph->nodes);
+  free(graph->slots);
+  free(graph);
+}
+
+Node *graph_add_node(Graph *graph, void *value, double node_id) {
+  if (!graph || isnan(node_id))
+    return NULL;
+  if (2 * (graph->num_nodes + 1) > graph->mask + 1 &&
+      !index_resize(graph, 2 * (graph->mask + 1)))
+    return NULL;
+  uint64_t key = id_bits(node_id);
+  size_t slot = find_slot(graph, key, hash_bits(key) & graph->mask);
+  if (graph->slots[slot].node)
+    return NULL;
+  if (graph->num_nodes == graph->capacity) {
+    size_t capacity = 2 * graph->capacity;
+    Node **nodes = (Node **)realloc(graph->nodes, capacity * sizeof(Node *));
+    if (!nodes)
+      return NULL;
+    graph->nodes = nodes;
+    graph->capacity = capacity;
+  }
+  Node *node = arena_create_node(graph->arena, value, node_id);
+  if (!node)
+    return NULL;
+  graph->slots[slot].key = key;
+  graph->slots[slot].node = node;
+  graph->slots[slot].index = graph->num_nodes;
+  graph->nodes[graph->num_nodes++] = node;
+  return node;
+}
+
+// Backward-shift deletion, as in NodeSet's index
+static void index_erase(Graph *graph, size_t slot) {
+  size_t hole = slot;
+  for (size_t i = (slot + 1) & graph->mask; graph->slots[i].node;
+       i = (i + 1) & graph->mask) {
+    size_t home = hash_bits(graph->slots[i].key) & graph->mask;
+    if (((i - home) & graph->mask) >= ((i - hole) & graph->mask)) {
+      graph->slots[hole] = graph->slots[i];
+      hole = i;
+    }
+  }
+  graph->slots[hole].node = NULL;
+}
+
+bool graph_remove_node(Graph *graph, double node_id) {
+  if (!graph || isnan(node_id))
+    return false;
+  uint64_t key = id_bits(node_id);
+  size_t slot = find_slot(graph, key, hash_bits(key) & graph->mask);
+  Node *node = graph->slots[slot].node;
+  if (!node)
+    return false;
+  // Room for the tombstone first, so a failure changes nothing
+  if (!graph->removed && !(graph->removed = nodeset_create(16)))
+    return false;
+  NodeSet *removed = graph->removed;
+  if (removed->size == removed->capacity &&
+      !nodeset_reserve(removed, 2 * removed->capacity, false))
+    return false;
+  size_t index = graph->slots[slot].index;
+  index_erase(graph, slot);
+  size_t last = --graph->num_nodes;
+  if (index != last) {
+    Node *moved = graph->nodes[last];
+    uint64_t moved_key = id_bits(moved->node_id);
+    graph->nodes[index] = moved;
+    size_t home = hash_bits(moved_key) & graph->mask;
+    graph->slots[find_slot(graph, moved_key, home)].index = index;
+  }
+  unlink_node(node);
+  nodeset_add(removed, node);
+  // One sweep per num_nodes / GRAPH_COMPACT_RATIO removals keeps the
+  // amortized cost of a removal O(degree)
+  if (removed->size > graph->num_nodes / GRAPH_COMPACT_RATIO)
+    graph_compact(graph);
+  return true;
+}
+
+void graph_compact(Graph *graph) {
+  if (!graph || !graph->removed)
+    return;
+  NodeSet *removed = graph->removed;
+  // Each set is probed for every tombstone or, when the set is the smaller
+  // one, its members are looked up among the tombstones
+  for (size_t i = 0; i < graph->num_nodes; i++) {
+    NodeSet *set = graph->nodes[i]->edges;
+    if (removed->size <= set->size) {
+      for (size_t r = 0; r < removed->size; r++) {
+        nodeset_swap_remove(set, removed->nodes[r]);
+      }
+    } else {
+      for (size_t j = 0; j < set->size;) {
+        if (nodeset_contains(removed, set->nodes[j]))
+          nodeset_swap_remove(set, set->nodes[j]);
+        else
+          j++;
+      }
+    }
+  }
+  // Nothing points at the tombstones now, so their slots may be reused
+  for (size_t r = 0; r < removed->size; r++) {
+    destroy_node(removed->nodes[r]);
+  }
+  nodeset_destroy(removed);
+  graph->removed = NULL;
+}
+
+Node *graph_find(const Graph *graph, double node_id) {
+  if (!graph || isnan(node_id))
+    return NULL;
+  uint64_t key = id_bits(node_id);
+  return graph->slots[find_slot(graph, key, hash_bits(key) & graph->mask)]
+      .node;
+}
+
+Node *graph_ensure_node(Graph *graph, double node_id) {
+  Node *node = graph_find(graph, node_id);
+  return node ? node : graph_add_node(graph, NULL, node_id);
+}
+
+size_t graph_find_batch(const Graph *graph, const double *ids, size_t count,
+                        Node **out) {
+  if (!graph || !ids || !out)
+    return 0;
+  size_t found = 0;
+  uint64_t keys[GRAPH_BATCH];
+  size_t slots[GRAPH_BATCH];
+  for (size_t base = 0; base < count; base += GRAPH_BATCH) {
+    size_t n = count - base < GRAPH_BATCH ? count - base : GRAPH_BATCH;
+    // Hash the whole group and prefetch its home slots before probing any
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = id_bits(ids[base + i]);
+      slots[i] = hash_bits(keys[i]) & graph->mask;
+      __builtin_prefetch(&graph->slots[slots[i]]);
+    }
+    for (size_t i = 0; i < n; i++) {
+      Node *node = NULL;
+      if (!isnan(ids[base + i]))
+        node = graph->slots[find_slot(graph, keys[i], slots[i])].node;
+      out[base + i] = node;
+      found += node != NULL;
+    }
+  }
+  return found;
+}
+
+size_t graph_num_nodes(const Graph *graph) {
+  return graph ? graph->num_nodes : 0;
+}
+
+bool graph_relocate(Graph *graph, Node **order) {
+  if (!graph || !order)
+    return false;
+  // The old arena goes away below, tombstones included
+  graph_compact(graph);
+  Node **relocated = (Node **)malloc(graph->capacity * sizeof(Node *));
+  if (!relocated)
+    return false;
+  GraphArena *arena = arena_relocate(order, graph->num_nodes, relocated);
+  if (!arena) {
+    free(relocated);
+    return false;
+  }
+  // The old nodes were destroyed into the old arena; release it whole
+  arena_destroy(graph->arena);
+  graph->arena = arena;
+  free(graph->nodes);
+  graph->nodes = relocated;
+  // Same ids, so the table keeps its size and is refilled in place
+  memset(graph->slots, 0, (graph->mask + 1) * sizeof(GraphSlot));
+  index_fill(graph);
+  return true;
+}
+
+bool graph_add_edge_by_id(Graph *graph, double a, double b, bool directed,
+                          bool bidirectional) {
+  Node *self = graph_find(graph, a);
+  Node *other = graph_find(graph, b);
+  if (!self || !other)
+    return false;
+  add_edge(self, other, directed, bidirectional);
+  return true;
+}
@@ -0,0 +1,332 @@
+#include "lca.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LCA_NONE UINT32_MAX
+
+static int floor_log2(size_t x) { return 63 - __builtin_clzll(x); }
+
+static void free_built(LCAIndex *index) {
+  free(index->nodes);
+  free(index->parent);
+  free(index->last);
+  free(index->depth);
+  for (int k = 0; k < index->levels; k++) {
+    free(index->sparse[k]);
+  }
+  free(index->sparse);
+  index->nodes = NULL;
+  index->parent = NULL;
+  index->last = NULL;
+  index->depth = NULL;
+  index->sparse = NULL;
+  index->levels = 0;
+  index->num_built = 0;
+}
+
+static void free_overlay(LCAIndex *index) {
+  free(index->overlay_nodes);
+  free(index->anchor);
+  free(index->overlay_depth);
+  free(index->overlay_up);
+  index->overlay_nodes = NULL;
+  index->anchor = NULL;
+  index->overlay_depth = NULL;
+  index->overlay_up = NULL;
+  index->num_overlay = 0;
+  index->overlay_capacity = 0;
+}
+
+static void clear_index(LCAIndex *index) {
+  free_built(index);
+  free_overlay(index);
+  nodemap_destroy(index->ids);
+  index->ids = NULL;
+}
+
+static uint32_t shallower(const LCAIndex *index, uint32_t a, uint32_t b) {
+  return index->depth[b] < index->depth[a] ? b : a;
+}
+
+// Shallowest built id in [l, r]
+static uint32_t range_min(const LCAIndex *index, uint32_t l, uint32_t r) {
+  int k = floor_log2(r - l + 1);
+  if (k == 0)
+    return l;
+  return shallower(index, index->sparse[k][l],
+                   index->sparse[k][r - (1u << k) + 1]);
+}
+
+static uint32_t built_lca(const LCAIndex *index, uint32_t a, uint32_t b) {
+  if (a > b) {
+    uint32_t tmp = a;
+    a = b;
+    b = tmp;
+  }
+  if (b <= index->last[a])
+    return a;
+  // The shallowest node strictly after a, up to b, is a child of the LCA
+  return index->parent[range_min(index, a + 1, b)];
+}
+
+bool lca_rebuild(LCAIndex *index) {
+  if (!index)
+    return false;
+  clear_index(index);
+  int count = num_nodes(index->root);
+  if (count <= 0)
+    return false;
+  size_t n = (size_t)count;
+
+  index->nodes = (Node **)malloc(n * sizeof(Node *));
+  index->parent = (uint32_t *)malloc(n * sizeof(uint32_t));
+  index->last = (uint32_t *)malloc(n * sizeof(uint32_t));
+  index->depth = (int *)malloc(n * sizeof(int));
+  // Room for the overlay too, so attaches never rehash the whole map
+  index->ids = nodemap_create(n + (size_t)(n * LCA_REBUILD_FRACTION) + 1);
+  if (!index->nodes || !index->parent || !index->last || !index->depth ||
+      !index->ids) {
+    clear_index(index);
+    return false;
+  }
+  n = preorder_flatten(index->root, n, index->nodes, index->parent,
+                       index->last, index->ids);
+  if (n == 0) {
+    clear_index(index);
+    return false;
+  }
+  index->num_built = n;
+  // A parent's id is smaller than its children's
+  for (size_t i = 0; i < n; i++) {
+    uint32_t parent = index->parent[i];
+    index->depth[i] = parent == LCA_NONE ? 0 : index->depth[parent] + 1;
+  }
+
+  // Level 0 is the identity and is not stored
+  index->levels = floor_log2(n) + 1;
+  index->sparse = (uint32_t **)calloc(index->levels, sizeof(uint32_t *));
+  if (!index->sparse) {
+    index->levels = 0;
+    clear_index(index);
+    return false;
+  }
+  for (int k = 1; k < index->levels; k++) {
+    size_t span = (size_t)1 << k, half = span / 2;
+    size_t count_k = n - span + 1;
+    uint32_t *row = (uint32_t *)malloc(count_k * sizeof(uint32_t));
+    if (!row) {
+      clear_index(index);
+      return false;
+    }
+    for (size_t i = 0; i < count_k; i++) {
+      uint32_t left = k == 1 ? (uint32_t)i : index->sparse[k - 1][i];
+      uint32_t right =
+          k == 1 ? (uint32_t)(i + half) : index->sparse[k - 1][i + half];
+      row[i] = shallower(index, left, right);
+    }
+    index->sparse[k] = row;
+  }
+  return true;
+}
+
+LCAIndex *lca_create(Node *root) {
+  if (!root)
+    return NULL;
+  LCAIndex *index = (LCAIndex *)calloc(1, sizeof(LCAIndex));
+  if (!index)
+    return NULL;
+  index->root = root;
+  if (!lca_rebuild(index)) {
+    free(index);
+    return NULL;
+  }
+  return index;
+}
+
+void lca_destroy(LCAIndex *index) {
+  if (!index)
+    return;
+  clear_index(index);
+  free(index);
+}
+
+static bool lookup(const LCAIndex *index, Node *node, uint32_t *id) {
+  size_t value;
+  if (!index || !node || !nodemap_get(index->ids, node, &value))
+    return false;
+  *id = (uint32_t)value;
+  return true;
+}
+
+static int depth_of(const LCAIndex *index, uint32_t id) {
+  return id < index->num_built ? index->depth[id]
+                               : index->overlay_depth[id - index->num_built];
+}
+
+static Node *node_of(const LCAIndex *index, uint32_t id) {
+  return id < index->num_built ? index->nodes[id]
+                               : index->overlay_nodes[id - index->num_built];
+}
+
+static bool grow_overlay(LCAIndex *index) {
+  size_t capacity = index->overlay_capacity ? 2 * index->overlay_capacity : 64;
+  Node **nodes =
+      (Node **)realloc(index->overlay_nodes, capacity * sizeof(Node *));
+  if (nodes)
+    index->overlay_nodes = nodes;
+  uint32_t *anchor =
+      (uint32_t *)realloc(index->anchor, capacity * sizeof(uint32_t));
+  if (anchor)
+    index->anchor = anchor;
+  int *depth = (int *)realloc(index->overlay_depth, capacity * sizeof(int));
+  if (depth)
+    index->overlay_depth = depth;
+  uint32_t *up = (uint32_t *)realloc(
+      index->overlay_up, capacity * LCA_LIFT_LEVELS * sizeof(uint32_t));
+  if (up)
+    index->overlay_up = up;
+  if (!nodes || !anchor || !depth || !up)
+    return false;
+  index->overlay_capacity = capacity;
+  return true;
+}
+
+// Adds one node whose parent has the given id
+static bool add_overlay(LCAIndex *index, Node *node, uint32_t parent) {
+  if (index->num_overlay == index->overlay_capacity && !grow_overlay(index))
+    return false;
+  size_t j = index->num_overlay;
+  uint32_t *up = &index->overlay_up[j * LCA_LIFT_LEVELS];
+  bool parent_built = parent < index->num_built;
+  index->overlay_nodes[j] = node;
+  index->anchor[j] =
+      parent_built ? parent : index->anchor[parent - index->num_built];
+  index->overlay_depth[j] = depth_of(index, parent) + 1;
+  // Jumps stay inside the overlay; LCA_NONE once they would leave it
+  up[0] = parent_built ? LCA_NONE : parent - (uint32_t)index->num_built;
+  for (int k = 1; k < LCA_LIFT_LEVELS; k++) {
+    up[k] = up[k - 1] == LCA_NONE
+                ? LCA_NONE
+                : index->overlay_up[up[k - 1] * LCA_LIFT_LEVELS + k - 1];
+  }
+  if (!nodemap_put(index->ids, node, index->num_built + j))
+    return false;
+  index->num_overlay++;
+  return true;
+}
+
+bool lca_attach(LCAIndex *index, Node *node) {
+  uint32_t parent;
+  if (!index || !node || !lookup(index, node->parent, &parent))
+    return false;
+
+  size_t top = 0, capacity = 64;
+  Node **stack = (Node **)malloc(capacity * sizeof(Node *));
+  if (!stack)
+    return false;
+  bool ok = add_overlay(index, node, parent);
+  stack[top++] = node;
+  while (ok && top) {
+    Node *current = stack[--top];
+    uint32_t id = 0;
+    lookup(index, current, &id);
+    NodeSet *children = current->children;
+    for (size_t i = 0; ok && i < nodeset_size(children); i++) {
+      Node *child = children->nodes[i];
+      if (top == capacity) {
+        Node **grown =
+            (Node **)realloc(stack, 2 * capacity * sizeof(Node *));
+        if (!grown) {
+          ok = false;
+          break;
+        }
+        stack = grown;
+        capacity *= 2;
+      }
+      ok = add_overlay(index, child, id);
+      stack[top++] = child;
+    }
+  }
+  free(stack);
+
+  if (ok && index->num_overlay > index->num_built * LCA_REBUILD_FRACTION)
+    return lca_rebuild(index);
+  return ok;
+}
+
+// LCA of two overlay nodes with the same anchor, or LCA_NONE when their
+// only common ancestors are built nodes
+static uint32_t overlay_lca(const LCAIndex *index, uint32_t u, uint32_t v) {
+  const int *depth = index->overlay_depth;
+  const uint32_t *up = index->overlay_up;
+  if (depth[u] < depth[v]) {
+    uint32_t tmp = u;
+    u = v;
+    v = tmp;
+  }
+  for (int k = LCA_LIFT_LEVELS - 1; k >= 0; k--) {
+    uint32_t jump = up[u * LCA_LIFT_LEVELS + k];
+    if (jump != LCA_NONE && depth[jump] >= depth[v])
+      u = jump;
+  }
+  if (depth[u] != depth[v])
+    return LCA_NONE;
+  if (u == v)
+    return u;
+  for (int k = LCA_LIFT_LEVELS - 1; k >= 0; k--) {
+    uint32_t a = up[u * LCA_LIFT_LEVELS + k];
+    uint32_t b = up[v * LCA_LIFT_LEVELS + k];
+    if (a != LCA_NONE && b != LCA_NONE && a != b) {
+      u = a;
+      v = b;
+    }
+  }
+  uint32_t a = up[u * LCA_LIFT_LEVELS];
+  return a != LCA_NONE && a == up[v * LCA_LIFT_LEVELS] ? a : LCA_NONE;
+}
+
+static uint32_t lca_id(const LCAIndex *index, uint32_t u, uint32_t v) {
+  size_t built = index->num_built;
+  if (u < built && v < built)
+    return built_lca(index, u, v);
+  if (u < built)
+    return built_lca(index, u, index->anchor[v - built]);
+  if (v < built)
+    return built_lca(index, index->anchor[u - built], v);
+  uint32_t au = index->anchor[u - built], av = index->anchor[v - built];
+  if (au != av)
+    return built_lca(index, au, av);
+  uint32_t shared = overlay_lca(index, u - (uint32_t)built,
+                                v - (uint32_t)built);
+  return shared == LCA_NONE ? au : shared + (uint32_t)built;
+}
+
+Node *lca(const LCAIndex *index, Node *u, Node *v) {
+  uint32_t iu, iv;
+  if (!lookup(index, u, &iu) || !lookup(index, v, &iv))
+    return NULL;
+  return node_of(index, lca_id(index, iu, iv));
+}
+
+int lca_depth(const LCAIndex *index, Node *node) {
+  uint32_t id;
+  return lookup(index, node, &id) ? depth_of(index, id) : -1;
+}
+
+bool lca_is_ancestor(const LCAIndex *index, Node *ancestor, Node *node) {
+  uint32_t a, b;
+  if (!lookup(index, ancestor, &a) || !lookup(index, node, &b))
+    return false;
+  if (a < index->num_built && b < index->num_built)
+    return a <= b && b <= index->last[a];
+  return lca_id(index, a, b) == a;
+}
+
+int lca_distance(const LCAIndex *index, Node *u, Node *v) {
+  uint32_t iu, iv;
+  if (!lookup(index, u, &iu) || !lookup(index, v, &iv))
+    return -1;
+  return depth_of(index, iu) + depth_of(index, iv) -
+         2 * depth_of(index, lca_id(index, iu, iv));
+}
@@ -0,0 +1,240 @@
+#include "mpmc.h"
+#include "parallel.h"
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Nodes a traversal worker takes from the shared queue at a time
+#define MPMC_TRAVERSE_BATCH 32
+#define MPMC_TRAVERSE_CAPACITY 4096
+// Children are published while the shared queue holds fewer nodes than this
+#define MPMC_TRAVERSE_LOW (4 * MPMC_TRAVERSE_BATCH)
+
+MPMCQueue *mpmc_create(size_t capacity) {
+  size_t rounded = 2;
+  while (rounded < capacity)
+    rounded <<= 1;
+
+  MPMCQueue *queue =
+      (MPMCQueue *)aligned_alloc(MPMC_CACHE_LINE, sizeof(MPMCQueue));
+  if (!queue)
+    return NULL;
+  queue->cells = (MPMCCell *)malloc(rounded * sizeof(MPMCCell));
+  if (!queue->cells) {
+    free(queue);
+    return NULL;
+  }
+  for (size_t i = 0; i < rounded; i++) {
+    atomic_init(&queue->cells[i].sequence, i);
+    queue->cells[i].node = NULL;
+  }
+  queue->mask = rounded - 1;
+  atomic_init(&queue->enqueue_pos, 0);
+  atomic_init(&queue->dequeue_pos, 0);
+  return queue;
+}
+
+void mpmc_destroy(MPMCQueue *queue) {
+  if (queue) {
+    free(queue->cells);
+    free(queue);
+  }
+}
+
+size_t mpmc_capacity(const MPMCQueue *queue) {
+  return queue ? queue->mask + 1 : 0;
+}
+
+// Claims a run of up to count cells starting at *pos (the shared position
+// value in *shared) whose sequence equals position + ready_offset, i.e. the
+// cells are ready for this side in this lap. Returns the run length, 0 when
+// the queue is full (enqueue side) or empty (dequeue side).
+static size_t claim_cells(MPMCQueue *queue, atomic_size_t *shared,
+                          size_t count, size_t ready_offset, size_t *pos) {
+  *pos = atomic_load_explicit(shared, memory_order_relaxed);
+  while (1) {
+    size_t ready = 0;
+    while (ready < count) {
+      MPMCCell *cell = &queue->cells[(*pos + ready) & queue->mask];
+      size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+      if (seq != *pos + ready + ready_offset)
+        break;
+      ready++;
+    }
+
+    if (ready == 0) {
+      MPMCCell *cell = &queue->cells[*pos & queue->mask];
+      size_t seq = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(*pos + ready_offset);
+      if (diff < 0)
+        return 0;
+      // Another thread took this position; catch up
+      *pos = atomic_load_explicit(shared, memory_order_relaxed);
+      continue;
+    }
+
+    if (atomic_compare_exchange_weak_explicit(shared, pos, *pos + ready,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed))
+      return ready;
+  }
+}
+
+size_t mpmc_enqueue_batch(MPMCQueue *queue, Node *const *nodes, size_t count) {
+  if (!queue || !nodes || count == 0)
+    return 0;
+  size_t pos;
+  size_t claimed = claim_cells(queue, &queue->enqueue_pos, count, 0, &pos);
+  for (size_t i = 0; i < claimed; i++) {
+    MPMCCell *cell = &queue->cells[(pos + i) & queue->mask];
+    cell->node = nodes[i];
+    atomic_store_explicit(&cell->sequence, pos + i + 1, memory_order_release);
+  }
+  return claimed;
+}
+
+size_t mpmc_dequeue_batch(MPMCQueue *queue, Node **nodes, size_t count) {
+  if (!queue || !nodes || count == 0)
+    return 0;
+  size_t pos;
+  size_t claimed = claim_cells(queue, &queue->dequeue_pos, count, 1, &pos);
+  for (size_t i = 0; i < claimed; i++) {
+    MPMCCell *cell = &queue->cells[(pos + i) & queue->mask];
+    nodes[i] = cell->node;
+    // Ready for the producer one lap later
+    atomic_store_explicit(&cell->sequence, pos + i + queue->mask + 1,
+                          memory_order_release);
+  }
+  return claimed;
+}
+
+bool mpmc_enqueue(MPMCQueue *queue, Node *node) {
+  if (!node)
+    return false;
+  return mpmc_enqueue_batch(queue, &node, 1) == 1;
+}
+
+Node *mpmc_dequeue(MPMCQueue *queue) {
+  Node *node = NULL;
+  mpmc_dequeue_batch(queue, &node, 1);
+  return node;
+}
+
+size_t mpmc_size(const MPMCQueue *queue) {
+  if (!queue)
+    return 0;
+  size_t dequeued =
+      atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+  size_t enqueued =
+      atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+  return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+typedef struct {
+  MPMCQueue *queue;
+  atomic_size_t pending; // Published nodes not yet fully expanded
+  atomic_size_t visited;
+  atomic_int idle; // Threads waiting for the shared queue
+  void (*visit)(Node *, void *);
+  void *ctx;
+} TraverseState;
+
+// Visits node and queues its children: on the shared queue while some
+// thread is idle and the queue is running low, otherwise in this thread's
+// local queue, which keeps atomics off the common path.
+static void expand(TraverseState *state, Node *node, NodeQueue **local,
+                   size_t *visited) {
+  state->visit(node, state->ctx);
+  (*visited)++;
+  NodeSet *children = get_node_children(node);
+  size_t count = nodeset_size(children);
+  if (count == 0)
+    return;
+
+  size_t pushed = 0;
+  if (atomic_load_explicit(&state->idle, memory_order_relaxed) > 0 &&
+      mpmc_size(state->queue) < MPMC_TRAVERSE_LOW) {
+    // Published nodes join pending before another thread can retire them
+    atomic_fetch_add(&state->pending, count);
+    size_t moved;
+    while (pushed < count &&
+           (moved = mpmc_enqueue_batch(state->queue, children->nodes + pushed,
+                                       count - pushed)) > 0) {
+      pushed += moved;
+    }
+    if (pushed < count)
+      atomic_fetch_sub(&state->pending, count - pushed);
+  }
+  if (pushed < count && !*local)
+    *local = queue_create(count - pushed);
+  for (size_t i = pushed; i < count; i++) {
+    size_t before = *local ? (*local)->size : 0;
+    queue_enqueue(*local, children->nodes[i]);
+    // Out of memory: expand in place rather than lose the subtree
+    if (!*local || (*local)->size == before)
+      expand(state, children->nodes[i], local, visited);
+  }
+}
+
+static void traverse_worker(int thread, void *ctx) {
+  (void)thread;
+  TraverseState *state = (TraverseState *)ctx;
+  Node *batch[MPMC_TRAVERSE_BATCH];
+  NodeQueue *local = NULL;
+  size_t visited = 0;
+  bool idle = false;
+
+  while (1) {
+    size_t count =
+        mpmc_dequeue_batch(state->queue, batch, MPMC_TRAVERSE_BATCH);
+    if (count == 0) {
+      if (atomic_load(&state->pending) == 0)
+        break;
+      if (!idle) {
+        atomic_fetch_add(&state->idle, 1);
+        idle = true;
+      }
+      sched_yield();
+      continue;
+    }
+    if (idle) {
+      atomic_fetch_sub(&state->idle, 1);
+      idle = false;
+    }
+    for (size_t i = 0; i < count; i++) {
+      expand(state, batch[i], &local, &visited);
+    }
+    while (!queue_is_empty(local)) {
+      expand(state, queue_dequeue(local), &local, &visited);
+    }
+    // The batch is retired only once everything found under it was
+    // expanded or published, so pending cannot reach zero early
+    atomic_fetch_sub(&state->pending, count);
+  }
+  queue_destroy(local);
+  atomic_fetch_add(&state->visited, visited);
+}
+
+size_t mpmc_traverse(Node *root, int nthreads, void (*visit)(Node *, void *),
+                     void *ctx) {
+  if (!root || !visit)
+    return 0;
+  if (nthreads <= 0)
+    nthreads = parallel_default_threads();
+
+  TraverseState state;
+  state.queue = mpmc_create(MPMC_TRAVERSE_CAPACITY);
+  if (!state.queue)
+    return 0;
+  atomic_init(&state.pending, 1);
+  atomic_init(&state.visited, 0);
+  atomic_init(&state.idle, 0);
+  state.visit = visit;
+  state.ctx = ctx;
+  mpmc_enqueue(state.queue, root);
+
+  bool ran = parallel_run(nthreads, traverse_worker, &state) == 0;
+  mpmc_destroy(state.queue);
+  return ran ? atomic_load(&state.visited) : 0;
+}
@@ -1,31 +1,263 @@
 #include "node.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
-Node *create_node(void *value, double node_id) {
-  Node *node = (Node *)malloc(sizeof(Node));
-  if (!node)
-    return NULL;
+// A node with its sets laid out right behind it
+typedef struct NodeBlock {
+  Node node;
+  NodeSet sets[4];
+} NodeBlock;
+
+// Arena chunk sizes grow geometrically up to this many nodes
+#define ARENA_MIN_CHUNK 256
+#define ARENA_MAX_CHUNK 65536
+
+typedef struct ArenaChunk {
+  struct ArenaChunk *next;
+  size_t used;
+  size_t capacity;
+  NodeBlock blocks[];
+} ArenaChunk;
+
+struct GraphArena {
+  ArenaChunk *chunks; // Newest first; only the head has room
+  Node *free_list;    // Destroyed nodes, linked through parent
+  size_t live;
+  size_t next_chunk;
+  Node **storage; // Set members of relocated nodes, NULL otherwise
+};
+
+static void nodeset_init(NodeSet *set) {
+  set->nodes = set->inline_nodes;
+  set->size = 0;
+  set->capacity = NODESET_INLINE_CAPACITY;
+  set->index = NULL;
+  set->index_mask = 0;
+  set->weights = NULL;
+  set->borrowed = false;
+}
+
+// Frees spilled storage and leaves the set empty; safe to repeat
+static void nodeset_release(NodeSet *set) {
+  if (set->nodes != set->inline_nodes && !set->borrowed)
+    free(set->nodes);
+  free(set->index);
+  free(set->weights);
+  nodeset_init(set);
+}
 
+static Node *init_block(NodeBlock *block, void *value, double node_id,
+                        GraphArena *arena) {
+  Node *node = &block->node;
   node->value = value;
   node->node_id = node_id;
-  node->edges = nodeset_create(4);
-  node->incoming = nodeset_create(2);
-  node->outgoing = nodeset_create(2);
+  for (int i = 0; i < 4; i++) {
+    nodeset_init(&block->sets[i]);
+  }
+  node->edges = &block->sets[0];
+  node->incoming = &block->sets[1];
+  node->outgoing = &block->sets[2];
   node->parent = NULL;
-  node->children = nodeset_create(4);
+  node->children = &block->sets[3];
+  node->arena = arena;
+  node->cached_height = 0;
+  node->cached_size = 0;
+  node->cached_leaves = 0;
+  node->cached_diameter = 0;
+  node->aggregates_dirty = true;
   return node;
 }
 
+static void release_block(NodeBlock *block) {
+  for (int i = 0; i < 4; i++) {
+    nodeset_release(&block->sets[i]);
+  }
+}
+
+Node *create_node(void *value, double node_id) {
+  NodeBlock *block = (NodeBlock *)malloc(sizeof(NodeBlock));
+  if (!block)
+    return NULL;
+  return init_block(block, value, node_id, NULL);
+}
+
 void destroy_node(Node *node) {
-  if (node) {
-    nodeset_destroy(node->edges);
-    nodeset_destroy(node->incoming);
-    nodeset_destroy(node->outgoing);
-    nodeset_destroy(node->children);
-    free(node);
+  if (!node)
+    return;
+  // node is the first member of its block
+  NodeBlock *block = (NodeBlock *)node;
+  release_block(block);
+  if (node->arena) {
+    node->parent = node->arena->free_list;
+    node->arena->free_list = node;
+    node->arena->live--;
+  } else {
+    free(block);
+  }
+}
+
+// GraphArena implementation
+GraphArena *arena_create(size_t expected_nodes) {
+  GraphArena *arena = (GraphArena *)malloc(sizeof(GraphArena));
+  if (!arena)
+    return NULL;
+  arena->chunks = NULL;
+  arena->free_list = NULL;
+  arena->live = 0;
+  arena->next_chunk =
+      expected_nodes > ARENA_MIN_CHUNK ? expected_nodes : ARENA_MIN_CHUNK;
+  arena->storage = NULL;
+  return arena;
+}
+
+Node *arena_create_node(GraphArena *arena, void *value, double node_id) {
+  if (!arena)
+    return NULL;
+
+  NodeBlock *block;
+  if (arena->free_list) {
+    block = (NodeBlock *)arena->free_list;
+    arena->free_list = arena->free_list->parent;
+  } else {
+    ArenaChunk *chunk = arena->chunks;
+    if (!chunk || chunk->used == chunk->capacity) {
+      size_t capacity = arena->next_chunk;
+      chunk = (ArenaChunk *)malloc(sizeof(ArenaChunk) +
+                                   capacity * sizeof(NodeBlock));
+      if (!chunk)
+        return NULL;
+      chunk->next = arena->chunks;
+      chunk->used = 0;
+      chunk->capacity = capacity;
+      arena->chunks = chunk;
+      arena->next_chunk =
+          capacity * 2 < ARENA_MAX_CHUNK ? capacity * 2 : ARENA_MAX_CHUNK;
+    }
+    block = &chunk->blocks[chunk->used++];
+  }
+  arena->live++;
+  return init_block(block, value, node_id, arena);
+}
+
+size_t arena_num_nodes(const GraphArena *arena) {
+  return arena ? arena->live : 0;
+}
+
+void arena_destroy(GraphArena *arena) {
+  if (!arena)
+    return;
+  ArenaChunk *chunk = arena->chunks;
+  while (chunk) {
+    ArenaChunk *next = chunk->next;
+    // Recycled slots were already released, which is harmless to repeat
+    for (size_t i = 0; i < chunk->used; i++) {
+      release_block(&chunk->blocks[i]);
+    }
+    free(chunk);
+    chunk = next;
   }
+  free(arena->storage);
+  free(arena);
+}
+
+static bool index_rebuild(NodeSet *set);
+static size_t dedup_members(NodeSet *set, bool last_weight);
+static bool queue_push(NodeQueue *queue, Node *node);
+
+// New address of node if it is being relocated
+static Node *relocated_address(const NodeMap *map, ArenaChunk *chunk,
+                               Node *node) {
+  size_t i;
+  if (node && nodemap_get(map, node, &i))
+    return &chunk->blocks[i].node;
+  return node;
+}
+
+GraphArena *arena_relocate(Node **nodes, size_t count, Node **relocated) {
+  if (!nodes || !relocated)
+    return NULL;
+  GraphArena *arena = arena_create(0);
+  NodeMap *map = nodemap_create(count);
+  ArenaChunk *chunk = (ArenaChunk *)malloc(
+      sizeof(ArenaChunk) + (count ? count : 1) * sizeof(NodeBlock));
+  if (!arena || !map || !chunk) {
+    free(arena);
+    nodemap_destroy(map);
+    free(chunk);
+    return NULL;
+  }
+  size_t spilled = 0;
+  for (size_t i = 0; i < count; i++) {
+    Node *node = nodes[i];
+    nodemap_put(map, node, i);
+    NodeSet *sets[4] = {node->edges, node->incoming, node->outgoing,
+                        node->children};
+    for (int k = 0; k < 4; k++) {
+      if (sets[k]->size > NODESET_INLINE_CAPACITY)
+        spilled += sets[k]->size;
+    }
+  }
+  chunk->next = NULL;
+  chunk->used = 0;
+  chunk->capacity = count;
+  arena->chunks = chunk;
+  arena->storage = (Node **)malloc((spilled ? spilled : 1) * sizeof(Node *));
+  bool ok = arena->storage != NULL;
+
+  size_t cursor = 0;
+  for (size_t i = 0; ok && i < count; i++) {
+    Node *old = nodes[i];
+    NodeBlock *block = &chunk->blocks[chunk->used++];
+    Node *node = init_block(block, old->value, old->node_id, arena);
+    node->parent = relocated_address(map, chunk, old->parent);
+    node->cached_height = old->cached_height;
+    node->cached_size = old->cached_size;
+    node->cached_leaves = old->cached_leaves;
+    node->cached_diameter = old->cached_diameter;
+    node->aggregates_dirty = old->aggregates_dirty;
+    NodeSet *sets[4] = {old->edges, old->incoming, old->outgoing,
+                        old->children};
+    for (int k = 0; ok && k < 4; k++) {
+      NodeSet *from = sets[k], *to = &block->sets[k];
+      if (from->size > NODESET_INLINE_CAPACITY) {
+        to->nodes = arena->storage + cursor;
+        to->capacity = from->size;
+        to->borrowed = true;
+        cursor += from->size;
+      }
+      for (size_t j = 0; j < from->size; j++) {
+        to->nodes[j] = relocated_address(map, chunk, from->nodes[j]);
+      }
+      to->size = from->size;
+      if (from->weights) {
+        to->weights = (uint32_t *)malloc(to->capacity * sizeof(uint32_t));
+        ok = to->weights != NULL;
+        if (ok)
+          memcpy(to->weights, from->weights, to->size * sizeof(uint32_t));
+      }
+      // Without an index lookups fall back to a scan, so failure is benign
+      if (to->size > NODESET_INDEX_THRESHOLD)
+        index_rebuild(to);
+    }
+  }
+  nodemap_destroy(map);
+  if (!ok) {
+    arena_destroy(arena);
+    return NULL;
+  }
+  arena->live = count;
+  for (size_t i = 0; i < count; i++) {
+    destroy_node(nodes[i]);
+    relocated[i] = &chunk->blocks[i].node;
+  }
+  return arena;
 }
 
 void *get_node_value(Node *node) { return node ? node->value : NULL; }
@@ -47,11 +279,178 @@ void add_edge(Node *self, Node *other, bool directed, bool bidirectional) {
   }
 }
 
+// Appends node to a set reserved by add_edges, without the membership test
+static void append_member(NodeSet *set, Node *node) {
+  if (set->weights)
+    set->weights[set->size] = EDGE_DEFAULT_WEIGHT;
+  set->nodes[set->size++] = node;
+}
+
+bool add_edges(Node **src, Node **dst, size_t count, bool directed,
+               bool bidirectional) {
+  if (count && (!src || !dst))
+    return false;
+  // Number the touched nodes and count the entries each of their edges,
+  // incoming and outgoing sets will receive
+  NodeMap *map = nodemap_create(count);
+  Node **touched = (Node **)malloc((2 * count + 1) * sizeof(Node *));
+  size_t *pending = (size_t *)calloc(3 * (2 * count + 1), sizeof(size_t));
+  bool ok = map && touched && pending;
+  size_t num_touched = 0;
+  for (size_t i = 0; ok && i < count; i++) {
+    if (!src[i] || !dst[i])
+      continue;
+    size_t ends[2];
+    for (int e = 0; ok && e < 2; e++) {
+      Node *node = e ? dst[i] : src[i];
+      if (!nodemap_get(map, node, &ends[e])) {
+        ends[e] = num_touched;
+        touched[num_touched++] = node;
+        ok = nodemap_put(map, node, ends[e]);
+      }
+    }
+    if (!ok)
+      break;
+    pending[3 * ends[0]]++;
+    if (directed) {
+      pending[3 * ends[0] + 2]++;
+      pending[3 * ends[1] + 1]++;
+    }
+    if (bidirectional)
+      pending[3 * ends[1]]++;
+  }
+  // Size every set exactly before changing any of them
+  for (size_t k = 0; ok && k < num_touched; k++) {
+    NodeSet *sets[3] = {touched[k]->edges, touched[k]->incoming,
+                        touched[k]->outgoing};
+    for (int kind = 0; ok && kind < 3; kind++) {
+      size_t extra = pending[3 * k + kind];
+      ok = !extra || nodeset_reserve(sets[kind], sets[kind]->size + extra,
+                                     false);
+    }
+  }
+  if (ok) {
+    for (size_t i = 0; i < count; i++) {
+      if (!src[i] || !dst[i])
+        continue;
+      append_member(src[i]->edges, dst[i]);
+      if (directed) {
+        append_member(src[i]->outgoing, dst[i]);
+        append_member(dst[i]->incoming, src[i]);
+      }
+      if (bidirectional)
+        append_member(dst[i]->edges, src[i]);
+    }
+    // One pass per set; members already present keep their weights, as
+    // they would under add_edge
+    for (size_t k = 0; k < num_touched; k++) {
+      NodeSet *sets[3] = {touched[k]->edges, touched[k]->incoming,
+                          touched[k]->outgoing};
+      for (int kind = 0; kind < 3; kind++) {
+        if (pending[3 * k + kind])
+          dedup_members(sets[kind], false);
+      }
+    }
+  }
+  nodemap_destroy(map);
+  free(touched);
+  free(pending);
+  return ok;
+}
+
+void add_weighted_edge(Node *self, Node *other, uint32_t weight, bool directed,
+                       bool bidirectional) {
+  if (!self || !other)
+    return;
+  nodeset_add_weighted(self->edges, other, weight);
+  if (directed) {
+    nodeset_add_weighted(self->outgoing, other, weight);
+    nodeset_add_weighted(other->incoming, self, weight);
+  }
+  if (bidirectional) {
+    nodeset_add_weighted(other->edges, self, weight);
+  }
+}
+
+bool get_edge_weight(Node *self, Node *other, uint32_t *weight) {
+  return self && nodeset_get_weight(self->edges, other, weight);
+}
+
+void remove_edge(Node *self, Node *other, bool directed,
+                 bool bidirectional) {
+  if (!self || !other)
+    return;
+  nodeset_swap_remove(self->edges, other);
+  if (directed) {
+    nodeset_swap_remove(self->outgoing, other);
+    nodeset_swap_remove(other->incoming, self);
+  }
+  if (bidirectional) {
+    nodeset_swap_remove(other->edges, self);
+  }
+}
+
 void add_child(Node *self, Node *child) {
   if (!self || !child)
     return;
+  // A previous parent may go on listing child, which its cache must reflect
+  if (child->parent && child->parent != self)
+    node_invalidate(child->parent);
   child->parent = self;
   nodeset_add(self->children, child);
+  node_invalidate(self);
+}
+
+void remove_child(Node *self, Node *child) {
+  if (!self || !child || child->parent != self)
+    return;
+  child->parent = NULL;
+  nodeset_swap_remove(self->children, child);
+  node_invalidate(self);
+}
+
+void unlink_node(Node *node) {
+  if (!node)
+    return;
+  // Each neighbor drops its entry in O(1) through its index, or a scan of
+  // its small set, so the whole unlink is O(degree). Self-loops are skipped
+  // rather than removed under the loop; the sets are released below.
+  for (size_t i = 0; i < node->edges->size; i++) {
+    Node *other = node->edges->nodes[i];
+    if (other != node)
+      nodeset_swap_remove(other->edges, node);
+  }
+  for (size_t i = 0; i < node->outgoing->size; i++) {
+    Node *target = node->outgoing->nodes[i];
+    if (target != node)
+      nodeset_swap_remove(target->incoming, node);
+  }
+  for (size_t i = 0; i < node->incoming->size; i++) {
+    Node *source = node->incoming->nodes[i];
+    if (source != node) {
+      nodeset_swap_remove(source->outgoing, node);
+      nodeset_swap_remove(source->edges, node);
+    }
+  }
+  // A child re-parented since keeps its new parent
+  for (size_t i = 0; i < node->children->size; i++) {
+    Node *child = node->children->nodes[i];
+    if (child->parent == node)
+      child->parent = NULL;
+  }
+  if (node->parent != node)
+    remove_child(node->parent, node);
+  node->parent = NULL;
+  release_block((NodeBlock *)node);
+  node_invalidate(node);
+}
+
+void node_invalidate(Node *node) {
+  // Everything above an already dirty node is dirty as well
+  while (node && !node->aggregates_dirty) {
+    node->aggregates_dirty = true;
+    node = node->parent;
+  }
 }
 
 bool is_root(Node *node) {
@@ -66,16 +465,120 @@ bool is_leaf(Node *node) {
   return nodeset_size(node->children) == 0;
 }
 
-int height(Node *node) {
-  if (!node || is_leaf(node))
-    return 0;
-  int max = 0;
+// Explicit stack for walking deep trees without recursion; each entry
+// remembers the next child to descend into
+#define WALK_INLINE_DEPTH 64
+
+typedef struct WalkStack {
+  Node **nodes;
+  size_t *next;
+  size_t size;
+  size_t capacity;
+  Node *inline_nodes[WALK_INLINE_DEPTH];
+  size_t inline_next[WALK_INLINE_DEPTH];
+} WalkStack;
+
+static void walk_init(WalkStack *stack) {
+  stack->nodes = stack->inline_nodes;
+  stack->next = stack->inline_next;
+  stack->size = 0;
+  stack->capacity = WALK_INLINE_DEPTH;
+}
+
+static void walk_free(WalkStack *stack) {
+  if (stack->nodes != stack->inline_nodes) {
+    free(stack->nodes);
+    free(stack->next);
+  }
+}
+
+static bool walk_push(WalkStack *stack, Node *node) {
+  if (stack->size == stack->capacity) {
+    size_t capacity = stack->capacity * 2;
+    bool spilled = stack->nodes != stack->inline_nodes;
+    Node **nodes = (Node **)malloc(capacity * sizeof(Node *));
+    size_t *next = (size_t *)malloc(capacity * sizeof(size_t));
+    if (!nodes || !next) {
+      free(nodes);
+      free(next);
+      return false;
+    }
+    memcpy(nodes, stack->nodes, stack->size * sizeof(Node *));
+    memcpy(next, stack->next, stack->size * sizeof(size_t));
+    if (spilled) {
+      free(stack->nodes);
+      free(stack->next);
+    }
+    stack->nodes = nodes;
+    stack->next = next;
+    stack->capacity = capacity;
+  }
+  stack->nodes[stack->size] = node;
+  stack->next[stack->size] = 0;
+  stack->size++;
+  return true;
+}
+
+// Recomputes a node's aggregates from its (clean) children
+static void compute_aggregates(Node *node) {
+  int size = 1, leaves = 0, max1 = 0, max2 = 0, child_diameter = 0;
+  bool leaf = true, shared = false;
   for (size_t i = 0; i < nodeset_size(node->children); i++) {
-    int h = height(node->children->nodes[i]);
-    if (h > max)
-      max = h;
+    Node *child = node->children->nodes[i];
+    leaf = false;
+    shared |= child->parent != node || child->aggregates_dirty;
+    size += child->cached_size;
+    leaves += child->cached_leaves;
+    int h = child->cached_height;
+    if (h > max1) {
+      max2 = max1;
+      max1 = h;
+    } else if (h > max2) {
+      max2 = h;
+    }
+    if (child->cached_diameter > child_diameter)
+      child_diameter = child->cached_diameter;
+  }
+  node->cached_height = leaf ? 0 : max1 + 1;
+  node->cached_size = size;
+  node->cached_leaves = leaf ? 1 : leaves;
+  // Longest path through this node, counted the way diameter always has
+  int through_node = max1 + max2 + 1;
+  node->cached_diameter =
+      through_node > child_diameter ? through_node : child_diameter;
+  // Changes below a child listed under another parent too only dirty its
+  // parent's chain, so nothing above such a child keeps a cached result
+  node->aggregates_dirty = shared;
+}
+
+// Postorder over the dirty part of the subtree; clean subtrees are skipped
+static bool refresh_aggregates(Node *root) {
+  if (!root->aggregates_dirty)
+    return true;
+  WalkStack stack;
+  walk_init(&stack);
+  bool ok = walk_push(&stack, root);
+  while (ok && stack.size) {
+    Node *top = stack.nodes[stack.size - 1];
+    size_t *next = &stack.next[stack.size - 1];
+    size_t count = nodeset_size(top->children);
+    while (*next < count && !top->children->nodes[*next]->aggregates_dirty)
+      (*next)++;
+    if (*next < count) {
+      ok = walk_push(&stack, top->children->nodes[(*next)++]);
+    } else {
+      compute_aggregates(top);
+      stack.size--;
+    }
   }
-  return max + 1;
+  walk_free(&stack);
+  return ok;
+}
+
+int height(Node *node) {
+  if (!node)
+    return 0;
+  return refresh_aggregates(node) ? node->cached_height : -1;
 }
 
 int depth(Node *node) {
@@ -92,58 +595,120 @@ int depth(Node *node) {
 int num_leaves(Node *node) {
   if (!node)
     return 0;
-  if (is_leaf(node))
-    return 1;
-  int count = 0;
-  for (size_t i = 0; i < nodeset_size(node->children); i++) {
-    count += num_leaves(node->children->nodes[i]);
-  }
-  return count;
+  return refresh_aggregates(node) ? node->cached_leaves : -1;
 }
 
 int num_nodes(Node *node) {
   if (!node)
     return 0;
-  int count = 1;
-  for (size_t i = 0; i < nodeset_size(node->children); i++) {
-    count += num_nodes(node->children->nodes[i]);
-  }
-  return count;
+  return refresh_aggregates(node) ? node->cached_size : -1;
 }
 
 int diameter(Node *node) {
   if (!node)
     return 0;
-  int max1 = 0, max2 = 0;
-  for (size_t i = 0; i < nodeset_size(node->children); i++) {
-    int h = height(node->children->nodes[i]);
-    if (h > max1) {
-      max2 = max1;
-      max1 = h;
-    } else if (h > max2) {
-      max2 = h;
+  return refresh_aggregates(node) ? node->cached_diameter : -1;
+}
+
+bool preorder_visit(Node *node, NodeVisitor visit, void *ctx) {
+  if (!node || !visit)
+    return false;
+  VisitResult result = visit(node, ctx);
+  if (result != VISIT_CONTINUE)
+    return result == VISIT_STOP;
+
+  WalkStack stack;
+  walk_init(&stack);
+  bool stopped = false;
+  bool ok = walk_push(&stack, node);
+  while (ok && stack.size) {
+    Node *top = stack.nodes[stack.size - 1];
+    size_t *next = &stack.next[stack.size - 1];
+    if (*next == nodeset_size(top->children)) {
+      stack.size--;
+      continue;
+    }
+    Node *child = top->children->nodes[(*next)++];
+    result = visit(child, ctx);
+    if (result == VISIT_STOP) {
+      stopped = true;
+      break;
     }
+    if (result == VISIT_CONTINUE)
+      ok = walk_push(&stack, child);
   }
-  int max_child_dia = 0;
-  for (size_t i = 0; i < nodeset_size(node->children); i++) {
-    int d = diameter(node->children->nodes[i]);
-    if (d > max_child_dia)
-      max_child_dia = d;
+  walk_free(&stack);
+  return stopped;
+}
+
+bool postorder_visit(Node *node, NodeVisitor visit, void *ctx) {
+  if (!node || !visit)
+    return false;
+  WalkStack stack;
+  walk_init(&stack);
+  bool stopped = false;
+  bool ok = walk_push(&stack, node);
+  while (ok && stack.size) {
+    Node *top = stack.nodes[stack.size - 1];
+    size_t *next = &stack.next[stack.size - 1];
+    if (*next < nodeset_size(top->children)) {
+      ok = walk_push(&stack, top->children->nodes[(*next)++]);
+      continue;
+    }
+    stack.size--;
+    if (visit(top, ctx) == VISIT_STOP) {
+      stopped = true;
+      break;
+    }
   }
-  int through_node = max1 + max2 + 1;
-  if (through_node > max_child_dia)
-    return through_node;
-  else
-    return max_child_dia;
+  walk_free(&stack);
+  return stopped;
+}
+
+bool dfs_visit(Node *start, NodeVisitor visit, void *ctx) {
+  return preorder_visit(start, visit, ctx);
+}
+
+bool bfs_visit(Node *start, NodeVisitor visit, void *ctx) {
+  if (!start || !visit)
+    return false;
+  NodeQueue *queue = queue_create(32);
+  if (!queue)
+    return false;
+  bool stopped = false;
+  bool grown = queue_push(queue, start);
+  while (grown && !queue_is_empty(queue)) {
+    Node *current = queue_dequeue(queue);
+    VisitResult result = visit(current, ctx);
+    if (result == VISIT_STOP) {
+      stopped = true;
+      break;
+    }
+    if (result == VISIT_SKIP)
+      continue;
+    for (size_t i = 0; grown && i < nodeset_size(current->children); i++) {
+      grown = queue_push(queue, current->children->nodes[i]);
+    }
+  }
+  queue_destroy(queue);
+  return stopped;
+}
+
+// Adapts the plain callbacks to the visitor traversals
+typedef struct {
+  void (*result)(Node *);
+} ResultCallback;
+
+static VisitResult call_result(Node *node, void *ctx) {
+  ((ResultCallback *)ctx)->result(node);
+  return VISIT_CONTINUE;
 }
 
 void dfs(Node *start, void (*result)(Node *)) {
-  if (!start || !result)
+  if (!result)
     return;
-  result(start);
-  for (size_t i = 0; i < nodeset_size(start->children); i++) {
-    dfs(start->children->nodes[i], result);
-  }
+  ResultCallback callback = {result};
+  dfs_visit(start, call_result, &callback);
 }
 
 void bfs(Node *start, void (*result)(Node *)) {
@@ -162,21 +727,65 @@ void bfs(Node *start, void (*result)(Node *)) {
 }
 
 void preorder(Node *node, void (*result)(Node *)) {
-  if (!node || !result)
+  if (!result)
     return;
-  result(node);
-  for (size_t i = 0; i < nodeset_size(node->children); i++) {
-    preorder(node->children->nodes[i], result);
-  }
+  ResultCallback callback = {result};
+  preorder_visit(node, call_result, &callback);
 }
 
 void postorder(Node *node, void (*result)(Node *)) {
-  if (!node || !result)
+  if (!result)
     return;
-  for (size_t i = 0; i < nodeset_size(node->children); i++) {
-    postorder(node->children->nodes[i], result);
+  ResultCallback callback = {result};
+  postorder_visit(node, call_result, &callback);
+}
+
+size_t preorder_flatten(Node *root, size_t capacity, Node **nodes,
+                        uint32_t *parent, uint32_t *last, NodeMap *ids) {
+  if (!root || capacity == 0 || !nodes || !parent || !last || !ids)
+    return 0;
+  Node **stack = (Node **)malloc(capacity * sizeof(Node *));
+  uint32_t *stack_parent = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+  if (!stack || !stack_parent) {
+    free(stack);
+    free(stack_parent);
+    return 0;
   }
-  result(node);
+
+  // Children are pushed in reverse to keep their order
+  size_t top = 0, next = 0;
+  stack[top] = root;
+  stack_parent[top++] = UINT32_MAX;
+  while (top && next < capacity) {
+    Node *node = stack[--top];
+    uint32_t id = (uint32_t)next++;
+    nodes[id] = node;
+    parent[id] = stack_parent[top];
+    if (!nodemap_put(ids, node, id)) {
+      free(stack);
+      free(stack_parent);
+      return 0;
+    }
+    NodeSet *children = node->children;
+    for (size_t i = nodeset_size(children); i > 0 && top < capacity; i--) {
+      stack[top] = children->nodes[i - 1];
+      stack_parent[top++] = id;
+    }
+  }
+  free(stack);
+  free(stack_parent);
+
+  // Subtree sizes, accumulated child to parent in reverse preorder
+  for (size_t i = 0; i < next; i++) {
+    last[i] = 1;
+  }
+  for (size_t i = next - 1; i > 0; i--) {
+    last[parent[i]] += last[i];
+  }
+  for (size_t i = 0; i < next; i++) {
+    last[i] = (uint32_t)i + last[i] - 1;
+  }
+  return next;
 }
 
 // Comparison function for integers
@@ -187,25 +796,158 @@ int compare_ints(const void *a, const void *b) {
 }
 
 // NodeSet implementation
+#define NODESET_NOT_FOUND ((size_t)-1)
+
+static size_t hash_ptr(const void *ptr) {
+  uint64_t x = (uint64_t)(uintptr_t)ptr;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  return (size_t)x;
+}
+
+// Linear scan comparing four pointers per step
+static size_t scan_nodes(Node **nodes, size_t size, Node *node) {
+  size_t i = 0;
+#if defined(__SSE2__) && UINTPTR_MAX == UINT64_MAX
+  __m128i needle = _mm_set1_epi64x((long long)(uintptr_t)node);
+  for (; i + 4 <= size; i += 4) {
+    __m128i lo = _mm_cmpeq_epi32(
+        _mm_loadu_si128((const __m128i *)(nodes + i)), needle);
+    __m128i hi = _mm_cmpeq_epi32(
+        _mm_loadu_si128((const __m128i *)(nodes + i + 2)), needle);
+    // SSE2 has no 64-bit compare, so both 32-bit halves must match
+    lo = _mm_and_si128(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+    hi = _mm_and_si128(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+    int mask = _mm_movemask_pd(_mm_castsi128_pd(lo)) |
+               _mm_movemask_pd(_mm_castsi128_pd(hi)) << 2;
+    if (mask)
+      return i + (size_t)__builtin_ctz((unsigned int)mask);
+  }
+#elif defined(__aarch64__)
+  uint64x2_t needle = vdupq_n_u64((uint64_t)(uintptr_t)node);
+  for (; i + 4 <= size; i += 4) {
+    uint64x2_t lo = vceqq_u64(vld1q_u64((const uint64_t *)(nodes + i)), needle);
+    uint64x2_t hi =
+        vceqq_u64(vld1q_u64((const uint64_t *)(nodes + i + 2)), needle);
+    if (vmaxvq_u32(vreinterpretq_u32_u64(vorrq_u64(lo, hi))))
+      break; // The scalar loop below finds the exact position
+  }
+#endif
+  for (; i < size; i++) {
+    if (nodes[i] == node)
+      return i;
+  }
+  return NODESET_NOT_FOUND;
+}
+
+// Returns the index slot holding node, or the empty slot where it belongs
+static size_t index_slot(NodeSet *set, Node *node) {
+  size_t slot = hash_ptr(node) & set->index_mask;
+  while (set->index[slot] && set->nodes[set->index[slot] - 1] != node) {
+    slot = (slot + 1) & set->index_mask;
+  }
+  return slot;
+}
+
+// Rebuilds the index with room for at least twice the current size. On
+// failure the index is dropped, since it may miss members added since it
+// was built, and lookups fall back to a scan.
+static bool index_rebuild(NodeSet *set) {
+  size_t slots = 64;
+  while (slots < 2 * (set->size + 1)) {
+    slots *= 2;
+  }
+  size_t *index = (size_t *)calloc(slots, sizeof(size_t));
+  free(set->index);
+  if (!index) {
+    set->index = NULL;
+    set->index_mask = 0;
+    return false;
+  }
+  set->index = index;
+  set->index_mask = slots - 1;
+  for (size_t i = 0; i < set->size; i++) {
+    set->index[index_slot(set, set->nodes[i])] = i + 1;
+  }
+  return true;
+}
+
+// Backward-shift deletion keeps probe chains intact without tombstones
+static void index_erase(NodeSet *set, size_t slot) {
+  size_t mask = set->index_mask;
+  size_t hole = slot;
+  for (size_t i = (slot + 1) & mask; set->index[i]; i = (i + 1) & mask) {
+    size_t home = hash_ptr(set->nodes[set->index[i] - 1]) & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      set->index[hole] = set->index[i];
+      hole = i;
+    }
+  }
+  set->index[hole] = 0;
+}
+
+static size_t nodeset_find(NodeSet *set, Node *node) {
+  if (set->index) {
+    size_t slot = index_slot(set, node);
+    return set->index[slot] ? set->index[slot] - 1 : NODESET_NOT_FOUND;
+  }
+  return scan_nodes(set->nodes, set->size, node);
+}
+
+static bool nodeset_grow(NodeSet *set, size_t capacity) {
+  if (capacity <= set->capacity)
+    return true;
+  Node **nodes;
+  if (set->nodes == set->inline_nodes || set->borrowed) {
+    nodes = (Node **)malloc(capacity * sizeof(Node *));
+    if (nodes)
+      memcpy(nodes, set->nodes, set->size * sizeof(Node *));
+  } else {
+    nodes = (Node **)realloc(set->nodes, capacity * sizeof(Node *));
+  }
+  if (!nodes)
+    return false;
+  set->nodes = nodes;
+  set->borrowed = false;
+  if (set->weights) {
+    uint32_t *weights =
+        (uint32_t *)realloc(set->weights, capacity * sizeof(uint32_t));
+    if (!weights)
+      return false;
+    set->weights = weights;
+  }
+  set->capacity = capacity;
+  return true;
+}
+
+// Switches the set to explicit weights, all EDGE_DEFAULT_WEIGHT so far
+static bool weights_init(NodeSet *set) {
+  set->weights = (uint32_t *)malloc(set->capacity * sizeof(uint32_t));
+  if (!set->weights)
+    return false;
+  for (size_t i = 0; i < set->size; i++) {
+    set->weights[i] = EDGE_DEFAULT_WEIGHT;
+  }
+  return true;
+}
+
 NodeSet *nodeset_create(size_t initial_capacity) {
   NodeSet *set = (NodeSet *)malloc(sizeof(NodeSet));
   if (!set)
     return NULL;
 
-  set->nodes = (Node **)malloc(sizeof(Node *) * initial_capacity);
-  if (!set->nodes) {
+  nodeset_init(set);
+  if (!nodeset_grow(set, initial_capacity)) {
     free(set);
     return NULL;
   }
-
-  set->size = 0;
-  set->capacity = initial_capacity;
   return set;
 }
 
 void nodeset_destroy(NodeSet *set) {
   if (set) {
-    free(set->nodes);
+    nodeset_release(set);
     free(set);
   }
 }
@@ -213,50 +955,274 @@ void nodeset_destroy(NodeSet *set) {
 bool nodeset_contains(NodeSet *set, Node *node) {
   if (!set || !node)
     return false;
-  for (size_t i = 0; i < set->size; i++) {
-    if (set->nodes[i] == node)
-      return true;
-  }
-  return false;
+  return nodeset_find(set, node) != NODESET_NOT_FOUND;
 }
 
 void nodeset_add(NodeSet *set, Node *node) {
   if (!set || !node || nodeset_contains(set, node))
     return;
 
-  if (set->size == set->capacity) {
-    set->capacity *= 2;
-    set->nodes = (Node **)realloc(set->nodes, set->capacity * sizeof(Node *));
-    if (!set->nodes)
-      return;
-  }
+  if (set->size == set->capacity && !nodeset_grow(set, set->capacity * 2))
+    return;
+  if (set->weights)
+    set->weights[set->size] = EDGE_DEFAULT_WEIGHT;
   set->nodes[set->size++] = node;
+
+  if (set->index) {
+    if (2 * set->size > set->index_mask + 1)
+      index_rebuild(set);
+    else
+      set->index[index_slot(set, node)] = set->size;
+  } else if (set->size > NODESET_INDEX_THRESHOLD) {
+    index_rebuild(set);
+  }
 }
 
-void nodeset_remove(NodeSet *set, Node *node) {
+void nodeset_add_weighted(NodeSet *set, Node *node, uint32_t weight) {
   if (!set || !node)
     return;
+  size_t i = nodeset_find(set, node);
+  if (i == NODESET_NOT_FOUND) {
+    nodeset_add(set, node);
+    if (!set->size || set->nodes[set->size - 1] != node)
+      return; // The set could not grow
+    i = set->size - 1;
+  }
+  if (!set->weights && (weight == EDGE_DEFAULT_WEIGHT || !weights_init(set)))
+    return;
+  set->weights[i] = weight;
+}
+
+uint32_t nodeset_weight(NodeSet *set, size_t i) {
+  return set->weights ? set->weights[i] : EDGE_DEFAULT_WEIGHT;
+}
+
+bool nodeset_get_weight(NodeSet *set, Node *node, uint32_t *weight) {
+  if (!set || !node)
+    return false;
+  size_t i = nodeset_find(set, node);
+  if (i == NODESET_NOT_FOUND)
+    return false;
+  if (weight)
+    *weight = nodeset_weight(set, i);
+  return true;
+}
+
+bool nodeset_reserve(NodeSet *set, size_t capacity, bool weighted) {
+  if (!set || !nodeset_grow(set, capacity))
+    return false;
+  return !weighted || set->weights || weights_init(set);
+}
 
+// Drops repeats, keeping each member's first position. A repeat's weight
+// replaces the kept one only if last_weight is set.
+static size_t dedup_members(NodeSet *set, bool last_weight) {
+  free(set->index);
+  set->index = NULL;
+  set->index_mask = 0;
+  size_t kept = 0;
+  // Large sets dedup through the index itself, built as members are kept
+  size_t slots = 64;
+  while (slots < 2 * (set->size + 1)) {
+    slots *= 2;
+  }
+  if (set->size > NODESET_INDEX_THRESHOLD)
+    set->index = (size_t *)calloc(slots, sizeof(size_t));
+  if (!set->index) {
+    // Small, or no memory for the index: compare against the kept prefix
+    for (size_t i = 0; i < set->size; i++) {
+      size_t j = scan_nodes(set->nodes, kept, set->nodes[i]);
+      bool repeat = j != NODESET_NOT_FOUND;
+      if (!repeat) {
+        j = kept++;
+        set->nodes[j] = set->nodes[i];
+      }
+      if (set->weights && (!repeat || last_weight))
+        set->weights[j] = set->weights[i];
+    }
+    size_t removed = set->size - kept;
+    set->size = kept;
+    return removed;
+  }
+  set->index_mask = slots - 1;
   for (size_t i = 0; i < set->size; i++) {
-    if (set->nodes[i] == node) {
-      memmove(&set->nodes[i], &set->nodes[i + 1],
-              sizeof(Node *) * (set->size - i - 1));
-      set->size--;
-      return;
+    Node *node = set->nodes[i];
+    size_t slot = index_slot(set, node);
+    size_t j;
+    bool repeat = set->index[slot] != 0;
+    if (repeat) {
+      j = set->index[slot] - 1;
+    } else {
+      j = kept++;
+      set->nodes[j] = node;
+      set->index[slot] = kept;
     }
+    if (set->weights && (!repeat || last_weight))
+      set->weights[j] = set->weights[i];
+  }
+  size_t removed = set->size - kept;
+  set->size = kept;
+  return removed;
+}
+
+size_t nodeset_dedup(NodeSet *set) {
+  return set ? dedup_members(set, true) : 0;
+}
+
+void nodeset_remove(NodeSet *set, Node *node) {
+  if (!set || !node)
+    return;
+
+  size_t i = nodeset_find(set, node);
+  if (i == NODESET_NOT_FOUND)
+    return;
+  // Every later member moves down one position. Their slots are fixed
+  // front to back before the move: a fixed slot points at an earlier
+  // member, so it never matches one still to be looked up.
+  if (set->index) {
+    index_erase(set, index_slot(set, node));
+    for (size_t j = i + 1; j < set->size; j++) {
+      set->index[index_slot(set, set->nodes[j])]--;
+    }
+  }
+  memmove(&set->nodes[i], &set->nodes[i + 1],
+          sizeof(Node *) * (set->size - i - 1));
+  if (set->weights)
+    memmove(&set->weights[i], &set->weights[i + 1],
+            sizeof(uint32_t) * (set->size - i - 1));
+  set->size--;
+}
+
+void nodeset_swap_remove(NodeSet *set, Node *node) {
+  if (!set || !node)
+    return;
+
+  size_t i;
+  if (set->index) {
+    size_t slot = index_slot(set, node);
+    if (!set->index[slot])
+      return;
+    i = set->index[slot] - 1;
+    index_erase(set, slot);
+  } else {
+    i = scan_nodes(set->nodes, set->size, node);
+    if (i == NODESET_NOT_FOUND)
+      return;
+  }
+
+  size_t last = set->size - 1;
+  if (i != last) {
+    Node *moved = set->nodes[last];
+    set->nodes[i] = moved;
+    if (set->weights)
+      set->weights[i] = set->weights[last];
+    if (set->index)
+      set->index[index_slot(set, moved)] = i + 1;
   }
+  set->size--;
 }
 
 size_t nodeset_size(NodeSet *set) { return set ? set->size : 0; }
 
 bool nodeset_is_empty(NodeSet *set) { return set ? set->size == 0 : true; }
 
+// NodeMap implementation
+static bool nodemap_resize(NodeMap *map, size_t slots) {
+  Node **keys = (Node **)calloc(slots, sizeof(Node *));
+  size_t *values = (size_t *)malloc(slots * sizeof(size_t));
+  if (!keys || !values) {
+    free(keys);
+    free(values);
+    return false;
+  }
+  size_t mask = slots - 1;
+  for (size_t i = 0; map->keys && i <= map->mask; i++) {
+    if (!map->keys[i])
+      continue;
+    size_t slot = hash_ptr(map->keys[i]) & mask;
+    while (keys[slot]) {
+      slot = (slot + 1) & mask;
+    }
+    keys[slot] = map->keys[i];
+    values[slot] = map->values[i];
+  }
+  free(map->keys);
+  free(map->values);
+  map->keys = keys;
+  map->values = values;
+  map->mask = mask;
+  return true;
+}
+
+NodeMap *nodemap_create(size_t expected_size) {
+  NodeMap *map = (NodeMap *)malloc(sizeof(NodeMap));
+  if (!map)
+    return NULL;
+  map->keys = NULL;
+  map->values = NULL;
+  map->size = 0;
+  size_t slots = 16;
+  while (slots < 2 * expected_size) {
+    slots *= 2;
+  }
+  if (!nodemap_resize(map, slots)) {
+    free(map);
+    return NULL;
+  }
+  return map;
+}
+
+void nodemap_destroy(NodeMap *map) {
+  if (map) {
+    free(map->keys);
+    free(map->values);
+    free(map);
+  }
+}
+
+bool nodemap_put(NodeMap *map, Node *node, size_t value) {
+  if (!map || !node)
+    return false;
+  if (2 * (map->size + 1) > map->mask + 1 &&
+      !nodemap_resize(map, 2 * (map->mask + 1)))
+    return false;
+  size_t slot = hash_ptr(node) & map->mask;
+  while (map->keys[slot] && map->keys[slot] != node) {
+    slot = (slot + 1) & map->mask;
+  }
+  if (!map->keys[slot]) {
+    map->keys[slot] = node;
+    map->size++;
+  }
+  map->values[slot] = value;
+  return true;
+}
+
+bool nodemap_get(const NodeMap *map, Node *node, size_t *value) {
+  if (!map || !node)
+    return false;
+  size_t slot = hash_ptr(node) & map->mask;
+  while (map->keys[slot]) {
+    if (map->keys[slot] == node) {
+      if (value)
+        *value = map->values[slot];
+      return true;
+    }
+    slot = (slot + 1) & map->mask;
+  }
+  return false;
+}
+
+size_t nodemap_size(const NodeMap *map) { return map ? map->size : 0; }
+
 // NodeQueue implementation
 NodeQueue *queue_create(size_t capacity) {
   NodeQueue *queue = (NodeQueue *)malloc(sizeof(NodeQueue));
   if (!queue)
     return NULL;
 
+  if (capacity == 0)
+    capacity = 1;
   queue->nodes = (Node **)malloc(sizeof(Node *) * capacity);
   if (!queue->nodes) {
     free(queue);
@@ -265,6 +1231,7 @@ NodeQueue *queue_create(size_t capacity) {
 
   queue->front = 0;
   queue->rear = 0;
+  queue->size = 0;
   queue->capacity = capacity;
   return queue;
 }
@@ -277,24 +1244,41 @@ void queue_destroy(NodeQueue *queue) {
 }
 
 bool queue_is_empty(NodeQueue *queue) {
-  return queue ? queue->front == queue->rear : true;
+  return queue ? queue->size == 0 : true;
+}
+
+// Appends node, returning false (and leaving the queue as it was) if the
+// queue cannot grow
+static bool queue_push(NodeQueue *queue, Node *node) {
+  if (queue->size == queue->capacity) {
+    size_t capacity = queue->capacity * 2;
+    Node **nodes = realloc(queue->nodes, sizeof(Node *) * capacity);
+    if (!nodes)
+      return false;
+    // Unwrap: the slots before front hold the newest nodes; move them after
+    // the old end so the live range is contiguous modulo the new capacity
+    memcpy(nodes + queue->capacity, nodes, sizeof(Node *) * queue->front);
+    queue->rear = queue->capacity + queue->front;
+    queue->nodes = nodes;
+    queue->capacity = capacity;
+  }
+  queue->nodes[queue->rear] = node;
+  queue->rear = queue->rear + 1 == queue->capacity ? 0 : queue->rear + 1;
+  queue->size++;
+  return true;
 }
 
 void queue_enqueue(NodeQueue *queue, Node *node) {
   if (!queue || !node)
     return;
-
-  if (queue->rear == queue->capacity) {
-    queue->capacity *= 2;
-    queue->nodes = realloc(queue->nodes, sizeof(Node *) * queue->capacity);
-    if (!queue->nodes)
-      return;
-  }
-  queue->nodes[queue->rear++] = node;
+  queue_push(queue, node);
 }
 
 Node *queue_dequeue(NodeQueue *queue) {
   if (!queue || queue_is_empty(queue))
     return NULL;
-  return queue->nodes[queue->front++];
+  Node *node = queue->nodes[queue->front];
+  queue->front = queue->front + 1 == queue->capacity ? 0 : queue->front + 1;
+  queue->size--;
+  return node;
 }
@@ -0,0 +1,173 @@
+#include "pagerank.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdlib.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+  const CSRGraph *graph;
+  PageRankOptions options;
+  double *rank;
+  double *next;
+  double *contrib;  // rank / outdegree, the value every in-edge reads
+  double *dangling; // Per thread: rank of nodes without outgoing edges
+  double *delta;    // Per thread: L1 change of its nodes
+  PageRankResult result;
+  ParallelBarrier barrier;
+} PageRankState;
+
+// First node of a thread's range, splitting nodes plus in-edges evenly
+static size_t balanced_start(const uint64_t *offsets, size_t count,
+                             int thread, int nthreads) {
+  uint64_t target = (offsets[count] + count) * thread / nthreads;
+  size_t lo = 0, hi = count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (offsets[mid] + mid < target)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Sum of contrib over a neighbor list, in four independent lanes so the
+// loads of neighboring entries overlap
+static double pull_sum(const double *contrib, const uint32_t *in,
+                       size_t count) {
+  size_t e = 0;
+  double sum;
+#if defined(__SSE2__)
+  __m128d lo = _mm_setzero_pd();
+  __m128d hi = _mm_setzero_pd();
+  for (; e + 4 <= count; e += 4) {
+    lo = _mm_add_pd(lo, _mm_set_pd(contrib[in[e + 1]], contrib[in[e]]));
+    hi = _mm_add_pd(hi, _mm_set_pd(contrib[in[e + 3]], contrib[in[e + 2]]));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(lo, hi));
+  sum = lanes[0] + lanes[1];
+#else
+  double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (; e + 4 <= count; e += 4) {
+    s0 += contrib[in[e]];
+    s1 += contrib[in[e + 1]];
+    s2 += contrib[in[e + 2]];
+    s3 += contrib[in[e + 3]];
+  }
+  sum = (s0 + s1) + (s2 + s3);
+#endif
+  for (; e < count; e++) {
+    sum += contrib[in[e]];
+  }
+  return sum;
+}
+
+static void pagerank_worker(int thread, void *ctx) {
+  PageRankState *state = (PageRankState *)ctx;
+  const CSRGraph *graph = state->graph;
+  size_t n = graph->num_nodes;
+  int nthreads = state->options.nthreads;
+  double damping = state->options.damping;
+  const uint64_t *in_offsets = graph->offsets[CSR_INCOMING];
+  const uint32_t *in = graph->neighbors[CSR_INCOMING];
+  const uint64_t *out_offsets = graph->offsets[CSR_OUTGOING];
+  double *rank = state->rank;
+  double *next = state->next;
+  size_t start = balanced_start(in_offsets, n, thread, nthreads);
+  size_t end = balanced_start(in_offsets, n, thread + 1, nthreads);
+
+  for (size_t v = start; v < end; v++) {
+    rank[v] = 1.0 / (double)n;
+  }
+  for (int iteration = 0; iteration < state->options.max_iterations;
+       iteration++) {
+    double dangling = 0;
+    for (size_t u = start; u < end; u++) {
+      uint64_t degree = out_offsets[u + 1] - out_offsets[u];
+      if (degree)
+        state->contrib[u] = rank[u] / (double)degree;
+      else
+        dangling += rank[u];
+    }
+    state->dangling[thread] = dangling;
+    parallel_barrier_wait(&state->barrier);
+
+    // Every thread sums the partials in the same order, so all of them
+    // agree on the teleport share and on when to stop
+    dangling = 0;
+    for (int t = 0; t < nthreads; t++) {
+      dangling += state->dangling[t];
+    }
+    double base = ((1.0 - damping) + damping * dangling) / (double)n;
+    double delta = 0;
+    for (size_t v = start; v < end; v++) {
+      double value = base + damping * pull_sum(state->contrib,
+                                                in + in_offsets[v],
+                                                in_offsets[v + 1] -
+                                                    in_offsets[v]);
+      delta += fabs(value - rank[v]);
+      next[v] = value;
+    }
+    state->delta[thread] = delta;
+    parallel_barrier_wait(&state->barrier);
+
+    delta = 0;
+    for (int t = 0; t < nthreads; t++) {
+      delta += state->delta[t];
+    }
+    double *swap = rank;
+    rank = next;
+    next = swap;
+    if (thread == 0) {
+      state->result.iterations = iteration + 1;
+      state->result.delta = delta;
+    }
+    if (delta < state->options.tolerance)
+      break;
+  }
+  // The last iteration may have ended in the scratch buffer
+  if (rank != state->rank) {
+    for (size_t v = start; v < end; v++) {
+      state->rank[v] = rank[v];
+    }
+  }
+}
+
+bool pagerank(const CSRGraph *graph, const PageRankOptions *options,
+              double *rank, PageRankResult *result) {
+  PageRankOptions defaults = {0.85, 1e-6, 100, 0};
+  if (!options)
+    options = &defaults;
+  if (!graph || !rank || !(options->damping >= 0 && options->damping <= 1) ||
+      !(options->tolerance >= 0) || options->max_iterations < 0)
+    return false;
+
+  PageRankState state = {.graph = graph, .options = *options, .rank = rank};
+  if (state.options.nthreads <= 0)
+    state.options.nthreads = parallel_default_threads();
+  // Threads beyond one per node would only wait at the barriers
+  if ((size_t)state.options.nthreads > graph->num_nodes)
+    state.options.nthreads = graph->num_nodes ? (int)graph->num_nodes : 1;
+  int nthreads = state.options.nthreads;
+  size_t n = graph->num_nodes;
+  state.next = (double *)malloc((n ? n : 1) * sizeof(double));
+  state.contrib = (double *)malloc((n ? n : 1) * sizeof(double));
+  state.dangling = (double *)calloc(nthreads, sizeof(double));
+  state.delta = (double *)calloc(nthreads, sizeof(double));
+  bool ok = state.next && state.contrib && state.dangling && state.delta;
+  if (ok && n > 0) {
+    parallel_barrier_init(&state.barrier, nthreads);
+    ok = parallel_run(nthreads, pagerank_worker, &state) == 0;
+    parallel_barrier_destroy(&state.barrier);
+  }
+  if (ok && result)
+    *result = state.result;
+  free(state.next);
+  free(state.contrib);
+  free(state.dangling);
+  free(state.delta);
+  return ok;
+}
@@ -0,0 +1,254 @@
+#include "par_bfs.h"
+#include "parallel.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Direction switch thresholds from Beamer et al., "Direction-Optimizing
+// Breadth-First Search"
+#define PAR_BFS_ALPHA 15
+#define PAR_BFS_BETA 18
+// Work units handed out per atomic claim
+#define PAR_BFS_CHUNK 64
+
+// Nodes one thread discovered in the current level
+typedef struct {
+  uint32_t *nodes;
+  size_t size;
+  size_t capacity;
+  uint64_t edges; // Out-degree sum of the discovered nodes
+} LocalFrontier;
+
+typedef struct {
+  const CSRGraph *graph;
+  int nthreads;
+  uint32_t source;
+  int32_t *dist;
+  uint32_t *parent;
+  _Atomic uint64_t *visited;
+  _Atomic uint64_t *frontier_bits; // Current frontier, for bottom-up levels
+  size_t words;
+  uint32_t *queue; // Current frontier, for top-down levels
+  size_t frontier_size;
+  size_t *offsets; // Where each thread's discoveries go in the next queue
+  LocalFrontier *locals;
+  atomic_size_t next_chunk;
+  atomic_bool failed;
+  ParallelBarrier barrier;
+  bool bottom_up;
+  int32_t level;
+  uint64_t unvisited_edges;
+  size_t reached;
+} BFSState;
+
+static bool test_bit(_Atomic uint64_t *bits, uint32_t node) {
+  return atomic_load_explicit(&bits[node >> 6], memory_order_relaxed) &
+         (1ULL << (node & 63));
+}
+
+// Returns true if this call set the bit
+static bool claim_bit(_Atomic uint64_t *bits, uint32_t node) {
+  uint64_t mask = 1ULL << (node & 63);
+  return !(atomic_fetch_or_explicit(&bits[node >> 6], mask,
+                                    memory_order_relaxed) &
+           mask);
+}
+
+static void discover(BFSState *state, LocalFrontier *local, uint32_t node,
+                     uint32_t from) {
+  if (local->size == local->capacity) {
+    size_t capacity = local->capacity ? 2 * local->capacity : 1024;
+    uint32_t *grown =
+        (uint32_t *)realloc(local->nodes, capacity * sizeof(uint32_t));
+    if (!grown) {
+      atomic_store(&state->failed, true);
+      return;
+    }
+    local->nodes = grown;
+    local->capacity = capacity;
+  }
+  state->parent[node] = from;
+  state->dist[node] = state->level + 1;
+  local->nodes[local->size++] = node;
+  local->edges += csr_degree(state->graph, CSR_OUTGOING, node);
+}
+
+static void top_down_step(BFSState *state, LocalFrontier *local) {
+  const uint64_t *offsets = state->graph->offsets[CSR_OUTGOING];
+  const uint32_t *targets = state->graph->neighbors[CSR_OUTGOING];
+  size_t start;
+  while ((start = atomic_fetch_add(&state->next_chunk, PAR_BFS_CHUNK)) <
+         state->frontier_size) {
+    size_t end = start + PAR_BFS_CHUNK;
+    if (end > state->frontier_size)
+      end = state->frontier_size;
+    for (size_t i = start; i < end; i++) {
+      uint32_t node = state->queue[i];
+      for (uint64_t j = offsets[node]; j < offsets[node + 1]; j++) {
+        uint32_t next = targets[j];
+        if (!test_bit(state->visited, next) &&
+            claim_bit(state->visited, next))
+          discover(state, local, next, node);
+      }
+    }
+  }
+}
+
+static void bottom_up_step(BFSState *state, LocalFrontier *local) {
+  const uint64_t *offsets = state->graph->offsets[CSR_INCOMING];
+  const uint32_t *sources = state->graph->neighbors[CSR_INCOMING];
+  size_t num_nodes = state->graph->num_nodes;
+  // Chunks are whole bitmap words
+  size_t chunk = PAR_BFS_CHUNK * 64;
+  size_t start;
+  while ((start = atomic_fetch_add(&state->next_chunk, chunk)) < num_nodes) {
+    size_t end = start + chunk < num_nodes ? start + chunk : num_nodes;
+    for (size_t node = start; node < end; node++) {
+      if (test_bit(state->visited, (uint32_t)node))
+        continue;
+      for (uint64_t j = offsets[node]; j < offsets[node + 1]; j++) {
+        if (test_bit(state->frontier_bits, sources[j])) {
+          claim_bit(state->visited, (uint32_t)node);
+          discover(state, local, (uint32_t)node, sources[j]);
+          break;
+        }
+      }
+    }
+  }
+}
+
+// Runs in one thread between levels: sizes the next frontier and picks its
+// direction
+static void plan_next_level(BFSState *state) {
+  size_t total = 0;
+  uint64_t edges = 0;
+  for (int i = 0; i < state->nthreads; i++) {
+    state->offsets[i] = total;
+    total += state->locals[i].size;
+    edges += state->locals[i].edges;
+  }
+  state->unvisited_edges -=
+      edges < state->unvisited_edges ? edges : state->unvisited_edges;
+
+  if (!state->bottom_up) {
+    state->bottom_up = total > state->frontier_size &&
+                       edges > state->unvisited_edges / PAR_BFS_ALPHA;
+  } else {
+    state->bottom_up =
+        !(total < state->frontier_size &&
+          total < state->graph->num_nodes / PAR_BFS_BETA);
+  }
+  state->reached += total;
+  state->frontier_size = total;
+  state->level++;
+  atomic_store(&state->next_chunk, 0);
+}
+
+// Static share of [0, count) for a thread
+static void thread_range(size_t count, int thread, int nthreads, size_t *start,
+                         size_t *end) {
+  *start = count * thread / nthreads;
+  *end = count * (thread + 1) / nthreads;
+}
+
+static void bfs_worker(int thread, void *ctx) {
+  BFSState *state = (BFSState *)ctx;
+  LocalFrontier *local = &state->locals[thread];
+  size_t start, end;
+
+  thread_range(state->graph->num_nodes, thread, state->nthreads, &start,
+               &end);
+  for (size_t i = start; i < end; i++) {
+    state->dist[i] = -1;
+    state->parent[i] = CSR_NONE;
+  }
+  if (parallel_barrier_wait(&state->barrier)) {
+    state->dist[state->source] = 0;
+    claim_bit(state->visited, state->source);
+  }
+  parallel_barrier_wait(&state->barrier);
+
+  while (1) {
+    local->size = 0;
+    local->edges = 0;
+    if (state->bottom_up)
+      bottom_up_step(state, local);
+    else
+      top_down_step(state, local);
+
+    if (parallel_barrier_wait(&state->barrier))
+      plan_next_level(state);
+    parallel_barrier_wait(&state->barrier);
+    if (state->frontier_size == 0 || atomic_load(&state->failed))
+      break;
+
+    // Materialize the next frontier in the form its step reads
+    if (local->size)
+      memcpy(state->queue + state->offsets[thread], local->nodes,
+             local->size * sizeof(uint32_t));
+    if (state->bottom_up) {
+      thread_range(state->words, thread, state->nthreads, &start, &end);
+      for (size_t i = start; i < end; i++) {
+        atomic_store_explicit(&state->frontier_bits[i], 0,
+                              memory_order_relaxed);
+      }
+      parallel_barrier_wait(&state->barrier);
+      for (size_t i = 0; i < local->size; i++) {
+        claim_bit(state->frontier_bits, local->nodes[i]);
+      }
+    }
+    parallel_barrier_wait(&state->barrier);
+  }
+}
+
+size_t par_bfs(const CSRGraph *graph, uint32_t source, int nthreads,
+               int32_t *dist, uint32_t *parent) {
+  if (!graph || source >= graph->num_nodes || !dist || !parent)
+    return 0;
+  if (nthreads <= 0)
+    nthreads = parallel_default_threads();
+
+  BFSState state;
+  memset(&state, 0, sizeof(state));
+  state.graph = graph;
+  state.nthreads = nthreads;
+  state.source = source;
+  state.dist = dist;
+  state.parent = parent;
+  state.words = (graph->num_nodes + 63) / 64;
+  state.visited =
+      (_Atomic uint64_t *)calloc(state.words, sizeof(_Atomic uint64_t));
+  state.frontier_bits =
+      (_Atomic uint64_t *)calloc(state.words, sizeof(_Atomic uint64_t));
+  state.queue = (uint32_t *)malloc(graph->num_nodes * sizeof(uint32_t));
+  state.offsets = (size_t *)malloc(nthreads * sizeof(size_t));
+  state.locals = (LocalFrontier *)calloc(nthreads, sizeof(LocalFrontier));
+  atomic_init(&state.next_chunk, 0);
+  atomic_init(&state.failed, false);
+  state.frontier_size = 1;
+  state.reached = 1;
+  state.unvisited_edges = graph->offsets[CSR_OUTGOING][graph->num_nodes] -
+                          csr_degree(graph, CSR_OUTGOING, source);
+
+  size_t reached = 0;
+  if (state.visited && state.frontier_bits && state.queue && state.offsets &&
+      state.locals) {
+    state.queue[0] = source;
+    parallel_barrier_init(&state.barrier, nthreads);
+    if (parallel_run(nthreads, bfs_worker, &state) == 0 &&
+        !atomic_load(&state.failed))
+      reached = state.reached;
+    parallel_barrier_destroy(&state.barrier);
+  }
+
+  for (int i = 0; state.locals && i < nthreads; i++) {
+    free(state.locals[i].nodes);
+  }
+  free((void *)state.visited);
+  free((void *)state.frontier_bits);
+  free(state.queue);
+  free(state.offsets);
+  free(state.locals);
+  return reached;
+}
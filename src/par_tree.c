@@ -0,0 +1,307 @@
+#include "par_tree.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Frames kept on the C stack before the walk spills to the heap
+#define TREE_REDUCE_INLINE_DEPTH 32
+
+// A run of siblings handed to another worker
+typedef struct RangeTask {
+  Task task;
+  TaskPool *pool;
+  Node *node;
+  size_t lo;
+  size_t hi;
+  const TreeReduceOps *ops;
+  void *ctx;
+  bool ok;
+  struct RangeTask *next; // Other ranges split off the same frame
+  _Alignas(max_align_t) unsigned char acc[TREE_REDUCE_MAX_SIZE];
+} RangeTask;
+
+// One level of the explicit walk: children [next, end) of node are still to
+// be folded into acc, and spawned holds the ranges split off past end,
+// newest (lowest) first
+typedef struct Frame {
+  Node *node;
+  size_t next;
+  size_t end;
+  RangeTask *spawned;
+  _Alignas(max_align_t) unsigned char acc[TREE_REDUCE_MAX_SIZE];
+} Frame;
+
+static void run_range(Task *task);
+
+// Hands the upper half of the frame's remaining children to the pool
+static void split_frame(TaskPool *pool, Frame *frame, const TreeReduceOps *ops,
+                        void *ctx) {
+  RangeTask *range = (RangeTask *)malloc(sizeof(RangeTask));
+  if (!range)
+    return;
+  size_t mid = frame->next + (frame->end - frame->next) / 2;
+  range->task.run = run_range;
+  range->pool = pool;
+  range->node = frame->node;
+  range->lo = mid;
+  range->hi = frame->end;
+  range->ops = ops;
+  range->ctx = ctx;
+  range->ok = true;
+  range->next = frame->spawned;
+  frame->spawned = range;
+  frame->end = mid;
+  taskpool_spawn(pool, &range->task);
+}
+
+// Folds children [lo, hi) of node into acc, which starts as the identity
+static bool reduce_range(TaskPool *pool, Node *node, size_t lo, size_t hi,
+                         const TreeReduceOps *ops, void *ctx, void *acc) {
+  Frame inline_frames[TREE_REDUCE_INLINE_DEPTH];
+  Frame *frames = inline_frames;
+  size_t capacity = TREE_REDUCE_INLINE_DEPTH;
+  size_t depth = 1;
+  bool ok = true;
+
+  frames[0].node = node;
+  frames[0].next = lo;
+  frames[0].end = hi;
+  frames[0].spawned = NULL;
+  memcpy(frames[0].acc, acc, ops->size);
+
+  while (1) {
+    Frame *frame = &frames[depth - 1];
+    if (frame->next < frame->end) {
+      if (frame->end - frame->next >= 2 && taskpool_hungry(pool))
+        split_frame(pool, frame, ops, ctx);
+      Node *child = frame->node->children->nodes[frame->next++];
+      if (depth == capacity) {
+        Frame *grown = (Frame *)malloc(2 * capacity * sizeof(Frame));
+        if (!grown) {
+          // Leave the child out; the result is discarded anyway
+          ok = false;
+          continue;
+        }
+        memcpy(grown, frames, depth * sizeof(Frame));
+        if (frames != inline_frames)
+          free(frames);
+        frames = grown;
+        capacity *= 2;
+      }
+      Frame *pushed = &frames[depth++];
+      pushed->node = child;
+      pushed->next = 0;
+      pushed->end = nodeset_size(child->children);
+      pushed->spawned = NULL;
+      ops->identity(pushed->acc, ctx);
+      continue;
+    }
+
+    // Everything below this frame is done; fold in the split-off ranges,
+    // which follow the frame's own children in order. A range nobody stole
+    // goes back into this walk rather than running as a nested call, which
+    // would recurse once per level on deep trees.
+    if (frame->spawned && taskpool_take_back(pool, &frame->spawned->task)) {
+      RangeTask *range = frame->spawned;
+      frame->end = range->hi;
+      frame->spawned = range->next;
+      free(range);
+      continue;
+    }
+    while (frame->spawned) {
+      RangeTask *range = frame->spawned;
+      taskpool_wait(pool, &range->task);
+      ops->combine(frame->acc, range->acc, ctx);
+      ok = ok && range->ok;
+      frame->spawned = range->next;
+      free(range);
+    }
+    if (depth == 1)
+      break;
+    ops->finish(frame->node, frame->acc, ctx);
+    ops->combine(frames[depth - 2].acc, frame->acc, ctx);
+    depth--;
+  }
+
+  memcpy(acc, frames[0].acc, ops->size);
+  if (frames != inline_frames)
+    free(frames);
+  return ok;
+}
+
+static void run_range(Task *task) {
+  RangeTask *range = (RangeTask *)task;
+  range->ops->identity(range->acc, range->ctx);
+  range->ok = reduce_range(range->pool, range->node, range->lo, range->hi,
+                           range->ops, range->ctx, range->acc);
+}
+
+typedef struct {
+  Task task;
+  TaskPool *pool;
+  Node *root;
+  const TreeReduceOps *ops;
+  void *ctx;
+  void *result;
+  bool ok;
+} RootTask;
+
+static void run_root(Task *task) {
+  RootTask *root = (RootTask *)task;
+  const TreeReduceOps *ops = root->ops;
+  ops->identity(root->result, root->ctx);
+  root->ok = reduce_range(root->pool, root->root, 0,
+                          nodeset_size(root->root->children), ops, root->ctx,
+                          root->result);
+  ops->finish(root->root, root->result, root->ctx);
+}
+
+bool tree_reduce(TaskPool *pool, Node *root, const TreeReduceOps *ops,
+                 void *ctx, void *result) {
+  if (!root || !ops || !result || ops->size > TREE_REDUCE_MAX_SIZE)
+    return false;
+  RootTask task = {{run_root, false}, pool, root, ops, ctx, result, false};
+  taskpool_run(pool, &task.task);
+  return task.ok;
+}
+
+// Accumulator for TreeStats: the two largest child heights, sums and the
+// best child diameter. A finished node result is one "child" (count 1,
+// top1 = its height).
+typedef struct {
+  int top1;
+  int top2;
+  int size;
+  int leaves;
+  int diameter;
+  int count;
+} StatsAcc;
+
+static void stats_identity(void *acc, void *ctx) {
+  (void)ctx;
+  StatsAcc *stats = (StatsAcc *)acc;
+  stats->top1 = -1;
+  stats->top2 = -1;
+  stats->size = 0;
+  stats->leaves = 0;
+  stats->diameter = 0;
+  stats->count = 0;
+}
+
+static void stats_combine(void *acc, const void *other, void *ctx) {
+  (void)ctx;
+  StatsAcc *stats = (StatsAcc *)acc;
+  const StatsAcc *more = (const StatsAcc *)other;
+  int candidates[2] = {more->top1, more->top2};
+  for (int i = 0; i < 2; i++) {
+    if (candidates[i] > stats->top1) {
+      stats->top2 = stats->top1;
+      stats->top1 = candidates[i];
+    } else if (candidates[i] > stats->top2) {
+      stats->top2 = candidates[i];
+    }
+  }
+  stats->size += more->size;
+  stats->leaves += more->leaves;
+  if (more->diameter > stats->diameter)
+    stats->diameter = more->diameter;
+  stats->count += more->count;
+}
+
+static void stats_finish(Node *node, void *acc, void *ctx) {
+  (void)node;
+  (void)ctx;
+  StatsAcc *stats = (StatsAcc *)acc;
+  bool leaf = stats->count == 0;
+  int max1 = stats->top1 > 0 ? stats->top1 : 0;
+  int max2 = stats->top2 > 0 ? stats->top2 : 0;
+  int through_node = max1 + max2 + 1;
+  if (through_node > stats->diameter)
+    stats->diameter = through_node;
+  stats->top1 = leaf ? 0 : stats->top1 + 1;
+  stats->top2 = -1;
+  stats->size += 1;
+  stats->leaves = leaf ? 1 : stats->leaves;
+  stats->count = 1;
+}
+
+static const TreeReduceOps stats_ops = {sizeof(StatsAcc), stats_identity,
+                                        stats_combine, stats_finish};
+
+bool par_tree_stats(TaskPool *pool, Node *root, TreeStats *stats) {
+  if (!stats)
+    return false;
+  if (!root) {
+    memset(stats, 0, sizeof(*stats));
+    return true;
+  }
+  StatsAcc acc;
+  if (!tree_reduce(pool, root, &stats_ops, NULL, &acc))
+    return false;
+  stats->height = acc.top1;
+  stats->size = acc.size;
+  stats->leaves = acc.leaves;
+  stats->diameter = acc.diameter;
+  return true;
+}
+
+int par_height(TaskPool *pool, Node *root) {
+  TreeStats stats;
+  return par_tree_stats(pool, root, &stats) ? stats.height : -1;
+}
+
+int par_num_nodes(TaskPool *pool, Node *root) {
+  TreeStats stats;
+  return par_tree_stats(pool, root, &stats) ? stats.size : -1;
+}
+
+int par_num_leaves(TaskPool *pool, Node *root) {
+  TreeStats stats;
+  return par_tree_stats(pool, root, &stats) ? stats.leaves : -1;
+}
+
+int par_diameter(TaskPool *pool, Node *root) {
+  TreeStats stats;
+  return par_tree_stats(pool, root, &stats) ? stats.diameter : -1;
+}
+
+typedef struct {
+  NodeVisitor visit;
+  void *ctx;
+  atomic_bool stopped;
+} PostorderState;
+
+static void postorder_nothing(void *acc, void *ctx) {
+  (void)acc;
+  (void)ctx;
+}
+
+static void postorder_combine(void *acc, const void *other, void *ctx) {
+  (void)acc;
+  (void)other;
+  (void)ctx;
+}
+
+static void postorder_finish(Node *node, void *acc, void *ctx) {
+  (void)acc;
+  PostorderState *state = (PostorderState *)ctx;
+  if (atomic_load_explicit(&state->stopped, memory_order_relaxed))
+    return;
+  if (state->visit(node, state->ctx) == VISIT_STOP)
+    atomic_store(&state->stopped, true);
+}
+
+bool par_postorder_visit(TaskPool *pool, Node *root, NodeVisitor visit,
+                         void *ctx) {
+  if (!root || !visit)
+    return false;
+  static const TreeReduceOps ops = {1, postorder_nothing, postorder_combine,
+                                    postorder_finish};
+  PostorderState state;
+  state.visit = visit;
+  state.ctx = ctx;
+  atomic_init(&state.stopped, false);
+  unsigned char unused;
+  tree_reduce(pool, root, &ops, &state, &unused);
+  return atomic_load(&state.stopped);
+}
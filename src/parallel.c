@@ -0,0 +1,116 @@
+#include "parallel.h"
+#include <stdlib.h>
+#include <unistd.h>
+
+void parallel_barrier_init(ParallelBarrier *barrier, int count) {
+  pthread_mutex_init(&barrier->mutex, NULL);
+  pthread_cond_init(&barrier->cond, NULL);
+  barrier->count = count;
+  barrier->waiting = 0;
+  barrier->phase = 0;
+}
+
+void parallel_barrier_destroy(ParallelBarrier *barrier) {
+  pthread_mutex_destroy(&barrier->mutex);
+  pthread_cond_destroy(&barrier->cond);
+}
+
+bool parallel_barrier_wait(ParallelBarrier *barrier) {
+  pthread_mutex_lock(&barrier->mutex);
+  unsigned long phase = barrier->phase;
+  bool last = ++barrier->waiting == barrier->count;
+  if (last) {
+    barrier->waiting = 0;
+    barrier->phase++;
+    pthread_cond_broadcast(&barrier->cond);
+  } else {
+    while (phase == barrier->phase) {
+      pthread_cond_wait(&barrier->cond, &barrier->mutex);
+    }
+  }
+  pthread_mutex_unlock(&barrier->mutex);
+  return last;
+}
+
+// Holds the started threads until every one of them exists, so none runs
+// fn (and waits on a barrier for a thread that never comes) before
+// parallel_run knows it can go ahead
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int state; // 0 while starting, 1 to run, -1 to exit without running
+} ParallelGate;
+
+typedef struct {
+  void (*fn)(int thread, void *ctx);
+  void *ctx;
+  int thread;
+  ParallelGate *gate;
+} ParallelTask;
+
+static void *run_task(void *arg) {
+  ParallelTask *task = (ParallelTask *)arg;
+  ParallelGate *gate = task->gate;
+  pthread_mutex_lock(&gate->mutex);
+  while (gate->state == 0) {
+    pthread_cond_wait(&gate->cond, &gate->mutex);
+  }
+  int state = gate->state;
+  pthread_mutex_unlock(&gate->mutex);
+  if (state > 0)
+    task->fn(task->thread, task->ctx);
+  return NULL;
+}
+
+static void open_gate(ParallelGate *gate, int state) {
+  pthread_mutex_lock(&gate->mutex);
+  gate->state = state;
+  pthread_cond_broadcast(&gate->cond);
+  pthread_mutex_unlock(&gate->mutex);
+}
+
+int parallel_run(int nthreads, void (*fn)(int thread, void *ctx), void *ctx) {
+  if (nthreads < 1)
+    nthreads = 1;
+  pthread_t *threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+  ParallelTask *tasks = (ParallelTask *)malloc(nthreads * sizeof(ParallelTask));
+  if (!threads || !tasks) {
+    free(threads);
+    free(tasks);
+    return -1;
+  }
+  ParallelGate gate;
+  pthread_mutex_init(&gate.mutex, NULL);
+  pthread_cond_init(&gate.cond, NULL);
+  gate.state = 0;
+  for (int i = 0; i < nthreads; i++) {
+    tasks[i].fn = fn;
+    tasks[i].ctx = ctx;
+    tasks[i].thread = i;
+    tasks[i].gate = &gate;
+  }
+  int started = 1;
+  while (started < nthreads &&
+         pthread_create(&threads[started], NULL, run_task,
+                        &tasks[started]) == 0) {
+    started++;
+  }
+  // A thread that could not start sends the others home before fn runs
+  bool ok = started == nthreads;
+  open_gate(&gate, ok ? 1 : -1);
+  if (ok)
+    fn(0, ctx);
+  for (int i = 1; i < started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  pthread_mutex_destroy(&gate.mutex);
+  pthread_cond_destroy(&gate.cond);
+  free(threads);
+  free(tasks);
+  return ok ? 0 : -1;
+}
+
+int parallel_default_threads(void) {
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int)count : 1;
+}
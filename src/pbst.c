@@ -0,0 +1,249 @@
+#include "pbst.h"
+#include "bst.h"
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static PBSTNode *retain_node(PBSTNode *node) {
+  if (node)
+    atomic_fetch_add_explicit(&node->refcount, 1, memory_order_relaxed);
+  return node;
+}
+
+static void release_node(PBSTNode *node) {
+  while (node &&
+         atomic_fetch_sub_explicit(&node->refcount, 1, memory_order_acq_rel) ==
+             1) {
+    PBSTNode *right = node->right;
+    release_node(node->left);
+    free(node);
+    node = right;
+  }
+}
+
+// Takes ownership of the references to left and right
+static PBSTNode *new_node(int value, unsigned int priority, PBSTNode *left,
+                          PBSTNode *right) {
+  PBSTNode *node = (PBSTNode *)malloc(sizeof(PBSTNode));
+  if (!node) {
+    release_node(left);
+    release_node(right);
+    return NULL;
+  }
+  node->value = value;
+  node->priority = priority;
+  atomic_init(&node->refcount, 1);
+  node->left = left;
+  node->right = right;
+  return node;
+}
+
+// Rotations only ever run on freshly copied nodes that no other version can
+// see yet, so they can relink in place
+static PBSTNode *rotate_right(PBSTNode *node) {
+  PBSTNode *left = node->left;
+  node->left = left->right;
+  left->right = node;
+  return left;
+}
+
+static PBSTNode *rotate_left(PBSTNode *node) {
+  PBSTNode *right = node->right;
+  node->right = right->left;
+  right->left = node;
+  return right;
+}
+
+// The helpers below borrow their arguments and return an owned reference.
+// On allocation failure they release whatever they copied so far.
+
+// Never NULL on success, since it adds a node, so NULL means failure
+static PBSTNode *insert_recursive(PBSTNode *root, int value) {
+  if (root == NULL)
+    return new_node(value, bst_priority(value), NULL, NULL);
+
+  PBSTNode *copy;
+  if (value < root->value) {
+    PBSTNode *left = insert_recursive(root->left, value);
+    if (!left)
+      return NULL;
+    copy = new_node(root->value, root->priority, left,
+                    retain_node(root->right));
+    if (copy && left->priority > copy->priority)
+      copy = rotate_right(copy);
+  } else {
+    PBSTNode *right = insert_recursive(root->right, value);
+    if (!right)
+      return NULL;
+    copy = new_node(root->value, root->priority, retain_node(root->left),
+                    right);
+    if (copy && right->priority > copy->priority)
+      copy = rotate_left(copy);
+  }
+  return copy;
+}
+
+// An empty result is valid here, so failure is reported through *failed
+static PBSTNode *join_recursive(PBSTNode *left, PBSTNode *right,
+                                bool *failed) {
+  if (left == NULL)
+    return retain_node(right);
+  if (right == NULL)
+    return retain_node(left);
+  PBSTNode *node = NULL;
+  if (left->priority > right->priority) {
+    PBSTNode *joined = join_recursive(left->right, right, failed);
+    if (joined)
+      node = new_node(left->value, left->priority, retain_node(left->left),
+                      joined);
+  } else {
+    PBSTNode *joined = join_recursive(left, right->left, failed);
+    if (joined)
+      node = new_node(right->value, right->priority, joined,
+                      retain_node(right->right));
+  }
+  // Both inputs are non-empty, so the join is too
+  if (!node)
+    *failed = true;
+  return node;
+}
+
+static PBSTNode *delete_recursive(PBSTNode *root, int value, bool *failed) {
+  if (value == root->value)
+    return join_recursive(root->left, root->right, failed);
+  PBSTNode *node;
+  if (value < root->value) {
+    PBSTNode *left = delete_recursive(root->left, value, failed);
+    if (*failed)
+      return NULL;
+    node = new_node(root->value, root->priority, left,
+                    retain_node(root->right));
+  } else {
+    PBSTNode *right = delete_recursive(root->right, value, failed);
+    if (*failed)
+      return NULL;
+    node = new_node(root->value, root->priority, retain_node(root->left),
+                    right);
+  }
+  if (!node)
+    *failed = true;
+  return node;
+}
+
+PBST pbst_insert(const PBST *version, int value) {
+  if (pbst_search(version, value) != NULL)
+    return pbst_retain(version);
+  PBSTNode *root = insert_recursive(version ? version->root : NULL, value);
+  if (!root)
+    return pbst_retain(version);
+  PBST next = {root, (version ? version->size : 0) + 1};
+  return next;
+}
+
+PBST pbst_delete(const PBST *version, int value) {
+  if (pbst_search(version, value) == NULL)
+    return pbst_retain(version);
+  bool failed = false;
+  PBSTNode *root = delete_recursive(version->root, value, &failed);
+  if (failed)
+    return pbst_retain(version);
+  PBST next = {root, version->size - 1};
+  return next;
+}
+
+PBST pbst_retain(const PBST *version) {
+  PBST copy = {NULL, 0};
+  if (version) {
+    copy.root = retain_node(version->root);
+    copy.size = version->size;
+  }
+  return copy;
+}
+
+void pbst_release(PBST *version) {
+  if (version == NULL)
+    return;
+  release_node(version->root);
+  version->root = NULL;
+  version->size = 0;
+}
+
+PBSTHandle *pbst_handle_create(void) {
+  PBSTHandle *handle = (PBSTHandle *)malloc(sizeof(PBSTHandle));
+  PBST *empty = (PBST *)calloc(1, sizeof(PBST));
+  if (!handle || !empty) {
+    free(handle);
+    free(empty);
+    return NULL;
+  }
+  atomic_init(&handle->current, empty);
+  atomic_init(&handle->epoch, 0);
+  atomic_init(&handle->readers[0], 0);
+  atomic_init(&handle->readers[1], 0);
+  return handle;
+}
+
+void pbst_handle_destroy(PBSTHandle *handle) {
+  if (handle) {
+    PBST *current = atomic_load(&handle->current);
+    pbst_release(current);
+    free(current);
+    free(handle);
+  }
+}
+
+// A reader that loaded the replaced version counted itself in, under
+// whichever epoch it saw, before the exchange. Flipping the epoch twice and
+// draining the old side each time waits out both counters, while readers
+// arriving meanwhile count under the new epoch and cannot hold the wait up.
+static void wait_for_readers(PBSTHandle *handle) {
+  for (int pass = 0; pass < 2; pass++) {
+    unsigned int old = atomic_fetch_add(&handle->epoch, 1) & 1;
+    while (atomic_load(&handle->readers[old]) != 0) {
+      sched_yield();
+    }
+  }
+}
+
+bool pbst_publish(PBSTHandle *handle, const PBST *version) {
+  PBST *next = (PBST *)malloc(sizeof(PBST));
+  if (!next)
+    return false;
+  *next = pbst_retain(version);
+  PBST *previous = atomic_exchange(&handle->current, next);
+  wait_for_readers(handle);
+  pbst_release(previous);
+  free(previous);
+  return true;
+}
+
+PBST pbst_acquire(PBSTHandle *handle) {
+  unsigned int epoch = atomic_load(&handle->epoch) & 1;
+  atomic_fetch_add(&handle->readers[epoch], 1);
+  PBST version = pbst_retain(atomic_load(&handle->current));
+  atomic_fetch_sub(&handle->readers[epoch], 1);
+  return version;
+}
+
+PBSTNode *pbst_search(const PBST *version, int value) {
+  PBSTNode *current = version ? version->root : NULL;
+  while (current) {
+    if (current->value == value) {
+      return current;
+    } else if (value < current->value) {
+      current = current->left;
+    } else {
+      current = current->right;
+    }
+  }
+  return NULL;
+}
+
+void pbst_inorder(PBSTNode *node, PBSTNode **output, int *index) {
+  if (!node)
+    return;
+  pbst_inorder(node->left, output, index);
+  output[(*index)++] = node;
+  pbst_inorder(node->right, output, index);
+}
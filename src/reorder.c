@@ -0,0 +1,174 @@
+#include "reorder.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t total_degree(const CSRGraph *graph, uint32_t node) {
+  size_t degree = graph->parent[node] != CSR_NONE;
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    degree += csr_degree(graph, (CSRKind)kind, node);
+  }
+  return (uint32_t)degree;
+}
+
+// Appends the unvisited neighbors of node to queue[*tail ..), children
+// first so that a tree's siblings stay together
+static void visit_neighbors(const CSRGraph *graph, uint32_t node,
+                            bool *visited, uint32_t *queue, size_t *tail) {
+  static const CSRKind kinds[] = {CSR_CHILDREN, CSR_EDGES, CSR_OUTGOING,
+                                  CSR_INCOMING};
+  for (int k = 0; k < 4; k++) {
+    const uint32_t *neighbors = csr_neighbors(graph, kinds[k], node);
+    for (size_t j = 0; j < csr_degree(graph, kinds[k], node); j++) {
+      if (!visited[neighbors[j]]) {
+        visited[neighbors[j]] = true;
+        queue[(*tail)++] = neighbors[j];
+      }
+    }
+  }
+  uint32_t parent = graph->parent[node];
+  if (parent != CSR_NONE && !visited[parent]) {
+    visited[parent] = true;
+    queue[(*tail)++] = parent;
+  }
+}
+
+static int compare_keys(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Sorts nodes by increasing key[node], ties by index
+static void sort_by_key(uint32_t *nodes, size_t count, const uint32_t *key,
+                        uint64_t *scratch) {
+  for (size_t i = 0; i < count; i++) {
+    scratch[i] = (uint64_t)key[nodes[i]] << 32 | nodes[i];
+  }
+  qsort(scratch, count, sizeof(uint64_t), compare_keys);
+  for (size_t i = 0; i < count; i++) {
+    nodes[i] = (uint32_t)scratch[i];
+  }
+}
+
+// Breadth-first order; RCM additionally starts each component at a node
+// of least degree and takes neighbors in increasing degree
+static void breadth_first(const CSRGraph *graph, bool cuthill_mckee,
+                          const uint32_t *degree, const uint32_t *starts,
+                          bool *visited, uint32_t *order, uint64_t *scratch) {
+  size_t n = graph->num_nodes, tail = 0;
+  for (size_t s = 0; s < n; s++) {
+    uint32_t start = starts[s];
+    if (visited[start])
+      continue;
+    visited[start] = true;
+    order[tail++] = start;
+    for (size_t head = tail - 1; head < tail; head++) {
+      size_t first = tail;
+      visit_neighbors(graph, order[head], visited, order, &tail);
+      if (cuthill_mckee && tail - first > 1)
+        sort_by_key(order + first, tail - first, degree, scratch);
+    }
+  }
+}
+
+bool reorder_compute(const CSRGraph *graph, ReorderMethod method,
+                     uint32_t *order) {
+  if (!graph || !order)
+    return false;
+  size_t n = graph->num_nodes;
+  if (n == 0)
+    return true;
+  uint32_t *degree = (uint32_t *)malloc(n * sizeof(uint32_t));
+  uint32_t *starts = (uint32_t *)malloc(n * sizeof(uint32_t));
+  bool *visited = (bool *)calloc(n, sizeof(bool));
+  uint64_t *scratch = (uint64_t *)malloc(n * sizeof(uint64_t));
+  if (!degree || !starts || !visited || !scratch) {
+    free(degree);
+    free(starts);
+    free(visited);
+    free(scratch);
+    return false;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    degree[i] = total_degree(graph, i);
+    starts[i] = i;
+  }
+
+  switch (method) {
+  case REORDER_DEGREE:
+    // Descending degree, ties in index order
+    for (uint32_t i = 0; i < n; i++) {
+      degree[i] = UINT32_MAX - degree[i];
+    }
+    sort_by_key(starts, n, degree, scratch);
+    memcpy(order, starts, n * sizeof(uint32_t));
+    break;
+  case REORDER_RCM:
+    sort_by_key(starts, n, degree, scratch);
+    breadth_first(graph, true, degree, starts, visited, order, scratch);
+    for (size_t i = 0; i < n / 2; i++) {
+      uint32_t tmp = order[i];
+      order[i] = order[n - 1 - i];
+      order[n - 1 - i] = tmp;
+    }
+    break;
+  default: {
+    // Roots first, so each tree is laid out level by level from its root
+    size_t roots = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      if (graph->parent[i] == CSR_NONE)
+        starts[roots++] = i;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+      if (graph->parent[i] != CSR_NONE)
+        starts[roots++] = i;
+    }
+    breadth_first(graph, false, degree, starts, visited, order, scratch);
+    break;
+  }
+  }
+  free(degree);
+  free(starts);
+  free(visited);
+  free(scratch);
+  return true;
+}
+
+GraphArena *reorder_nodes(Node **nodes, size_t count, ReorderMethod method,
+                          Node **relocated) {
+  if (!nodes || !relocated)
+    return NULL;
+  CSRGraph *graph = csr_freeze(nodes, count);
+  uint32_t *order = (uint32_t *)malloc((count ? count : 1) * sizeof(uint32_t));
+  Node **ordered = (Node **)malloc((count ? count : 1) * sizeof(Node *));
+  GraphArena *arena = NULL;
+  if (graph && order && ordered && reorder_compute(graph, method, order)) {
+    for (size_t i = 0; i < count; i++) {
+      ordered[i] = nodes[order[i]];
+    }
+    arena = arena_relocate(ordered, count, relocated);
+  }
+  csr_destroy(graph);
+  free(order);
+  free(ordered);
+  return arena;
+}
+
+bool reorder_graph(Graph *graph, ReorderMethod method) {
+  if (!graph)
+    return false;
+  size_t count = graph->num_nodes;
+  CSRGraph *view = csr_freeze(graph->nodes, count);
+  uint32_t *order = (uint32_t *)malloc((count ? count : 1) * sizeof(uint32_t));
+  Node **ordered = (Node **)malloc((count ? count : 1) * sizeof(Node *));
+  bool ok = view && order && ordered && reorder_compute(view, method, order);
+  if (ok) {
+    for (size_t i = 0; i < count; i++) {
+      ordered[i] = graph->nodes[order[i]];
+    }
+    ok = graph_relocate(graph, ordered);
+  }
+  csr_destroy(view);
+  free(order);
+  free(ordered);
+  return ok;
+}
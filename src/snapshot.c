@@ -0,0 +1,354 @@
+#include "snapshot.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char SNAPSHOT_MAGIC[8] = {'J', 'N', 'G', 'L', 'S', 'N', 'A', 'P'};
+// Reads back differently on a machine of the other byte order
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint64_t num_nodes;
+  uint64_t num_entries[CSR_KINDS];
+  uint32_t weighted; // Bit per kind
+  uint32_t has_values;
+  uint64_t value_bytes;
+} SnapshotHeader;
+
+// Byte offsets of the sections, in file order
+typedef struct {
+  uint64_t node_ids;
+  uint64_t parent;
+  uint64_t offsets[CSR_KINDS];
+  uint64_t neighbors[CSR_KINDS];
+  uint64_t weights[CSR_KINDS]; // 0 for unweighted kinds
+  uint64_t value_offsets;      // 0 without values
+  uint64_t values;
+  uint64_t end;
+} SnapshotLayout;
+
+// Places a section of count items at *cursor and moves the cursor past it,
+// to the next multiple of 8. False if the file would not be addressable.
+static bool place(uint64_t *cursor, uint64_t count, uint64_t item_size,
+                  uint64_t *at) {
+  if (count > (SIZE_MAX - *cursor - 8) / item_size)
+    return false;
+  *at = *cursor;
+  *cursor = (*cursor + count * item_size + 7) & ~(uint64_t)7;
+  return true;
+}
+
+static bool snapshot_layout(const SnapshotHeader *header,
+                            SnapshotLayout *layout) {
+  memset(layout, 0, sizeof(*layout));
+  uint64_t n = header->num_nodes;
+  uint64_t cursor = sizeof(SnapshotHeader);
+  if (n >= CSR_NONE || !place(&cursor, n, sizeof(double), &layout->node_ids) ||
+      !place(&cursor, n, sizeof(uint32_t), &layout->parent))
+    return false;
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    if (!place(&cursor, n + 1, sizeof(uint64_t), &layout->offsets[kind]))
+      return false;
+  }
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    uint64_t entries = header->num_entries[kind];
+    if (!place(&cursor, entries, sizeof(uint32_t), &layout->neighbors[kind]))
+      return false;
+    if ((header->weighted >> kind) & 1 &&
+        !place(&cursor, entries, sizeof(uint32_t), &layout->weights[kind]))
+      return false;
+  }
+  if (header->has_values &&
+      (!place(&cursor, n + 1, sizeof(uint64_t), &layout->value_offsets) ||
+       !place(&cursor, header->value_bytes, 1, &layout->values)))
+    return false;
+  layout->end = cursor;
+  return true;
+}
+
+// Pads the file up to offset, then writes size bytes
+static bool write_at(FILE *out, uint64_t offset, const void *data,
+                     size_t size) {
+  static const char zeros[64] = {0};
+  off_t pos = ftello(out);
+  if (pos < 0 || (uint64_t)pos > offset)
+    return false;
+  for (uint64_t gap = offset - (uint64_t)pos; gap > 0;) {
+    size_t chunk = gap < sizeof(zeros) ? (size_t)gap : sizeof(zeros);
+    if (fwrite(zeros, 1, chunk, out) != chunk)
+      return false;
+    gap -= chunk;
+  }
+  return size == 0 || fwrite(data, 1, size, out) == size;
+}
+
+// Writes the encoded values after their offset table, filling the table in
+// afterwards; header->value_bytes receives the blob size
+static bool write_values(FILE *out, const CSRGraph *csr, SnapshotEncode encode,
+                         void *ctx, SnapshotHeader *header,
+                         SnapshotLayout *layout) {
+  size_t n = csr->num_nodes;
+  uint64_t *offsets = (uint64_t *)calloc(n + 1, sizeof(uint64_t));
+  if (!offsets)
+    return false;
+  // Values start right after the table whatever their size
+  uint64_t table = layout->value_offsets;
+  uint64_t start = (table + (n + 1) * sizeof(uint64_t) + 7) & ~(uint64_t)7;
+  bool ok = write_at(out, start, NULL, 0);
+  for (size_t i = 0; ok && i < n; i++) {
+    ok = encode(out, csr->nodes[i]->value, ctx);
+    off_t pos = ftello(out);
+    ok = ok && pos >= 0;
+    offsets[i + 1] = (uint64_t)pos - start;
+  }
+  if (ok) {
+    header->value_bytes = offsets[n];
+    ok = fseeko(out, (off_t)table, SEEK_SET) == 0 &&
+         fwrite(offsets, sizeof(uint64_t), n + 1, out) == n + 1 &&
+         snapshot_layout(header, layout) && layout->values == start &&
+         fseeko(out, 0, SEEK_END) == 0 &&
+         write_at(out, layout->end, NULL, 0);
+  }
+  free(offsets);
+  return ok;
+}
+
+static bool write_file(FILE *out, const CSRGraph *csr, SnapshotEncode encode,
+                       void *ctx) {
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  header.version = SNAPSHOT_VERSION;
+  header.byte_order = SNAPSHOT_BYTE_ORDER;
+  header.num_nodes = csr->num_nodes;
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    header.num_entries[kind] = csr->offsets[kind][csr->num_nodes];
+    if (csr->weights[kind])
+      header.weighted |= 1u << kind;
+  }
+  header.has_values = encode != NULL;
+
+  SnapshotLayout layout;
+  size_t n = csr->num_nodes;
+  // The header goes in last, so an interrupted write has no magic
+  bool ok = snapshot_layout(&header, &layout) &&
+            write_at(out, layout.node_ids, csr->node_ids, n * sizeof(double)) &&
+            write_at(out, layout.parent, csr->parent, n * sizeof(uint32_t));
+  for (int kind = 0; ok && kind < CSR_KINDS; kind++) {
+    ok = write_at(out, layout.offsets[kind], csr->offsets[kind],
+                  (n + 1) * sizeof(uint64_t));
+  }
+  for (int kind = 0; ok && kind < CSR_KINDS; kind++) {
+    size_t bytes = header.num_entries[kind] * sizeof(uint32_t);
+    ok = write_at(out, layout.neighbors[kind], csr->neighbors[kind], bytes);
+    if (ok && csr->weights[kind])
+      ok = write_at(out, layout.weights[kind], csr->weights[kind], bytes);
+  }
+  if (ok && encode)
+    ok = write_values(out, csr, encode, ctx, &header, &layout);
+  else if (ok)
+    ok = write_at(out, layout.end, NULL, 0);
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  return ok && fseeko(out, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof(header), 1, out) == 1;
+}
+
+bool snapshot_write(const char *path, Node **nodes, size_t count,
+                    SnapshotEncode encode, void *ctx) {
+  if (!path || (!nodes && count))
+    return false;
+  Node *none = NULL;
+  CSRGraph *csr = csr_freeze(nodes ? nodes : &none, count);
+  size_t length = strlen(path);
+  char *temp = (char *)malloc(length + 5);
+  if (!csr || !temp) {
+    csr_destroy(csr);
+    free(temp);
+    return false;
+  }
+  memcpy(temp, path, length);
+  memcpy(temp + length, ".tmp", 5);
+  FILE *out = fopen(temp, "wb");
+  bool ok = out && write_file(out, csr, encode, ctx);
+  if (out && fclose(out) != 0)
+    ok = false;
+  ok = ok && rename(temp, path) == 0;
+  if (!ok && out)
+    unlink(temp);
+  free(temp);
+  csr_destroy(csr);
+  return ok;
+}
+
+Snapshot *snapshot_open(const char *path) {
+  if (!path)
+    return NULL;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = (size_t)st.st_size;
+  void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  const SnapshotHeader *header = (const SnapshotHeader *)map;
+  SnapshotLayout layout;
+  Snapshot *snapshot = NULL;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0 &&
+      header->version == SNAPSHOT_VERSION &&
+      header->byte_order == SNAPSHOT_BYTE_ORDER &&
+      snapshot_layout(header, &layout) && layout.end == size)
+    snapshot = (Snapshot *)calloc(1, sizeof(Snapshot));
+  if (!snapshot) {
+    munmap(map, size);
+    return NULL;
+  }
+  char *base = (char *)map;
+  CSRGraph *graph = &snapshot->graph;
+  graph->num_nodes = header->num_nodes;
+  graph->node_ids = (double *)(base + layout.node_ids);
+  graph->parent = (uint32_t *)(base + layout.parent);
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    graph->offsets[kind] = (uint64_t *)(base + layout.offsets[kind]);
+    graph->neighbors[kind] = (uint32_t *)(base + layout.neighbors[kind]);
+    if (layout.weights[kind])
+      graph->weights[kind] = (uint32_t *)(base + layout.weights[kind]);
+  }
+  if (header->has_values) {
+    snapshot->value_offsets = (const uint64_t *)(base + layout.value_offsets);
+    snapshot->values = (const unsigned char *)(base + layout.values);
+  }
+  snapshot->map = map;
+  snapshot->map_size = size;
+  return snapshot;
+}
+
+void snapshot_close(Snapshot *snapshot) {
+  if (snapshot) {
+    munmap(snapshot->map, snapshot->map_size);
+    free(snapshot);
+  }
+}
+
+bool snapshot_validate(const Snapshot *snapshot) {
+  if (!snapshot)
+    return false;
+  const SnapshotHeader *header = (const SnapshotHeader *)snapshot->map;
+  const CSRGraph *graph = &snapshot->graph;
+  size_t n = graph->num_nodes;
+  for (size_t i = 0; i < n; i++) {
+    if (graph->parent[i] != CSR_NONE && graph->parent[i] >= n)
+      return false;
+  }
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    const uint64_t *offsets = graph->offsets[kind];
+    if (offsets[0] != 0 || offsets[n] != header->num_entries[kind])
+      return false;
+    for (size_t i = 0; i < n; i++) {
+      if (offsets[i] > offsets[i + 1])
+        return false;
+    }
+    for (uint64_t j = 0; j < offsets[n]; j++) {
+      if (graph->neighbors[kind][j] >= n)
+        return false;
+    }
+  }
+  if (snapshot->value_offsets) {
+    const uint64_t *offsets = snapshot->value_offsets;
+    if (offsets[0] != 0 || offsets[n] != header->value_bytes)
+      return false;
+    for (size_t i = 0; i < n; i++) {
+      if (offsets[i] > offsets[i + 1])
+        return false;
+    }
+  }
+  return true;
+}
+
+const void *snapshot_value(const Snapshot *snapshot, uint32_t node,
+                           size_t *size) {
+  if (!snapshot || !snapshot->value_offsets ||
+      node >= snapshot->graph.num_nodes)
+    return NULL;
+  if (size)
+    *size = snapshot->value_offsets[node + 1] - snapshot->value_offsets[node];
+  return snapshot->values + snapshot->value_offsets[node];
+}
+
+static NodeSet *node_set(Node *node, CSRKind kind) {
+  switch (kind) {
+  case CSR_EDGES:
+    return node->edges;
+  case CSR_INCOMING:
+    return node->incoming;
+  case CSR_OUTGOING:
+    return node->outgoing;
+  default:
+    return node->children;
+  }
+}
+
+Graph *snapshot_to_graph(const Snapshot *snapshot, SnapshotDecode decode,
+                         void *ctx) {
+  if (!snapshot)
+    return NULL;
+  const CSRGraph *csr = &snapshot->graph;
+  size_t n = csr->num_nodes;
+  Graph *graph = graph_create(n);
+  if (!graph)
+    return NULL;
+  for (size_t i = 0; i < n; i++) {
+    if (!graph_add_node(graph, NULL, csr->node_ids[i])) {
+      graph_destroy(graph);
+      return NULL;
+    }
+  }
+  Node **nodes = graph->nodes;
+  for (size_t i = 0; i < n; i++) {
+    Node *node = nodes[i];
+    if (csr->parent[i] != CSR_NONE)
+      node->parent = nodes[csr->parent[i]];
+    for (int kind = 0; kind < CSR_KINDS; kind++) {
+      NodeSet *set = node_set(node, (CSRKind)kind);
+      size_t degree = csr_degree(csr, (CSRKind)kind, (uint32_t)i);
+      const uint32_t *neighbors =
+          csr_neighbors(csr, (CSRKind)kind, (uint32_t)i);
+      const uint32_t *weights = csr_weights(csr, (CSRKind)kind, (uint32_t)i);
+      if (!degree)
+        continue;
+      if (!nodeset_reserve(set, degree, weights != NULL)) {
+        graph_destroy(graph);
+        return NULL;
+      }
+      for (size_t j = 0; j < degree; j++) {
+        if (weights)
+          set->weights[j] = weights[j];
+        set->nodes[j] = nodes[neighbors[j]];
+      }
+      set->size = degree;
+      // Members are distinct already; this only builds the index
+      if (degree > NODESET_INDEX_THRESHOLD)
+        nodeset_dedup(set);
+    }
+  }
+  // Values last, so a failure above leaves nothing for the caller to free
+  if (decode && snapshot->value_offsets) {
+    for (size_t i = 0; i < n; i++) {
+      size_t size;
+      const void *data = snapshot_value(snapshot, (uint32_t)i, &size);
+      nodes[i]->value = decode(data, size, ctx);
+    }
+  }
+  return graph;
+}
@@ -0,0 +1,293 @@
+#include "sssp.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Radix heap: an entry sits in the bucket of the highest bit where its key
+// differs from the last popped key. Only bucket 0 holds entries equal to
+// it; refilling bucket 0 redistributes the first non-empty bucket, whose
+// entries all land in strictly lower buckets.
+#define RADIX_BUCKETS 65
+
+typedef struct {
+  uint64_t key;
+  uint32_t node;
+} HeapItem;
+
+typedef struct {
+  HeapItem *items;
+  size_t size;
+  size_t capacity;
+} Bucket;
+
+typedef struct {
+  Bucket buckets[RADIX_BUCKETS];
+  uint64_t last; // Smallest key still allowed
+  size_t size;
+} RadixHeap;
+
+static int bucket_of(uint64_t key, uint64_t last) {
+  return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+}
+
+static bool bucket_push(Bucket *bucket, HeapItem item) {
+  if (bucket->size == bucket->capacity) {
+    size_t capacity = bucket->capacity ? 2 * bucket->capacity : 16;
+    HeapItem *items =
+        (HeapItem *)realloc(bucket->items, capacity * sizeof(HeapItem));
+    if (!items)
+      return false;
+    bucket->items = items;
+    bucket->capacity = capacity;
+  }
+  bucket->items[bucket->size++] = item;
+  return true;
+}
+
+static void heap_clear(RadixHeap *heap) {
+  for (int i = 0; i < RADIX_BUCKETS; i++) {
+    heap->buckets[i].size = 0;
+  }
+  heap->last = 0;
+  heap->size = 0;
+}
+
+static void heap_free(RadixHeap *heap) {
+  for (int i = 0; i < RADIX_BUCKETS; i++) {
+    free(heap->buckets[i].items);
+  }
+  memset(heap, 0, sizeof(RadixHeap));
+}
+
+// key must not be below the last popped key
+static bool heap_push(RadixHeap *heap, uint64_t key, uint32_t node) {
+  HeapItem item = {key, node};
+  if (!bucket_push(&heap->buckets[bucket_of(key, heap->last)], item))
+    return false;
+  heap->size++;
+  return true;
+}
+
+// Moves the smallest keys into bucket 0; the heap must not be empty
+static bool heap_settle(RadixHeap *heap) {
+  if (heap->buckets[0].size)
+    return true;
+  int i = 1;
+  while (!heap->buckets[i].size) {
+    i++;
+  }
+  Bucket *bucket = &heap->buckets[i];
+  uint64_t min = bucket->items[0].key;
+  for (size_t j = 1; j < bucket->size; j++) {
+    if (bucket->items[j].key < min)
+      min = bucket->items[j].key;
+  }
+  heap->last = min;
+  for (size_t j = 0; j < bucket->size; j++) {
+    HeapItem item = bucket->items[j];
+    if (!bucket_push(&heap->buckets[bucket_of(item.key, min)], item))
+      return false;
+  }
+  bucket->size = 0;
+  return true;
+}
+
+// Call after heap_settle
+static HeapItem heap_pop(RadixHeap *heap) {
+  heap->size--;
+  Bucket *bucket = &heap->buckets[0];
+  return bucket->items[--bucket->size];
+}
+
+static uint32_t edge_weight(const uint32_t *weights, uint64_t edge) {
+  return weights ? weights[edge] : EDGE_DEFAULT_WEIGHT;
+}
+
+bool sssp_dijkstra(const CSRGraph *graph, CSRKind kind, uint32_t source,
+                   uint64_t *dist, uint32_t *parent) {
+  if (!graph || !dist || source >= graph->num_nodes || kind >= CSR_KINDS)
+    return false;
+  for (size_t i = 0; i < graph->num_nodes; i++) {
+    dist[i] = SSSP_INF;
+    if (parent)
+      parent[i] = CSR_NONE;
+  }
+  const uint64_t *offsets = graph->offsets[kind];
+  const uint32_t *neighbors = graph->neighbors[kind];
+  const uint32_t *weights = graph->weights[kind];
+  RadixHeap heap;
+  memset(&heap, 0, sizeof(RadixHeap));
+  dist[source] = 0;
+  bool ok = heap_push(&heap, 0, source);
+  while (ok && heap.size) {
+    if (!heap_settle(&heap)) {
+      ok = false;
+      break;
+    }
+    HeapItem item = heap_pop(&heap);
+    // Entries left behind by a later decrease are stale
+    if (item.key != dist[item.node])
+      continue;
+    for (uint64_t e = offsets[item.node]; e < offsets[item.node + 1]; e++) {
+      uint32_t v = neighbors[e];
+      uint64_t candidate = item.key + edge_weight(weights, e);
+      if (candidate < dist[v]) {
+        dist[v] = candidate;
+        if (parent)
+          parent[v] = item.node;
+        if (!heap_push(&heap, candidate, v)) {
+          ok = false;
+          break;
+        }
+      }
+    }
+  }
+  heap_free(&heap);
+  return ok;
+}
+
+// Side 0 searches forward from the source, side 1 backward from the target
+struct SSSPSearch {
+  const CSRGraph *graph;
+  CSRKind kinds[2];
+  uint64_t *dist[2];
+  uint32_t *parent[2];
+  uint32_t *stamp; // Per-node state is valid only when stamp == epoch
+  uint32_t epoch;
+  RadixHeap heaps[2];
+};
+
+SSSPSearch *sssp_search_create(const CSRGraph *graph, CSRKind kind) {
+  if (!graph || kind == CSR_CHILDREN || kind >= CSR_KINDS)
+    return NULL;
+  SSSPSearch *search = (SSSPSearch *)calloc(1, sizeof(SSSPSearch));
+  if (!search)
+    return NULL;
+  size_t n = graph->num_nodes ? graph->num_nodes : 1;
+  search->graph = graph;
+  search->kinds[0] = kind;
+  search->kinds[1] = kind == CSR_OUTGOING   ? CSR_INCOMING
+                     : kind == CSR_INCOMING ? CSR_OUTGOING
+                                            : CSR_EDGES;
+  search->stamp = (uint32_t *)calloc(n, sizeof(uint32_t));
+  bool ok = search->stamp != NULL;
+  for (int side = 0; side < 2; side++) {
+    search->dist[side] = (uint64_t *)malloc(n * sizeof(uint64_t));
+    search->parent[side] = (uint32_t *)malloc(n * sizeof(uint32_t));
+    ok = ok && search->dist[side] && search->parent[side];
+  }
+  if (!ok) {
+    sssp_search_destroy(search);
+    return NULL;
+  }
+  return search;
+}
+
+void sssp_search_destroy(SSSPSearch *search) {
+  if (!search)
+    return;
+  for (int side = 0; side < 2; side++) {
+    free(search->dist[side]);
+    free(search->parent[side]);
+    heap_free(&search->heaps[side]);
+  }
+  free(search->stamp);
+  free(search);
+}
+
+// Resets a node's state the first time a query reaches it
+static void touch(SSSPSearch *search, uint32_t node) {
+  if (search->stamp[node] == search->epoch)
+    return;
+  search->stamp[node] = search->epoch;
+  for (int side = 0; side < 2; side++) {
+    search->dist[side][node] = SSSP_INF;
+    search->parent[side][node] = CSR_NONE;
+  }
+}
+
+static void write_path(SSSPSearch *search, uint32_t meet, uint32_t *path,
+                       size_t *path_len) {
+  size_t len = 0;
+  for (uint32_t u = meet; u != CSR_NONE; u = search->parent[0][u]) {
+    path[len++] = u;
+  }
+  for (size_t i = 0; i < len / 2; i++) {
+    uint32_t tmp = path[i];
+    path[i] = path[len - 1 - i];
+    path[len - 1 - i] = tmp;
+  }
+  for (uint32_t u = search->parent[1][meet]; u != CSR_NONE;
+       u = search->parent[1][u]) {
+    path[len++] = u;
+  }
+  if (path_len)
+    *path_len = len;
+}
+
+uint64_t sssp_search_path(SSSPSearch *search, uint32_t source,
+                          uint32_t target, uint32_t *path, size_t *path_len) {
+  if (path_len)
+    *path_len = 0;
+  if (!search || source >= search->graph->num_nodes ||
+      target >= search->graph->num_nodes)
+    return SSSP_INF;
+  if (++search->epoch == 0) {
+    memset(search->stamp, 0, search->graph->num_nodes * sizeof(uint32_t));
+    search->epoch = 1;
+  }
+  const CSRGraph *graph = search->graph;
+  uint32_t ends[2] = {source, target};
+  bool ok = true;
+  for (int side = 0; side < 2; side++) {
+    heap_clear(&search->heaps[side]);
+    touch(search, ends[side]);
+    search->dist[side][ends[side]] = 0;
+    ok = ok && heap_push(&search->heaps[side], 0, ends[side]);
+  }
+
+  uint64_t best = source == target ? 0 : SSSP_INF;
+  uint32_t meet = source == target ? source : CSR_NONE;
+  // Any path still to be found is at least as long as the two frontier
+  // keys together, so the search ends once they reach the best path
+  while (ok && search->heaps[0].size && search->heaps[1].size) {
+    if (!heap_settle(&search->heaps[0]) || !heap_settle(&search->heaps[1])) {
+      ok = false;
+      break;
+    }
+    uint64_t front = search->heaps[0].last, back = search->heaps[1].last;
+    if (front + back >= best)
+      break;
+    int side = front <= back ? 0 : 1;
+    HeapItem item = heap_pop(&search->heaps[side]);
+    uint64_t *dist = search->dist[side];
+    uint64_t *other = search->dist[1 - side];
+    if (item.key != dist[item.node])
+      continue;
+    CSRKind kind = search->kinds[side];
+    const uint64_t *offsets = graph->offsets[kind];
+    const uint32_t *neighbors = graph->neighbors[kind];
+    const uint32_t *weights = graph->weights[kind];
+    for (uint64_t e = offsets[item.node]; e < offsets[item.node + 1]; e++) {
+      uint32_t v = neighbors[e];
+      uint64_t candidate = item.key + edge_weight(weights, e);
+      touch(search, v);
+      if (candidate >= dist[v])
+        continue;
+      dist[v] = candidate;
+      search->parent[side][v] = item.node;
+      if (other[v] != SSSP_INF && candidate + other[v] < best) {
+        best = candidate + other[v];
+        meet = v;
+      }
+      if (!heap_push(&search->heaps[side], candidate, v)) {
+        ok = false;
+        break;
+      }
+    }
+  }
+  if (!ok || best == SSSP_INF)
+    return SSSP_INF;
+  if (path)
+    write_path(search, meet, path, path_len);
+  return best;
+}
@@ -0,0 +1,153 @@
+#include "subtree.h"
+#include <math.h>
+#include <stdlib.h>
+
+double subtree_project_double(Node *node, void *ctx) {
+  (void)ctx;
+  return node->value ? *(double *)node->value : 0.0;
+}
+
+static void clear_index(SubtreeIndex *index) {
+  nodemap_destroy(index->ids);
+  free(index->nodes);
+  free(index->last);
+  free(index->tree);
+  index->ids = NULL;
+  index->nodes = NULL;
+  index->last = NULL;
+  index->tree = NULL;
+  index->size = 0;
+}
+
+static SubtreeAggregate combine(SubtreeAggregate a, SubtreeAggregate b) {
+  SubtreeAggregate out = {a.sum + b.sum, a.max > b.max ? a.max : b.max};
+  return out;
+}
+
+// Numbers the tree in preorder (see preorder_flatten)
+static bool flatten(SubtreeIndex *index) {
+  int count = num_nodes(index->root);
+  if (count <= 0)
+    return false;
+  size_t n = (size_t)count;
+  index->nodes = (Node **)malloc(n * sizeof(Node *));
+  index->last = (uint32_t *)malloc(n * sizeof(uint32_t));
+  index->ids = nodemap_create(n);
+  // Only the subtree ranges are kept, not the parents
+  uint32_t *parent = (uint32_t *)malloc(n * sizeof(uint32_t));
+  if (index->nodes && index->last && index->ids && parent)
+    index->size = preorder_flatten(index->root, n, index->nodes, parent,
+                                   index->last, index->ids);
+  free(parent);
+  return index->size > 0;
+}
+
+bool subtree_rebuild(SubtreeIndex *index) {
+  if (!index)
+    return false;
+  clear_index(index);
+  if (!flatten(index)) {
+    clear_index(index);
+    return false;
+  }
+  size_t n = index->size;
+  index->tree = (SubtreeAggregate *)malloc(2 * n * sizeof(SubtreeAggregate));
+  if (!index->tree) {
+    clear_index(index);
+    return false;
+  }
+  for (size_t i = 0; i < n; i++) {
+    double value = index->project(index->nodes[i], index->ctx);
+    index->tree[n + i].sum = value;
+    index->tree[n + i].max = value;
+  }
+  for (size_t i = n - 1; i > 0; i--) {
+    index->tree[i] = combine(index->tree[2 * i], index->tree[2 * i + 1]);
+  }
+  return true;
+}
+
+SubtreeIndex *subtree_create(Node *root, SubtreeProjection project,
+                             void *ctx) {
+  if (!root || !project)
+    return NULL;
+  SubtreeIndex *index = (SubtreeIndex *)calloc(1, sizeof(SubtreeIndex));
+  if (!index)
+    return NULL;
+  index->root = root;
+  index->project = project;
+  index->ctx = ctx;
+  if (!subtree_rebuild(index)) {
+    free(index);
+    return NULL;
+  }
+  return index;
+}
+
+void subtree_destroy(SubtreeIndex *index) {
+  if (!index)
+    return;
+  clear_index(index);
+  free(index);
+}
+
+static bool lookup(const SubtreeIndex *index, Node *node, size_t *id) {
+  return index && node && nodemap_get(index->ids, node, id);
+}
+
+bool subtree_set(SubtreeIndex *index, Node *node, double value) {
+  size_t id;
+  if (!lookup(index, node, &id))
+    return false;
+  size_t i = index->size + id;
+  index->tree[i].sum = value;
+  index->tree[i].max = value;
+  for (i /= 2; i > 0; i /= 2) {
+    index->tree[i] = combine(index->tree[2 * i], index->tree[2 * i + 1]);
+  }
+  return true;
+}
+
+bool subtree_refresh(SubtreeIndex *index, Node *node) {
+  if (!index || !node)
+    return false;
+  return subtree_set(index, node, index->project(node, index->ctx));
+}
+
+double subtree_value(const SubtreeIndex *index, Node *node) {
+  size_t id;
+  return lookup(index, node, &id) ? index->tree[index->size + id].sum : NAN;
+}
+
+bool subtree_aggregate(const SubtreeIndex *index, Node *node,
+                       SubtreeAggregate *out) {
+  size_t id;
+  if (!out || !lookup(index, node, &id))
+    return false;
+  // Bottom-up walk over the half-open leaf range [l, r)
+  SubtreeAggregate result = {0.0, -INFINITY};
+  size_t l = index->size + id, r = index->size + index->last[id] + 1;
+  for (; l < r; l /= 2, r /= 2) {
+    if (l & 1)
+      result = combine(result, index->tree[l++]);
+    if (r & 1)
+      result = combine(result, index->tree[--r]);
+  }
+  *out = result;
+  return true;
+}
+
+double subtree_sum(const SubtreeIndex *index, Node *node) {
+  SubtreeAggregate aggregate;
+  return subtree_aggregate(index, node, &aggregate) ? aggregate.sum : NAN;
+}
+
+double subtree_max(const SubtreeIndex *index, Node *node) {
+  SubtreeAggregate aggregate;
+  return subtree_aggregate(index, node, &aggregate) ? aggregate.max : NAN;
+}
+
+size_t subtree_count(const SubtreeIndex *index, Node *node) {
+  size_t id;
+  return lookup(index, node, &id) ? index->last[id] - id + 1 : 0;
+}
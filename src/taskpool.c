@@ -0,0 +1,283 @@
+#include "taskpool.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define TASKPOOL_CACHE_LINE 64
+// Per-worker deque slots; lazy splitting keeps deques short, and a spawn
+// into a full deque just runs inline
+#define TASKPOOL_DEQUE_CAPACITY 1024
+// A waiting worker runs stolen tasks on top of its own stack; past this many
+// nested waits it stops stealing and only drains its own deque, work this
+// stack would run anyway, which bounds stack use
+#define TASKPOOL_MAX_NESTED_WAITS 8
+
+typedef struct Deque {
+  _Alignas(TASKPOOL_CACHE_LINE) _Atomic int64_t top;
+  _Alignas(TASKPOOL_CACHE_LINE) _Atomic int64_t bottom;
+  _Alignas(TASKPOOL_CACHE_LINE) _Atomic(Task *) slots[TASKPOOL_DEQUE_CAPACITY];
+} Deque;
+
+typedef struct WorkerStart {
+  struct TaskPool *pool;
+  int self;
+} WorkerStart;
+
+struct TaskPool {
+  int nthreads;
+  Deque *deques;
+  pthread_t *threads;
+  WorkerStart *starts;
+  pthread_mutex_t mutex;
+  pthread_cond_t wake;
+  int active; // taskpool_run calls in progress, under mutex
+  bool shutdown;
+  atomic_int idle; // Workers currently looking for work
+};
+
+// Which pool and deque the current thread works on
+static _Thread_local TaskPool *current_pool = NULL;
+static _Thread_local int current_worker = -1;
+static _Thread_local int nested_waits = 0;
+
+// Chase-Lev deque operations, following Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models", with the fences folded into
+// seq_cst accesses. Every store to bottom is at least a release so a thief
+// that sees a slot index also sees the task written there.
+static bool deque_push(Deque *deque, Task *task) {
+  int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+  int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+  if (b - t >= TASKPOOL_DEQUE_CAPACITY)
+    return false;
+  atomic_store_explicit(&deque->slots[b % TASKPOOL_DEQUE_CAPACITY], task,
+                        memory_order_relaxed);
+  atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+  return true;
+}
+
+static Task *deque_pop(Deque *deque) {
+  int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&deque->bottom, b, memory_order_seq_cst);
+  int64_t t = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+  if (t > b) {
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+    return NULL;
+  }
+  Task *task = atomic_load_explicit(&deque->slots[b % TASKPOOL_DEQUE_CAPACITY],
+                                    memory_order_relaxed);
+  if (t == b) {
+    // Last task: race the thieves for it
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+      task = NULL;
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+  }
+  return task;
+}
+
+static Task *deque_steal(Deque *deque) {
+  int64_t t = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+  int64_t b = atomic_load_explicit(&deque->bottom, memory_order_seq_cst);
+  if (t >= b)
+    return NULL;
+  Task *task = atomic_load_explicit(&deque->slots[t % TASKPOOL_DEQUE_CAPACITY],
+                                    memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed))
+    return NULL;
+  return task;
+}
+
+static void execute(Task *task) {
+  task->run(task);
+  atomic_store_explicit(&task->done, true, memory_order_release);
+}
+
+// Tries every other deque once, starting at a rotating victim
+static Task *steal_any(TaskPool *pool, int self, unsigned *cursor) {
+  for (int i = 0; i < pool->nthreads; i++) {
+    int victim = (int)((*cursor)++ % (unsigned)pool->nthreads);
+    if (victim == self)
+      continue;
+    Task *task = deque_steal(&pool->deques[victim]);
+    if (task)
+      return task;
+  }
+  return NULL;
+}
+
+static void *worker_main(void *arg) {
+  TaskPool *pool = ((WorkerStart *)arg)->pool;
+  int self = ((WorkerStart *)arg)->self;
+  current_pool = pool;
+  current_worker = self;
+  unsigned cursor = (unsigned)self;
+
+  atomic_fetch_add(&pool->idle, 1);
+  while (1) {
+    Task *task = steal_any(pool, self, &cursor);
+    if (task) {
+      atomic_fetch_sub(&pool->idle, 1);
+      execute(task);
+      atomic_fetch_add(&pool->idle, 1);
+      continue;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->shutdown && pool->active == 0) {
+      pthread_cond_wait(&pool->wake, &pool->mutex);
+    }
+    bool shutdown = pool->shutdown;
+    pthread_mutex_unlock(&pool->mutex);
+    if (shutdown)
+      break;
+    sched_yield();
+  }
+  atomic_fetch_sub(&pool->idle, 1);
+  return NULL;
+}
+
+// Stops and joins workers 1 .. started - 1, then frees the pool
+static void release_pool(TaskPool *pool, int started) {
+  pthread_mutex_lock(&pool->mutex);
+  pool->shutdown = true;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+  for (int i = 1; i < started; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->wake);
+  free(pool->deques);
+  free(pool->threads);
+  free(pool->starts);
+  free(pool);
+}
+
+TaskPool *taskpool_create(int nthreads) {
+  if (nthreads <= 0)
+    nthreads = parallel_default_threads();
+  TaskPool *pool = (TaskPool *)malloc(sizeof(TaskPool));
+  if (!pool)
+    return NULL;
+  pool->nthreads = nthreads;
+  pool->deques = (Deque *)aligned_alloc(TASKPOOL_CACHE_LINE,
+                                        nthreads * sizeof(Deque));
+  pool->threads = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+  pool->starts = (WorkerStart *)malloc(nthreads * sizeof(WorkerStart));
+  if (!pool->deques || !pool->threads || !pool->starts) {
+    free(pool->deques);
+    free(pool->threads);
+    free(pool->starts);
+    free(pool);
+    return NULL;
+  }
+  for (int i = 0; i < nthreads; i++) {
+    atomic_init(&pool->deques[i].top, 0);
+    atomic_init(&pool->deques[i].bottom, 0);
+  }
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pool->active = 0;
+  pool->shutdown = false;
+  atomic_init(&pool->idle, 0);
+
+  // Worker 0 is whichever thread calls taskpool_run
+  for (int i = 1; i < nthreads; i++) {
+    pool->starts[i].pool = pool;
+    pool->starts[i].self = i;
+    if (pthread_create(&pool->threads[i], NULL, worker_main,
+                       &pool->starts[i]) != 0) {
+      release_pool(pool, i);
+      return NULL;
+    }
+  }
+  return pool;
+}
+
+void taskpool_destroy(TaskPool *pool) {
+  if (pool)
+    release_pool(pool, pool->nthreads);
+}
+
+int taskpool_threads(const TaskPool *pool) { return pool ? pool->nthreads : 0; }
+
+void taskpool_run(TaskPool *pool, Task *root) {
+  if (!root)
+    return;
+  atomic_init(&root->done, false);
+  if (!pool) {
+    execute(root);
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->active++;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->mutex);
+
+  TaskPool *saved_pool = current_pool;
+  int saved_worker = current_worker;
+  current_pool = pool;
+  current_worker = 0;
+  execute(root);
+  current_pool = saved_pool;
+  current_worker = saved_worker;
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->active--;
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+void taskpool_spawn(TaskPool *pool, Task *task) {
+  atomic_init(&task->done, false);
+  if (!pool || current_pool != pool ||
+      !deque_push(&pool->deques[current_worker], task))
+    execute(task);
+}
+
+bool taskpool_take_back(TaskPool *pool, Task *task) {
+  if (!pool || current_pool != pool)
+    return false;
+  Deque *own = &pool->deques[current_worker];
+  Task *bottom = deque_pop(own);
+  if (bottom == task)
+    return true;
+  if (bottom)
+    deque_push(own, bottom);
+  return false;
+}
+
+void taskpool_wait(TaskPool *pool, Task *task) {
+  if (!pool || current_pool != pool)
+    return;
+  Deque *own = &pool->deques[current_worker];
+  unsigned cursor = (unsigned)current_worker;
+  // Not stolen: just run it here
+  if (taskpool_take_back(pool, task)) {
+    execute(task);
+    return;
+  }
+  nested_waits++;
+  while (!atomic_load_explicit(&task->done, memory_order_acquire)) {
+    Task *next = deque_pop(own);
+    if (!next && nested_waits <= TASKPOOL_MAX_NESTED_WAITS)
+      next = steal_any(pool, current_worker, &cursor);
+    if (next)
+      execute(next);
+    else
+      sched_yield();
+  }
+  nested_waits--;
+}
+
+bool taskpool_hungry(TaskPool *pool) {
+  if (!pool || current_pool != pool ||
+      atomic_load_explicit(&pool->idle, memory_order_relaxed) == 0)
+    return false;
+  Deque *own = &pool->deques[current_worker];
+  return atomic_load_explicit(&own->bottom, memory_order_relaxed) <=
+         atomic_load_explicit(&own->top, memory_order_relaxed);
+}
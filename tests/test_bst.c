@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #define MAX_NODES 100
 
@@ -22,6 +23,17 @@ void collect_values(BSTNode **nodes, int *values, int count) {
   }
 }
 
+// Checks parent links and subtree sizes below node, returns the node count
+int check_links(BSTNode *node, BSTNode *parent) {
+  if (node == NULL)
+    return 0;
+  assert(node->parent == parent);
+  int size =
+      1 + check_links(node->left, node) + check_links(node->right, node);
+  assert(node->size == size);
+  return size;
+}
+
 void test_bst_traversals() {
   printf("Testing traversals (inorder, preorder, postorder)...\n");
   BST tree = {NULL, 0};
@@ -289,6 +301,253 @@ void test_single_node_tree() {
   printf("\n");
 }
 
+void test_treap_operations() {
+  printf("Testing treap operations...\n");
+  BST tree = {NULL, 0};
+
+  // ============ insert ============
+  for (int i = 0; i < 64; i++) {
+    bst_treap_insert(&tree, i);
+  }
+  bst_treap_insert(&tree, 10);
+  assert(tree.size == 64);
+  assert(tree.root->size == 64);
+
+  BSTNode *nodes[MAX_NODES];
+  int index = 0;
+  inorder(tree.root, nodes, &index);
+  assert(index == 64);
+  for (int i = 0; i < 64; i++) {
+    assert(nodes[i]->value == i);
+    if (nodes[i]->left)
+      assert(nodes[i]->left->priority < nodes[i]->priority);
+    if (nodes[i]->right)
+      assert(nodes[i]->right->priority < nodes[i]->priority);
+  }
+  printf("PASS: Sorted inserts keep BST order and heap order\n");
+
+  // ============ delete ============
+  bst_treap_delete(&tree, 0);
+  bst_treap_delete(&tree, 31);
+  bst_treap_delete(&tree, 100);
+  assert(search(&tree, 0) == NULL);
+  assert(search(&tree, 31) == NULL);
+  assert(tree.size == 62);
+  assert(tree.root->size == 62);
+  printf("PASS: Treap delete keeps subtree sizes\n");
+
+  free_tree(&tree);
+  printf("\n");
+}
+
+void test_splay_operations() {
+  printf("Testing splay operations...\n");
+  BST tree = {NULL, 0};
+
+  // ============ insert ============
+  for (int i = 0; i < 200; i++) {
+    bst_splay_insert(&tree, i);
+  }
+  bst_splay_insert(&tree, 42);
+  assert(tree.size == 200);
+  assert(tree.root->value == 42);
+  assert(tree.root->size == 200);
+  printf("PASS: Splay insert moves the value to the root\n");
+
+  // ============ search ============
+  BSTNode *found = bst_splay_search(&tree, 0);
+  assert(found != NULL && found == tree.root && found->value == 0);
+  assert(bst_splay_search(&tree, 500) == NULL);
+  assert(tree.root->value == 199);
+  assert(tree.root->size == 200);
+  printf("PASS: Splay search moves hits and misses to the root\n");
+
+  BSTNode *nodes[200];
+  int index = 0;
+  inorder(tree.root, nodes, &index);
+  assert(index == 200);
+  for (int i = 0; i < 200; i++) {
+    assert(nodes[i]->value == i);
+  }
+  printf("PASS: Splaying keeps BST order\n");
+
+  free_tree(&tree);
+  printf("\n");
+}
+
+void test_dump_load() {
+  printf("Testing dump and load...\n");
+  BST tree = {NULL, 0};
+  for (int i = 0; i < 1000; i++) {
+    bst_insert(&tree, (i * 7919) % 1000 - 500);
+  }
+  bst_insert(&tree, -2147483647 - 1);
+  bst_insert(&tree, 2147483647);
+
+  // ============ dump ============
+  FILE *file = tmpfile();
+  assert(file != NULL);
+  assert(bst_dump(&tree, file) == 0);
+  long bytes = ftell(file);
+  assert(bytes < 1024 + 16);
+  printf("PASS: Dumped %d values in %ld bytes\n", tree.size, bytes);
+
+  // ============ load ============
+  BST loaded = {NULL, 0};
+  bst_insert(&loaded, 12345);
+  rewind(file);
+  assert(bst_load(&loaded, file) == 0);
+  assert(loaded.size == 1002 && check_links(loaded.root, NULL) == 1002);
+  assert(search(&loaded, 12345) == NULL);
+
+  BSTNode *original[1002];
+  BSTNode *restored[1002];
+  int original_index = 0, restored_index = 0;
+  inorder(tree.root, original, &original_index);
+  inorder(loaded.root, restored, &restored_index);
+  assert(restored_index == 1002);
+  for (int i = 0; i < 1002; i++) {
+    assert(original[i]->value == restored[i]->value);
+  }
+  printf("PASS: Load restores every value in order\n");
+
+  int depth = 0;
+  for (BSTNode *node = loaded.root; node; node = node->left) {
+    depth++;
+  }
+  assert(depth == 10);
+  printf("PASS: Loaded tree is balanced\n");
+
+  // ============ errors ============
+  rewind(file);
+  fputc('X', file);
+  rewind(file);
+  assert(bst_load(&loaded, file) == -1);
+  assert(loaded.size == 1002);
+  fclose(file);
+
+  file = tmpfile();
+  assert(bst_dump(&tree, file) == 0);
+  fflush(file);
+  assert(ftruncate(fileno(file), bytes / 2) == 0);
+  rewind(file);
+  assert(bst_load(&loaded, file) == -1);
+  assert(loaded.size == 1002);
+  fclose(file);
+  printf("PASS: Corrupt and truncated streams are rejected\n");
+
+  free_tree(&tree);
+  free_tree(&loaded);
+  printf("\n");
+}
+
+void test_parent_links() {
+  printf("Testing parent links...\n");
+  BST tree = {NULL, 0};
+
+  // ============ insert/delete ============
+  for (int i = 0; i < 100; i++) {
+    bst_insert(&tree, (i * 37) % 100);
+  }
+  delete_node(&tree, 0);
+  delete_node(&tree, 37);
+  delete_node(&tree, tree.root->value);
+  assert(check_links(tree.root, NULL) == 97);
+  printf("PASS: Plain insert/delete maintain parent links\n");
+
+  // ============ treap/splay ============
+  bst_treap_insert(&tree, 200);
+  bst_treap_delete(&tree, 50);
+  bst_splay_insert(&tree, 150);
+  bst_splay_search(&tree, 10);
+  assert(check_links(tree.root, NULL) == 98);
+  printf("PASS: Rotations maintain parent links\n");
+
+  // ============ split/join ============
+  BST left, right;
+  bst_split(&tree, 60, &left, &right);
+  assert(check_links(left.root, NULL) == left.size);
+  assert(check_links(right.root, NULL) == right.size);
+  bst_join(&left, &right);
+  bst_delete_range(&left, 20, 30);
+  assert(check_links(left.root, NULL) == left.size);
+  printf("PASS: Split/join maintain parent links\n");
+
+  // ============ next/prev ============
+  int count = 0, last = -1;
+  for (BSTNode *node = bst_first(&left); node; node = bst_next(node)) {
+    assert(node->value > last);
+    last = node->value;
+    count++;
+  }
+  assert(count == left.size);
+  assert(last == bst_last(&left)->value);
+  count = 0;
+  for (BSTNode *node = bst_last(&left); node; node = bst_prev(node)) {
+    assert(node->value <= last);
+    last = node->value;
+    count++;
+  }
+  assert(count == left.size);
+  assert(last == bst_first(&left)->value);
+  printf("PASS: bst_next/bst_prev walk the tree in order\n");
+
+  BSTNode *node = search(&left, 19);
+  assert(bst_next(node)->value == 31);
+  assert(bst_prev(bst_next(node)) == node);
+  BST empty = {NULL, 0};
+  assert(bst_first(&empty) == NULL && bst_last(&empty) == NULL);
+  printf("PASS: Neighbors of a searched node\n");
+
+  free_tree(&left);
+  printf("\n");
+}
+
+void test_split_join() {
+  printf("Testing split and join...\n");
+  BST tree = {NULL, 0};
+  for (int i = 0; i < 50; i++) {
+    bst_insert(&tree, (i * 37) % 50);
+  }
+
+  // ============ split ============
+  BST left, right;
+  bst_split(&tree, 20, &left, &right);
+  assert(tree.root == NULL && tree.size == 0);
+  assert(left.size == 20 && right.size == 30);
+  assert(search(&left, 19) != NULL && search(&left, 20) == NULL);
+  assert(search(&right, 20) != NULL && search(&right, 19) == NULL);
+  printf("PASS: Split partitions around the pivot\n");
+
+  // ============ join ============
+  assert(bst_join(&right, &left) == -1);
+  assert(left.size == 20 && right.size == 30);
+  assert(bst_join(&left, &right) == 0);
+  assert(left.size == 50 && left.root->size == 50);
+  assert(right.root == NULL && right.size == 0);
+
+  BSTNode *nodes[MAX_NODES];
+  int index = 0;
+  inorder(left.root, nodes, &index);
+  assert(index == 50);
+  for (int i = 0; i < 50; i++) {
+    assert(nodes[i]->value == i);
+  }
+  printf("PASS: Join restores the original tree\n");
+
+  // ============ delete range ============
+  bst_delete_range(&left, 10, 39);
+  assert(left.size == 20);
+  assert(search(&left, 9) != NULL && search(&left, 40) != NULL);
+  assert(search(&left, 10) == NULL && search(&left, 39) == NULL);
+  bst_delete_range(&left, 40, 2147483647);
+  assert(left.size == 10 && left.root->size == 10);
+  printf("PASS: Range delete removes [low, high]\n");
+
+  free_tree(&left);
+  printf("\n");
+}
+
 int main() {
   printf("==================\n");
   printf("Running BST tests...\n\n");
@@ -299,6 +558,11 @@ int main() {
   test_search_edge_cases();
   test_empty_tree();
   test_single_node_tree();
+  test_treap_operations();
+  test_splay_operations();
+  test_dump_load();
+  test_parent_links();
+  test_split_join();
 
   printf("All BST tests passed!\n");
   printf("==================\n");
@@ -0,0 +1,173 @@
+#include "components.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Labels each node with the smallest index reachable ignoring direction
+void reference_components(const CSRGraph *graph, CSRKind kind,
+                          uint32_t *label) {
+  size_t n = graph->num_nodes;
+  uint32_t *stack = malloc(n * sizeof(uint32_t));
+  // Undirected neighbors: the kind's lists plus their reverse
+  CSRKind reverse = kind == CSR_OUTGOING ? CSR_INCOMING : kind;
+  for (size_t i = 0; i < n; i++)
+    label[i] = CSR_NONE;
+  for (uint32_t s = 0; s < n; s++) {
+    if (label[s] != CSR_NONE)
+      continue;
+    size_t top = 0;
+    stack[top++] = s;
+    label[s] = s;
+    while (top) {
+      uint32_t u = stack[--top];
+      CSRKind kinds[2] = {kind, reverse};
+      for (int k = 0; k < 2; k++) {
+        const uint32_t *nb = csr_neighbors(graph, kinds[k], u);
+        for (size_t j = 0; j < csr_degree(graph, kinds[k], u); j++) {
+          if (label[nb[j]] == CSR_NONE) {
+            label[nb[j]] = s;
+            stack[top++] = nb[j];
+          }
+        }
+      }
+    }
+  }
+  free(stack);
+}
+
+void test_components() {
+  printf("Testing parallel connected components...\n");
+  srand(51);
+  int count = 20000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  // Sparse enough to leave many components, plus one long path
+  for (int i = 0; i < count / 2; i++)
+    add_edge(nodes[rand() % count], nodes[rand() % count], true, false);
+  for (int i = 1; i < 2000; i++)
+    add_edge(nodes[count - i], nodes[count - i - 1], true, false);
+  CSRGraph *graph = csr_freeze(nodes, count);
+  uint32_t *label = malloc(count * sizeof(uint32_t));
+  uint32_t *expected = malloc(count * sizeof(uint32_t));
+  reference_components(graph, CSR_OUTGOING, expected);
+  size_t expected_count = 0;
+  for (int i = 0; i < count; i++)
+    expected_count += expected[i] == (uint32_t)i;
+  assert(expected_count > 1);
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    assert(par_components(graph, CSR_OUTGOING, threads, label) ==
+           expected_count);
+    for (int i = 0; i < count; i++)
+      assert(label[i] == expected[i]);
+    assert(par_components(graph, CSR_INCOMING, threads, label) ==
+           expected_count);
+  }
+  assert(par_components(graph, CSR_CHILDREN, 2, label) == (size_t)count);
+  assert(par_components(NULL, CSR_OUTGOING, 2, label) == 0);
+  csr_destroy(graph);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  free(label);
+  free(expected);
+  printf("Connected component tests passed!\n");
+}
+
+void check_order(const CSRGraph *graph, uint32_t *order, size_t ordered) {
+  size_t n = graph->num_nodes;
+  size_t *position = malloc(n * sizeof(size_t));
+  for (size_t i = 0; i < n; i++)
+    position[i] = (size_t)-1;
+  for (size_t i = 0; i < ordered; i++) {
+    assert(position[order[i]] == (size_t)-1);
+    position[order[i]] = i;
+  }
+  for (uint32_t u = 0; u < n; u++) {
+    if (position[u] == (size_t)-1)
+      continue;
+    const uint32_t *next = csr_neighbors(graph, CSR_OUTGOING, u);
+    for (size_t j = 0; j < csr_degree(graph, CSR_OUTGOING, u); j++)
+      if (position[next[j]] != (size_t)-1)
+        assert(position[u] < position[next[j]]);
+  }
+  free(position);
+}
+
+void test_toposort() {
+  printf("Testing parallel topological sort...\n");
+  srand(52);
+  int count = 20000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  // Edges only go from lower to higher ids, plus a chain fixing the depth
+  for (int i = 0; i < 4 * count; i++) {
+    int a = rand() % count, b = rand() % count;
+    if (a != b)
+      add_edge(nodes[a < b ? a : b], nodes[a < b ? b : a], true, false);
+  }
+  for (int i = 1; i < 300; i++)
+    add_edge(nodes[(i - 1) * 50], nodes[i * 50], true, false);
+  // Shuffle the view so index order is no topological order
+  for (int i = count - 1; i > 0; i--) {
+    int j = rand() % (i + 1);
+    Node *tmp = nodes[i];
+    nodes[i] = nodes[j];
+    nodes[j] = tmp;
+  }
+  CSRGraph *graph = csr_freeze(nodes, count);
+  uint32_t *order = malloc(count * sizeof(uint32_t));
+  uint32_t *cycle = malloc(count * sizeof(uint32_t));
+  TopoSortResult result, first;
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    assert(par_toposort(graph, threads, order, cycle, &result));
+    assert(result.ordered == (size_t)count && result.cycle_len == 0);
+    assert(result.levels >= 300);
+    check_order(graph, order, result.ordered);
+    if (threads == 1)
+      first = result;
+    assert(result.levels == first.levels);
+  }
+  csr_destroy(graph);
+
+  // Close a cycle 1000 -> 1050 -> 1100 -> 1000 through the chain
+  Node *a = NULL, *c = NULL;
+  for (int i = 0; i < count; i++) {
+    if (nodes[i]->node_id == 1000.0)
+      a = nodes[i];
+    if (nodes[i]->node_id == 1100.0)
+      c = nodes[i];
+  }
+  add_edge(c, a, true, false);
+  graph = csr_freeze(nodes, count);
+  for (int threads = 1; threads <= 4; threads *= 2) {
+    assert(par_toposort(graph, threads, order, cycle, &result));
+    assert(result.ordered < (size_t)count && result.ordered >= 1000);
+    check_order(graph, order, result.ordered);
+    assert(result.cycle_len >= 2);
+    for (size_t i = 0; i < result.cycle_len; i++) {
+      uint32_t u = cycle[i], v = cycle[(i + 1) % result.cycle_len];
+      Node *nu = graph->nodes[u], *nv = graph->nodes[v];
+      assert(nodeset_contains(nu->outgoing, nv));
+    }
+  }
+  assert(par_toposort(graph, 2, order, NULL, &result));
+  assert(result.cycle_len == 0 && result.ordered < (size_t)count);
+  assert(!par_toposort(NULL, 2, order, cycle, &result));
+  csr_destroy(graph);
+
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  free(order);
+  free(cycle);
+  printf("Topological sort tests passed!\n");
+}
+
+int main() {
+  test_components();
+  test_toposort();
+  printf("All components tests passed!\n");
+  return 0;
+}
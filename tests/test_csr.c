@@ -0,0 +1,230 @@
+#include "csr.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_NODES 100
+
+int visited_values[MAX_NODES];
+int visit_index = 0;
+int result_count = 0;
+
+Node *build_sample_tree(void) {
+  int *vals = malloc(8 * sizeof(int));
+  for (int i = 0; i < 8; i++) {
+    vals[i] = i + 1;
+  }
+
+  Node *root = create_node(&vals[0], 1.0);
+  Node *n2 = create_node(&vals[1], 2.0);
+  Node *n3 = create_node(&vals[2], 3.0);
+  Node *n4 = create_node(&vals[3], 4.0);
+  Node *n5 = create_node(&vals[4], 5.0);
+  Node *n6 = create_node(&vals[5], 6.0);
+  Node *n7 = create_node(&vals[6], 7.0);
+  Node *n8 = create_node(&vals[7], 8.0);
+
+  add_child(root, n2);
+  add_child(root, n3);
+  add_child(n2, n4);
+  add_child(n2, n5);
+  add_child(n3, n6);
+  add_child(n4, n7);
+  add_child(n5, n8);
+
+  return root;
+}
+
+void destroy_sample_tree(Node *node) {
+  int *vals = (int *)get_node_value(node);
+  Node *stack[8];
+  int top = 0;
+  stack[top++] = node;
+  while (top > 0) {
+    Node *current = stack[--top];
+    for (size_t i = 0; i < nodeset_size(current->children); i++)
+      stack[top++] = current->children->nodes[i];
+    destroy_node(current);
+  }
+  free(vals);
+}
+
+void record_result(uint32_t index, void *ctx) {
+  CSRGraph *graph = (CSRGraph *)ctx;
+  if (visit_index < MAX_NODES) {
+    visited_values[visit_index++] = *(int *)get_node_value(graph->nodes[index]);
+    result_count++;
+  }
+}
+
+void reset_visited() {
+  visit_index = 0;
+  result_count = 0;
+  for (int i = 0; i < MAX_NODES; i++)
+    visited_values[i] = -1;
+}
+
+int arrays_equal(int *a, int *b, int n) {
+  for (int i = 0; i < n; i++) {
+    if (a[i] != b[i])
+      return 0;
+  }
+  return 1;
+}
+
+void test_freeze() {
+  printf("Testing freeze...\n");
+  Node *root = build_sample_tree();
+  Node *n2 = root->children->nodes[0];
+  Node *n3 = root->children->nodes[1];
+  Node *n6 = n3->children->nodes[0];
+  int val = 9;
+  Node *extra = create_node(&val, 9.0);
+  add_edge(n2, n6, true, false);
+  add_edge(n6, extra, false, true);
+
+  // ============ csr_freeze_from ============
+  CSRGraph *graph = csr_freeze_from(n6);
+  assert(graph != NULL);
+  assert(graph->num_nodes == 9);
+  assert(graph->nodes[0] == n6);
+  assert(csr_index_of(graph, n6) == 0);
+
+  uint32_t i2 = csr_index_of(graph, n2);
+  uint32_t i6 = csr_index_of(graph, n6);
+  uint32_t i_root = csr_index_of(graph, root);
+  assert(graph->parent[i_root] == CSR_NONE);
+  assert(graph->parent[i2] == i_root);
+  assert(graph->node_ids[i2] == 2.0);
+  printf("PASS: Reachable nodes are indexed with parents\n");
+
+  assert(csr_degree(graph, CSR_OUTGOING, i2) == 1);
+  assert(csr_neighbors(graph, CSR_OUTGOING, i2)[0] == i6);
+  assert(csr_degree(graph, CSR_INCOMING, i6) == 1);
+  assert(csr_neighbors(graph, CSR_INCOMING, i6)[0] == i2);
+  assert(csr_degree(graph, CSR_EDGES, i6) == 1);
+  assert(csr_degree(graph, CSR_CHILDREN, i_root) == 2);
+  assert(csr_neighbors(graph, CSR_CHILDREN, i_root)[0] == i2);
+  printf("PASS: Adjacency matches the Node graph\n");
+  csr_destroy(graph);
+
+  // ============ csr_freeze ============
+  Node *subset[] = {n2, n6};
+  graph = csr_freeze(subset, 2);
+  assert(graph->num_nodes == 2);
+  assert(graph->parent[0] == CSR_NONE);
+  assert(csr_degree(graph, CSR_OUTGOING, 0) == 1);
+  assert(csr_degree(graph, CSR_CHILDREN, 0) == 0);
+  assert(csr_degree(graph, CSR_EDGES, 1) == 0);
+  assert(csr_index_of(graph, root) == CSR_NONE);
+  assert(graph->weights[CSR_OUTGOING] == NULL);
+  assert(csr_weights(graph, CSR_OUTGOING, 0) == NULL);
+  printf("PASS: Neighbors outside the frozen set are dropped\n");
+  csr_destroy(graph);
+
+  // ============ weights ============
+  add_weighted_edge(n2, extra, 7, true, true);
+  graph = csr_freeze(subset, 2);
+  assert(graph->weights[CSR_EDGES] && graph->weights[CSR_OUTGOING]);
+  assert(graph->weights[CSR_CHILDREN] == NULL);
+  assert(csr_weights(graph, CSR_OUTGOING, 0)[0] == EDGE_DEFAULT_WEIGHT);
+  csr_destroy(graph);
+  Node *with_extra[] = {n2, n6, extra};
+  graph = csr_freeze(with_extra, 3);
+  assert(csr_degree(graph, CSR_OUTGOING, 0) == 2);
+  assert(csr_neighbors(graph, CSR_OUTGOING, 0)[1] == 2);
+  assert(csr_weights(graph, CSR_OUTGOING, 0)[1] == 7);
+  assert(csr_weights(graph, CSR_INCOMING, 2)[0] == 7);
+  assert(csr_weights(graph, CSR_EDGES, 2)[1] == 7);
+  printf("PASS: Edge weights are frozen alongside neighbors\n");
+  csr_destroy(graph);
+  destroy_node(extra);
+  destroy_sample_tree(root);
+  printf("Freeze tests passed!\n");
+}
+
+void test_traversal() {
+  printf("Testing CSR traversals...\n");
+  Node *root = build_sample_tree();
+  CSRGraph *graph = csr_freeze_from(root);
+  uint32_t start = csr_index_of(graph, root);
+  assert(graph->children_forest);
+
+  // ============ dfs ============
+  reset_visited();
+  csr_dfs(graph, start, record_result, graph);
+  int dfs_expected[] = {1, 2, 4, 7, 5, 8, 3, 6};
+  assert(result_count == 8);
+  assert(arrays_equal(visited_values, dfs_expected, 8));
+  printf("DFS test passed!\n");
+
+  // ============ bfs ============
+  reset_visited();
+  csr_bfs(graph, start, record_result, graph);
+  int bfs_expected[] = {1, 2, 3, 4, 5, 6, 7, 8};
+  assert(result_count == 8);
+  assert(arrays_equal(visited_values, bfs_expected, 8));
+  printf("BFS test passed!\n");
+
+  // ============ height/num_nodes ============
+  assert(csr_height(graph, start) == height(root));
+  assert(csr_num_nodes(graph, start) == num_nodes(root));
+  uint32_t n3 = csr_index_of(graph, root->children->nodes[1]);
+  assert(csr_height(graph, n3) == 1);
+  assert(csr_num_nodes(graph, n3) == 2);
+  uint32_t n8 = csr_index_of(graph, root->children->nodes[0]
+                                        ->children->nodes[1]
+                                        ->children->nodes[0]);
+  assert(csr_height(graph, n8) == 0 && csr_num_nodes(graph, n8) == 1);
+  printf("Height and size tests passed!\n");
+
+  csr_destroy(graph);
+  destroy_sample_tree(root);
+  printf("All CSR traversal tests passed!\n");
+}
+
+void test_shared_children() {
+  printf("Testing CSR traversals over a diamond with a cycle...\n");
+  int vals[4] = {1, 2, 3, 4};
+  Node *nodes[4];
+  for (int i = 0; i < 4; i++)
+    nodes[i] = create_node(&vals[i], i);
+  // 4 is a child of both 2 and 3, and lists the root as its own child
+  add_child(nodes[0], nodes[1]);
+  add_child(nodes[0], nodes[2]);
+  add_child(nodes[1], nodes[3]);
+  add_child(nodes[2], nodes[3]);
+  add_child(nodes[3], nodes[0]);
+  CSRGraph *graph = csr_freeze(nodes, 4);
+  assert(!graph->children_forest);
+
+  reset_visited();
+  csr_dfs(graph, 0, record_result, graph);
+  int dfs_expected[] = {1, 2, 4, 3};
+  assert(result_count == 4 && arrays_equal(visited_values, dfs_expected, 4));
+  reset_visited();
+  csr_bfs(graph, 0, record_result, graph);
+  int bfs_expected[] = {1, 2, 3, 4};
+  assert(result_count == 4 && arrays_equal(visited_values, bfs_expected, 4));
+  assert(csr_num_nodes(graph, 0) == 4 && csr_height(graph, 0) == 2);
+  assert(csr_num_nodes(graph, 3) == 4 && csr_height(graph, 3) == 2);
+  printf("PASS: Every node is visited once\n");
+
+  csr_destroy(graph);
+  for (int i = 0; i < 4; i++)
+    destroy_node(nodes[i]);
+  printf("Shared children tests passed!\n");
+}
+
+int main() {
+  printf("==================\n");
+  printf("Running CSR tests...\n\n");
+
+  test_freeze();
+  test_traversal();
+  test_shared_children();
+
+  printf("==================\n");
+  printf("All CSR tests passed!\n");
+  return 0;
+}
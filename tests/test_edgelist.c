@@ -0,0 +1,279 @@
+#include "edgelist.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static uint64_t next_rand(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// True if set holds exactly the nodes with these ids, in this order
+static bool set_is(NodeSet *set, const double *ids, size_t count) {
+  if (set->size != count)
+    return false;
+  for (size_t i = 0; i < count; i++) {
+    if (set->nodes[i]->node_id != ids[i])
+      return false;
+  }
+  return true;
+}
+
+// Same ids, adjacency order and weights in every set of every node
+static void assert_same_graph(Graph *a, Graph *b) {
+  assert(graph_num_nodes(a) == graph_num_nodes(b));
+  for (size_t i = 0; i < a->num_nodes; i++) {
+    Node *x = a->nodes[i];
+    Node *y = b->nodes[i];
+    assert(x->node_id == y->node_id);
+    NodeSet *xs[3] = {x->edges, x->outgoing, x->incoming};
+    NodeSet *ys[3] = {y->edges, y->outgoing, y->incoming};
+    for (int k = 0; k < 3; k++) {
+      assert(xs[k]->size == ys[k]->size);
+      for (size_t j = 0; j < xs[k]->size; j++) {
+        assert(xs[k]->nodes[j]->node_id == ys[k]->nodes[j]->node_id);
+        assert(nodeset_weight(xs[k], j) == nodeset_weight(ys[k], j));
+        assert(nodeset_contains(xs[k], xs[k]->nodes[j]));
+      }
+    }
+  }
+}
+
+void test_format() {
+  printf("Testing edge list format...\n");
+  const char *text = "# comment\n"
+                     "% also a comment\n"
+                     "\n"
+                     "  7 3\n"
+                     "3,5\r\n"
+                     "\t5\t7   \n"
+                     "   \r\n"
+                     "3 7\n"
+                     "7 3\n"
+                     "12345678901 3";
+  EdgeListOptions options = {false, false, 2};
+  EdgeListStats stats;
+  Graph *graph = edgelist_parse(text, strlen(text), &options, &stats);
+  assert(graph && stats.edges == 6 && stats.duplicates == 1);
+  assert(stats.bad_line == 0);
+  // Nodes come in ascending id order
+  assert(graph_num_nodes(graph) == 4);
+  double order[] = {3, 5, 7, 12345678901.0};
+  for (int i = 0; i < 4; i++) {
+    assert(graph->nodes[i]->node_id == order[i]);
+    assert(graph_find(graph, order[i]) == graph->nodes[i]);
+  }
+  double three[] = {5, 7};
+  double seven[] = {3};
+  double big[] = {3};
+  assert(set_is(graph_find(graph, 3)->edges, three, 2));
+  assert(set_is(graph_find(graph, 7)->edges, seven, 1));
+  assert(set_is(graph_find(graph, 12345678901.0)->edges, big, 1));
+  assert(graph_find(graph, 3)->outgoing->size == 0);
+  assert(graph_find(graph, 3)->edges->weights == NULL);
+  graph_destroy(graph);
+  printf("Comments, blank lines, separators and CRLF are handled\n");
+
+  const char *weighted = "1 2 10\n2 3\n1 2 4\n";
+  options.directed = true;
+  graph = edgelist_parse(weighted, strlen(weighted), &options, &stats);
+  assert(graph && stats.edges == 3 && stats.duplicates == 3);
+  uint32_t weight;
+  Node *one = graph_find(graph, 1);
+  Node *two = graph_find(graph, 2);
+  Node *three_node = graph_find(graph, 3);
+  assert(get_edge_weight(one, two, &weight) && weight == 4);
+  assert(get_edge_weight(two, three_node, &weight) &&
+         weight == EDGE_DEFAULT_WEIGHT);
+  assert(nodeset_get_weight(two->incoming, one, &weight) && weight == 4);
+  assert(one->outgoing->size == 1 && three_node->incoming->size == 1);
+  graph_destroy(graph);
+  printf("Repeated lines keep the last weight\n");
+
+  graph = edgelist_parse("", 0, NULL, &stats);
+  assert(graph && graph_num_nodes(graph) == 0 && stats.edges == 0);
+  graph_destroy(graph);
+  printf("Empty input gives an empty graph\n");
+}
+
+void test_errors() {
+  printf("Testing malformed edge lists...\n");
+  const char *bad[] = {
+      "1 2\n3\n",                       // One field
+      "1 2\n\n1 2 3 4\n",               // Four fields
+      "1 2\n1 x\n",                     // Not a number
+      "1 2\n1 2x\n",                    // No separator
+      "1 2\n-1 2\n",                    // Negative id
+      "1 2\n9007199254740993 1\n",      // Above 2^53
+      "1 2\n12345678901234567 1\n",     // 17 digits
+      "1 2\n1 2 4294967296\n",          // Weight above 32 bits
+      "1 2\n1 2 12345678901\n",         // Weight with 11 digits
+      "1 2\n1 2\r3 4\n",                // Lone carriage return
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+    EdgeListStats stats;
+    assert(edgelist_parse(bad[i], strlen(bad[i]), NULL, &stats) == NULL);
+    assert(stats.bad_line == (i == 1 ? 3 : 2));
+  }
+  assert(edgelist_parse(NULL, 4, NULL, NULL) == NULL);
+  assert(edgelist_load("/nonexistent/edges.txt", NULL, NULL) == NULL);
+
+  EdgeListStats stats;
+  const char *ok = "9007199254740992 0 4294967295\n";
+  Graph *graph = edgelist_parse(ok, strlen(ok), NULL, &stats);
+  assert(graph && graph_num_nodes(graph) == 2);
+  uint32_t weight;
+  assert(get_edge_weight(graph_find(graph, 9007199254740992.0),
+                         graph_find(graph, 0), &weight) &&
+         weight == UINT32_MAX);
+  graph_destroy(graph);
+  printf("Bad lines are reported by number\n");
+}
+
+// Writes count random lines and returns the text; ids are dense below
+// id_range, or spread over large values when sparse
+static char *random_edges(size_t count, uint64_t id_range, bool sparse,
+                          bool weighted, uint64_t *seed, size_t *size) {
+  char *text = (char *)malloc(count * 64 + 1);
+  size_t len = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t a = next_rand(seed) % id_range;
+    uint64_t b = next_rand(seed) % id_range;
+    if (sparse) {
+      a = a * 1000003 + 1000000000000ULL;
+      b = b * 1000003 + 1000000000000ULL;
+    }
+    if (weighted && i % 3)
+      len += (size_t)sprintf(text + len, "%llu\t%llu %u\n",
+                             (unsigned long long)a, (unsigned long long)b,
+                             (unsigned)(next_rand(seed) % 1000));
+    else
+      len += (size_t)sprintf(text + len, "%llu %llu\n", (unsigned long long)a,
+                             (unsigned long long)b);
+  }
+  *size = len;
+  return text;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// The same graph built line by line with add_weighted_edge; nodes are
+// created in ascending id order first
+static Graph *reference_graph(const char *text, bool directed,
+                              bool bidirectional) {
+  size_t lines = 0;
+  for (const char *p = text; *p; p++)
+    lines += *p == '\n';
+  double *ids = (double *)malloc(2 * lines * sizeof(double));
+  size_t count = 0;
+  const char *p = text;
+  while (*p) {
+    char *end;
+    ids[count++] = (double)strtoull(p, &end, 10);
+    ids[count++] = (double)strtoull(end, &end, 10);
+    p = strchr(end, '\n') + 1;
+  }
+  qsort(ids, count, sizeof(double), compare_doubles);
+  Graph *graph = graph_create(0);
+  for (size_t i = 0; i < count; i++)
+    graph_ensure_node(graph, ids[i]);
+  free(ids);
+
+  bool any_weight = false;
+  for (p = text; *p; p++)
+    any_weight |= *p == '\t';
+  p = text;
+  while (*p) {
+    char *end;
+    double a = (double)strtoull(p, &end, 10);
+    double b = (double)strtoull(end, &end, 10);
+    uint32_t weight = EDGE_DEFAULT_WEIGHT;
+    if (*end == ' ')
+      weight = (uint32_t)strtoul(end, &end, 10);
+    Node *x = graph_find(graph, a);
+    Node *y = graph_find(graph, b);
+    if (any_weight)
+      add_weighted_edge(x, y, weight, directed, bidirectional);
+    else
+      add_edge(x, y, directed, bidirectional);
+    p = strchr(end, '\n') + 1;
+  }
+  return graph;
+}
+
+void test_matches_add_edge() {
+  printf("Testing bulk build against add_edge...\n");
+  uint64_t seed = 0x9e3779b97f4a7c15ULL;
+  for (int round = 0; round < 8; round++) {
+    bool sparse = round & 1;
+    bool weighted = round & 2;
+    // Few ids give repeats and sets big enough for the index
+    uint64_t id_range = round & 4 ? 40 : 3000;
+    size_t size;
+    char *text = random_edges(4000, id_range, sparse, weighted, &seed, &size);
+    for (int flags = 0; flags < 4; flags++) {
+      bool directed = flags & 1;
+      bool bidirectional = flags & 2;
+      Graph *expected = reference_graph(text, directed, bidirectional);
+      for (int nthreads = 1; nthreads <= 3; nthreads += 2) {
+        EdgeListOptions options = {directed, bidirectional, nthreads};
+        EdgeListStats stats;
+        Graph *graph = edgelist_parse(text, size, &options, &stats);
+        assert(graph && stats.edges == 4000);
+        assert_same_graph(graph, expected);
+        graph_destroy(graph);
+      }
+      graph_destroy(expected);
+    }
+    free(text);
+  }
+  printf("Every flag combination matches line-by-line insertion\n");
+}
+
+void test_load_file() {
+  printf("Testing edge list files...\n");
+  char path[] = "/tmp/test_edgelistXXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  uint64_t seed = 42;
+  size_t size;
+  char *text = random_edges(2000, 500, false, false, &seed, &size);
+  assert(write(fd, text, size) == (ssize_t)size);
+  close(fd);
+
+  EdgeListOptions options = {true, false, 2};
+  EdgeListStats stats;
+  Graph *graph = edgelist_load(path, &options, &stats);
+  Graph *expected = edgelist_parse(text, size, &options, NULL);
+  assert(graph && expected && stats.edges == 2000);
+  assert_same_graph(graph, expected);
+  graph_destroy(graph);
+  graph_destroy(expected);
+
+  fd = open(path, O_WRONLY | O_TRUNC);
+  close(fd);
+  graph = edgelist_load(path, &options, &stats);
+  assert(graph && graph_num_nodes(graph) == 0);
+  graph_destroy(graph);
+  unlink(path);
+  free(text);
+  printf("Mapped files load like in-memory text\n");
+}
+
+int main() {
+  test_format();
+  test_errors();
+  test_matches_add_edge();
+  test_load_file();
+  printf("All edgelist tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,174 @@
+#include "graph.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void test_index() {
+  printf("Testing graph id index...\n");
+  Graph *graph = graph_create(0);
+  assert(graph && graph_num_nodes(graph) == 0);
+  int count = 20000;
+  // Ids that stress the hash: consecutive integers, tiny fractions, and
+  // large magnitudes that share low mantissa bits
+  for (int i = 0; i < count; i++) {
+    double id = i % 3 == 0 ? (double)i : i % 3 == 1 ? i / 1024.0 : i * 1e12;
+    Node *node = graph_add_node(graph, NULL, id);
+    assert(node && node->node_id == id);
+    assert(graph_add_node(graph, NULL, id) == NULL);
+  }
+  assert(graph_num_nodes(graph) == (size_t)count);
+  for (int i = 0; i < count; i++) {
+    double id = i % 3 == 0 ? (double)i : i % 3 == 1 ? i / 1024.0 : i * 1e12;
+    Node *node = graph_find(graph, id);
+    assert(node && node->node_id == id && graph->nodes[i] == node);
+  }
+  assert(graph_find(graph, 0.5 / 1024.0) == NULL);
+  assert(graph_find(graph, -1.0) == NULL);
+  printf("Ids are found after the index grows\n");
+
+  // Signed zeros are one id; NaN is never an id
+  Node *zero = graph_find(graph, 0.0);
+  assert(zero && graph_find(graph, -0.0) == zero);
+  assert(graph_add_node(graph, NULL, -0.0) == NULL);
+  assert(graph_add_node(graph, NULL, NAN) == NULL);
+  assert(graph_find(graph, NAN) == NULL);
+  assert(graph_add_node(graph, NULL, INFINITY) != NULL);
+  assert(graph_find(graph, INFINITY) != NULL);
+  assert(graph_find(graph, -INFINITY) == NULL);
+  assert(graph_ensure_node(graph, INFINITY) == graph_find(graph, INFINITY));
+  Node *fresh = graph_ensure_node(graph, -7.25);
+  assert(fresh && fresh->value == NULL && graph_find(graph, -7.25) == fresh);
+  assert(graph_ensure_node(graph, NAN) == NULL);
+  printf("Double keys compare like doubles\n");
+
+  // ============ batch ============
+  double ids[21];
+  Node *out[21];
+  for (int i = 0; i < 20; i++)
+    ids[i] = i % 2 ? (double)(3 * i) : -0.5 - i;
+  ids[20] = NAN;
+  assert(graph_find_batch(graph, ids, 21, out) == 10);
+  for (int i = 0; i < 21; i++)
+    assert(out[i] == graph_find(graph, ids[i]) && (out[i] != NULL) == i % 2);
+  assert(graph_find_batch(graph, ids, 0, out) == 0);
+  printf("Batched lookups match single lookups\n");
+
+  graph_destroy(graph);
+  printf("Graph index tests passed!\n");
+}
+
+void test_edges() {
+  printf("Testing edges by id...\n");
+  Graph *graph = graph_create(4);
+  int values[3] = {10, 20, 30};
+  for (int i = 0; i < 3; i++)
+    assert(graph_add_node(graph, &values[i], 100.0 + i));
+  assert(graph_add_edge_by_id(graph, 100.0, 101.0, true, false));
+  assert(graph_add_edge_by_id(graph, 101.0, 102.0, false, true));
+  assert(!graph_add_edge_by_id(graph, 100.0, 99.0, true, false));
+  assert(!graph_add_edge_by_id(graph, NAN, 100.0, true, false));
+  Node *a = graph_find(graph, 100.0), *b = graph_find(graph, 101.0);
+  Node *c = graph_find(graph, 102.0);
+  assert(*(int *)get_node_value(c) == 30);
+  assert(nodeset_contains(a->outgoing, b) && nodeset_contains(b->incoming, a));
+  assert(nodeset_contains(b->edges, c) && nodeset_contains(c->edges, b));
+  assert(!nodeset_contains(b->edges, a));
+  assert(nodeset_size(a->edges) == 1);
+  graph_destroy(graph);
+  graph_destroy(NULL);
+  printf("Edge by id tests passed!\n");
+}
+
+void test_remove() {
+  printf("Testing node removal...\n");
+  Graph *graph = graph_create(0);
+  int count = 1000;
+  for (int i = 0; i < count; i++)
+    assert(graph_add_node(graph, NULL, (double)i));
+  for (int i = 1; i < count; i++)
+    assert(graph_add_edge_by_id(graph, 0.0, (double)i, true, true));
+  Node *hub = graph_find(graph, 0.0);
+  Node *last = graph_find(graph, count - 1.0);
+  assert(graph_remove_node(graph, 10.0));
+  assert(!graph_remove_node(graph, 10.0) && !graph_remove_node(graph, NAN));
+  assert(graph_find(graph, 10.0) == NULL);
+  assert(graph_num_nodes(graph) == (size_t)count - 1);
+  assert(graph->nodes[10] == last);
+  assert(nodeset_size(hub->edges) == (size_t)count - 2);
+  assert(nodeset_size(hub->outgoing) == (size_t)count - 2);
+  printf("The last node takes the removed one's place\n");
+
+  // Remove every odd id, then the hub; the rest stay findable
+  for (int i = 1; i < count; i += 2)
+    assert(graph_remove_node(graph, (double)i));
+  for (int i = 0; i < count; i++)
+    assert((graph_find(graph, (double)i) != NULL) == (i % 2 == 0 && i != 10));
+  assert(nodeset_size(hub->edges) == (size_t)count / 2 - 2);
+  assert(graph_remove_node(graph, 0.0));
+  for (size_t i = 0; i < graph_num_nodes(graph); i++) {
+    Node *node = graph->nodes[i];
+    assert(graph_find(graph, node->node_id) == node);
+    assert(nodeset_is_empty(node->edges) && nodeset_is_empty(node->incoming));
+  }
+  printf("Lookups and positions survive removals\n");
+
+  // Freed slots are reused and the ids can come back
+  size_t live = arena_num_nodes(graph->arena);
+  assert(graph_add_node(graph, NULL, 10.0) && graph_add_node(graph, NULL, 0.0));
+  assert(arena_num_nodes(graph->arena) == live + 2);
+  assert(graph->nodes[graph_num_nodes(graph) - 1] == graph_find(graph, 0.0));
+  graph_destroy(graph);
+
+  // A one-way edge is only in the source's set, yet must not outlive its
+  // target: the freed slot goes to the next node added
+  graph = graph_create(0);
+  Node *u = graph_add_node(graph, NULL, 1.0);
+  assert(graph_add_node(graph, NULL, 2.0));
+  assert(graph_add_edge_by_id(graph, 1.0, 2.0, false, false));
+  assert(graph_remove_node(graph, 2.0));
+  Node *reused = graph_add_node(graph, NULL, 99.0);
+  assert(nodeset_is_empty(u->edges) && !nodeset_contains(u->edges, reused));
+  graph_destroy(graph);
+  printf("One-way entries are removed with their target\n");
+
+  // In a larger graph tombstones wait for the sweep; until then the
+  // one-way entry still points at the removed node, never at a new one
+  graph = graph_create(0);
+  for (int i = 0; i < count; i++)
+    assert(graph_add_node(graph, NULL, (double)i));
+  for (int i = 1; i < count; i++)
+    assert(graph_add_edge_by_id(graph, 0.0, (double)i, false, false));
+  hub = graph_find(graph, 0.0);
+  Node *gone = graph_find(graph, 5.0);
+  assert(graph_remove_node(graph, 5.0));
+  assert(nodeset_contains(hub->edges, gone) && nodeset_is_empty(gone->edges));
+  reused = graph_add_node(graph, NULL, 5.0);
+  assert(reused != gone && !nodeset_contains(hub->edges, reused));
+  graph_compact(graph);
+  assert(nodeset_size(hub->edges) == (size_t)count - 2);
+  graph_compact(graph);
+  // Removing most nodes sweeps along the way and after a final compaction
+  // the hub keeps exactly the survivors
+  for (int i = 1; i < count; i++) {
+    if (i % 10 != 0)
+      assert(graph_remove_node(graph, (double)i));
+  }
+  graph_compact(graph);
+  assert(nodeset_size(hub->edges) == graph_num_nodes(graph) - 1);
+  for (size_t i = 0; i < graph_num_nodes(graph); i++) {
+    Node *node = graph->nodes[i];
+    assert(node == hub || nodeset_contains(hub->edges, node));
+  }
+  assert(arena_num_nodes(graph->arena) == graph_num_nodes(graph));
+  graph_destroy(graph);
+  printf("Node removal tests passed!\n");
+}
+
+int main() {
+  test_index();
+  test_edges();
+  test_remove();
+  printf("All graph tests passed!\n");
+  return 0;
+}
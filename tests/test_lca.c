@@ -0,0 +1,167 @@
+#include "lca.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int naive_depth(Node *node) {
+  int depth = 0;
+  for (; node->parent; node = node->parent)
+    depth++;
+  return depth;
+}
+
+Node *naive_lca(Node *u, Node *v) {
+  int du = naive_depth(u), dv = naive_depth(v);
+  for (; du > dv; du--)
+    u = u->parent;
+  for (; dv > du; dv--)
+    v = v->parent;
+  while (u != v) {
+    u = u->parent;
+    v = v->parent;
+  }
+  return u;
+}
+
+void check_pairs(LCAIndex *index, Node **nodes, int count, int pairs) {
+  for (int i = 0; i < pairs; i++) {
+    Node *u = nodes[rand() % count], *v = nodes[rand() % count];
+    Node *expected = naive_lca(u, v);
+    assert(lca(index, u, v) == expected);
+    assert(lca_depth(index, u) == naive_depth(u));
+    assert(lca_distance(index, u, v) ==
+           naive_depth(u) + naive_depth(v) - 2 * naive_depth(expected));
+    assert(lca_is_ancestor(index, u, v) == (expected == u));
+    assert(lca_is_ancestor(index, expected, v));
+  }
+}
+
+void test_static() {
+  printf("Testing LCA on a static tree...\n");
+  int count = 5000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  srand(11);
+  for (int i = 0; i < count; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    if (i > 0)
+      add_child(nodes[rand() % i], nodes[i]);
+  }
+  LCAIndex *index = lca_create(nodes[0]);
+  assert(index && index->num_built == (size_t)count);
+  check_pairs(index, nodes, count, 20000);
+  assert(lca(index, nodes[7], nodes[7]) == nodes[7]);
+  assert(lca_distance(index, nodes[7], nodes[7]) == 0);
+
+  Node *stranger = create_node(NULL, -1.0);
+  assert(lca(index, stranger, nodes[1]) == NULL);
+  assert(lca_depth(index, stranger) == -1);
+  assert(lca_distance(index, nodes[1], stranger) == -1);
+  assert(!lca_is_ancestor(index, nodes[0], stranger));
+  assert(!lca_attach(index, stranger));
+  assert(lca_create(NULL) == NULL);
+  destroy_node(stranger);
+
+  lca_destroy(index);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  printf("Static LCA tests passed!\n");
+}
+
+void test_attach() {
+  printf("Testing LCA with incremental attach...\n");
+  int initial = 2000, count = 6000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  srand(12);
+  for (int i = 0; i < initial; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    if (i > 0)
+      add_child(nodes[rand() % i], nodes[i]);
+  }
+  LCAIndex *index = lca_create(nodes[0]);
+  bool rebuilt = false;
+  int i = initial;
+  while (i < count) {
+    if (rand() % 4 == 0 && i + 20 <= count) {
+      // A whole subtree built off to the side, then hung in one attach
+      for (int j = i; j < i + 20; j++) {
+        nodes[j] = create_node(NULL, (double)j);
+        if (j > i)
+          add_child(nodes[i + rand() % (j - i)], nodes[j]);
+      }
+      add_child(nodes[rand() % i], nodes[i]);
+      assert(lca_attach(index, nodes[i]));
+      i += 20;
+    } else {
+      nodes[i] = create_node(NULL, (double)i);
+      add_child(nodes[rand() % i], nodes[i]);
+      assert(lca_attach(index, nodes[i]));
+      i++;
+    }
+    if (index->num_overlay == 0)
+      rebuilt = true;
+    if (i % 500 < 20)
+      check_pairs(index, nodes, i, 500);
+  }
+  assert(rebuilt);
+  assert(index->num_built + index->num_overlay == (size_t)count);
+  check_pairs(index, nodes, count, 20000);
+
+  assert(lca_rebuild(index));
+  assert(index->num_built == (size_t)count && index->num_overlay == 0);
+  check_pairs(index, nodes, count, 5000);
+
+  lca_destroy(index);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  printf("Incremental LCA tests passed!\n");
+}
+
+void test_deep() {
+  printf("Testing LCA on a deep chain...\n");
+  int count = 200000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    if (i > 0)
+      add_child(nodes[i - 1], nodes[i]);
+  }
+  LCAIndex *index = lca_create(nodes[0]);
+  assert(index);
+  assert(lca_depth(index, nodes[count - 1]) == count - 1);
+  assert(lca(index, nodes[count - 1], nodes[1000]) == nodes[1000]);
+  assert(lca_is_ancestor(index, nodes[0], nodes[count - 1]));
+  assert(!lca_is_ancestor(index, nodes[count - 1], nodes[0]));
+
+  // A second branch off the middle, attached leaf by leaf
+  Node *prev = nodes[count / 2];
+  Node *branch[100];
+  for (int i = 0; i < 100; i++) {
+    branch[i] = create_node(NULL, -(double)i);
+    add_child(prev, branch[i]);
+    assert(lca_attach(index, branch[i]));
+    prev = branch[i];
+  }
+  assert(index->num_overlay == 100);
+  assert(lca(index, branch[99], nodes[count - 1]) == nodes[count / 2]);
+  assert(lca(index, branch[99], branch[40]) == branch[40]);
+  assert(lca_distance(index, branch[99], nodes[count / 2 + 1]) == 101);
+  assert(lca_depth(index, branch[99]) == count / 2 + 100);
+
+  lca_destroy(index);
+  for (int i = 0; i < 100; i++)
+    destroy_node(branch[i]);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  printf("Deep chain LCA tests passed!\n");
+}
+
+int main() {
+  test_static();
+  test_attach();
+  test_deep();
+  printf("All lca tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include "mpmc.h"
+#include "parallel.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PRODUCERS 2
+#define CONSUMERS 2
+#define PER_PRODUCER 20000
+
+Node *stress_nodes[PRODUCERS * PER_PRODUCER];
+int stress_values[PRODUCERS * PER_PRODUCER];
+atomic_int seen[PRODUCERS * PER_PRODUCER];
+atomic_int consumed;
+
+void test_single_thread() {
+  printf("Testing MPMC queue basics...\n");
+  MPMCQueue *queue = mpmc_create(5);
+  assert(mpmc_capacity(queue) == 8);
+  assert(mpmc_dequeue(queue) == NULL);
+  assert(!mpmc_enqueue(queue, NULL));
+
+  int vals[20];
+  Node *nodes[20];
+  for (int i = 0; i < 20; i++) {
+    vals[i] = i;
+    nodes[i] = create_node(&vals[i], (double)i);
+  }
+
+  // Fill, then the next enqueue fails
+  for (int i = 0; i < 8; i++)
+    assert(mpmc_enqueue(queue, nodes[i]));
+  assert(!mpmc_enqueue(queue, nodes[8]));
+  assert(mpmc_size(queue) == 8);
+  for (int i = 0; i < 8; i++)
+    assert(mpmc_dequeue(queue) == nodes[i]);
+  assert(mpmc_dequeue(queue) == NULL);
+
+  // Batches wrap around the ring and stop at the free space
+  Node *out[20];
+  assert(mpmc_enqueue_batch(queue, nodes, 5) == 5);
+  assert(mpmc_dequeue_batch(queue, out, 3) == 3);
+  assert(mpmc_enqueue_batch(queue, nodes + 5, 10) == 6);
+  assert(mpmc_dequeue_batch(queue, out + 3, 20) == 8);
+  for (int i = 0; i < 11; i++)
+    assert(out[i] == nodes[i]);
+  assert(mpmc_size(queue) == 0);
+
+  mpmc_destroy(queue);
+  for (int i = 0; i < 20; i++)
+    destroy_node(nodes[i]);
+  printf("MPMC queue basics passed!\n");
+}
+
+void stress_worker(int thread, void *ctx) {
+  MPMCQueue *queue = (MPMCQueue *)ctx;
+  if (thread < PRODUCERS) {
+    Node **mine = stress_nodes + thread * PER_PRODUCER;
+    size_t sent = 0;
+    while (sent < PER_PRODUCER) {
+      size_t batch = (sent % 3) + 1; // Mix single and batched enqueues
+      if (batch > PER_PRODUCER - sent)
+        batch = PER_PRODUCER - sent;
+      sent += mpmc_enqueue_batch(queue, mine + sent, batch);
+    }
+    return;
+  }
+  int last[PRODUCERS];
+  for (int i = 0; i < PRODUCERS; i++)
+    last[i] = -1;
+  Node *batch[4];
+  while (atomic_load(&consumed) < PRODUCERS * PER_PRODUCER) {
+    size_t count = mpmc_dequeue_batch(queue, batch, 4);
+    for (size_t i = 0; i < count; i++) {
+      int value = *(int *)get_node_value(batch[i]);
+      atomic_fetch_add(&seen[value], 1);
+      // Each producer's nodes arrive in the order it sent them
+      int producer = value / PER_PRODUCER;
+      assert(value > last[producer]);
+      last[producer] = value;
+    }
+    atomic_fetch_add(&consumed, (int)count);
+  }
+}
+
+void test_concurrent() {
+  printf("Testing MPMC queue under contention...\n");
+  for (int i = 0; i < PRODUCERS * PER_PRODUCER; i++) {
+    stress_values[i] = i;
+    stress_nodes[i] = create_node(&stress_values[i], (double)i);
+    atomic_init(&seen[i], 0);
+  }
+  atomic_init(&consumed, 0);
+  MPMCQueue *queue = mpmc_create(64);
+  assert(parallel_run(PRODUCERS + CONSUMERS, stress_worker, queue) == 0);
+  for (int i = 0; i < PRODUCERS * PER_PRODUCER; i++)
+    assert(atomic_load(&seen[i]) == 1);
+  assert(mpmc_size(queue) == 0);
+  mpmc_destroy(queue);
+  for (int i = 0; i < PRODUCERS * PER_PRODUCER; i++)
+    destroy_node(stress_nodes[i]);
+  printf("MPMC contention tests passed!\n");
+}
+
+atomic_int visit_counts[12000];
+
+void count_visit(Node *node, void *ctx) {
+  (void)ctx;
+  atomic_fetch_add(&visit_counts[*(int *)get_node_value(node)], 1);
+}
+
+void test_traverse() {
+  printf("Testing mpmc_traverse...\n");
+  // A wide root overflows the shared queue; the rest is a deep chain and
+  // some bushy subtrees
+  int *vals = malloc(12000 * sizeof(int));
+  Node **nodes = malloc(12000 * sizeof(Node *));
+  for (int i = 0; i < 12000; i++) {
+    vals[i] = i;
+    nodes[i] = create_node(&vals[i], (double)i);
+  }
+  for (int i = 1; i <= 6000; i++)
+    add_child(nodes[0], nodes[i]);
+  for (int i = 6001; i < 9000; i++)
+    add_child(nodes[i - 1], nodes[i]);
+  for (int i = 9000; i < 12000; i++)
+    add_child(nodes[(i - 9000) / 3 + 1], nodes[i]);
+
+  for (int threads = 1; threads <= 4; threads++) {
+    for (int i = 0; i < 12000; i++)
+      atomic_init(&visit_counts[i], 0);
+    assert(mpmc_traverse(nodes[0], threads, count_visit, NULL) == 12000);
+    for (int i = 0; i < 12000; i++)
+      assert(atomic_load(&visit_counts[i]) == 1);
+  }
+  assert(mpmc_traverse(NULL, 2, count_visit, NULL) == 0);
+
+  for (int i = 0; i < 12000; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  free(vals);
+  printf("mpmc_traverse tests passed!\n");
+}
+
+int main() {
+  test_single_thread();
+  test_concurrent();
+  test_traverse();
+  printf("All MPMC tests passed!\n");
+  return 0;
+}
@@ -78,6 +78,349 @@ void test_nodeset() {
   printf("NodeSet tests passed!\n");
 }
 
+void test_nodeset_index() {
+  printf("Testing indexed NodeSet...\n");
+  int count = 1000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++) {
+    nodes[i] = create_node(NULL, i);
+  }
+
+  // ============ add ============
+  NodeSet *set = nodeset_create(0);
+  for (int i = 0; i < count; i++) {
+    nodeset_add(set, nodes[i]);
+    nodeset_add(set, nodes[i / 2]);
+    if (i == NODESET_INLINE_CAPACITY)
+      assert(set->nodes != set->inline_nodes);
+  }
+  assert(nodeset_size(set) == (size_t)count);
+  assert(set->index != NULL);
+  for (int i = 0; i < count; i++) {
+    assert(set->nodes[i] == nodes[i]);
+    assert(nodeset_contains(set, nodes[i]));
+  }
+  printf("NodeSet keeps insertion order and rejects duplicates\n");
+
+  // ============ remove ============
+  for (int i = 0; i < count; i += 3) {
+    nodeset_swap_remove(set, nodes[i]);
+  }
+  for (int i = 1; i < count; i += 3) {
+    nodeset_remove(set, nodes[i]);
+  }
+  nodeset_swap_remove(set, nodes[0]);
+  assert(nodeset_size(set) == (size_t)(count / 3));
+  for (int i = 0; i < count; i++) {
+    assert(nodeset_contains(set, nodes[i]) == (i % 3 == 2));
+  }
+  for (size_t i = 0; i < nodeset_size(set); i++) {
+    nodeset_swap_remove(set, set->nodes[0]);
+    i--;
+  }
+  assert(nodeset_is_empty(set));
+  nodeset_add(set, nodes[5]);
+  assert(nodeset_contains(set, nodes[5]) && !nodeset_contains(set, nodes[6]));
+  nodeset_destroy(set);
+
+  // Ordered removal shifts the index positions in place
+  set = nodeset_create(0);
+  for (int i = 0; i < 100; i++) {
+    nodeset_add_weighted(set, nodes[i], (uint32_t)i);
+  }
+  for (int i = 0; i < 100; i += 2) {
+    nodeset_remove(set, nodes[i]);
+  }
+  assert(nodeset_size(set) == 50 && set->index != NULL);
+  for (int i = 0; i < 50; i++) {
+    uint32_t weight;
+    assert(set->nodes[i] == nodes[2 * i + 1]);
+    assert(nodeset_get_weight(set, nodes[2 * i + 1], &weight));
+    assert(weight == (uint32_t)(2 * i + 1));
+    assert(!nodeset_contains(set, nodes[2 * i]));
+  }
+  printf("Ordered and swap removal keep lookups consistent\n");
+
+  nodeset_destroy(set);
+  for (int i = 0; i < count; i++) {
+    destroy_node(nodes[i]);
+  }
+  free(nodes);
+  printf("Indexed NodeSet tests passed!\n");
+}
+
+void test_removal() {
+  printf("Testing edge, child and node removal...\n");
+  int count = 100;
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++) {
+    nodes[i] = create_node(NULL, i);
+  }
+  Node *hub = nodes[0];
+
+  // ============ remove_edge ============
+  for (int i = 1; i < count; i++) {
+    add_weighted_edge(hub, nodes[i], (uint32_t)i, true, true);
+  }
+  assert(hub->edges->index != NULL);
+  remove_edge(hub, nodes[10], true, true);
+  assert(!nodeset_contains(hub->edges, nodes[10]));
+  assert(!nodeset_contains(hub->outgoing, nodes[10]));
+  assert(nodeset_is_empty(nodes[10]->incoming));
+  assert(nodeset_is_empty(nodes[10]->edges));
+  assert(nodeset_size(hub->edges) == (size_t)count - 2);
+  uint32_t weight;
+  assert(get_edge_weight(hub, nodes[count - 1], &weight));
+  assert(weight == (uint32_t)count - 1);
+  // Absent edges and flags that were never set are ignored
+  remove_edge(hub, nodes[10], true, true);
+  remove_edge(nodes[10], hub, true, false);
+  remove_edge(NULL, hub, true, true);
+  assert(nodeset_size(hub->edges) == (size_t)count - 2);
+  assert(nodeset_size(hub->outgoing) == (size_t)count - 2);
+  printf("remove_edge undoes add_edge\n");
+
+  // ============ remove_child ============
+  for (int i = 1; i <= 5; i++) {
+    add_child(nodes[1], nodes[i + 1]);
+  }
+  add_child(nodes[2], nodes[20]);
+  assert(height(nodes[1]) == 2 && num_nodes(nodes[1]) == 7);
+  remove_child(nodes[1], nodes[2]);
+  assert(is_root(nodes[2]) && height(nodes[1]) == 1);
+  assert(num_nodes(nodes[1]) == 5);
+  // The last child takes the removed one's place
+  assert(get_node_children(nodes[1])->nodes[0] == nodes[6]);
+  assert(get_node_children(nodes[1])->nodes[1] == nodes[3]);
+  remove_child(nodes[3], nodes[4]);
+  assert(get_node_parent(nodes[4]) == nodes[1]);
+  // Indexed children stay findable while members move around
+  for (int i = 60; i < count; i++) {
+    add_child(nodes[59], nodes[i]);
+  }
+  for (int i = 60; i < count; i += 2) {
+    remove_child(nodes[59], nodes[i]);
+  }
+  for (int i = 60; i < count; i++) {
+    NodeSet *children = get_node_children(nodes[59]);
+    assert(nodeset_contains(children, nodes[i]) == (i % 2 == 1));
+    assert(is_root(nodes[i]) == (i % 2 == 0));
+  }
+  for (int i = 61; i < count; i += 2) {
+    remove_child(nodes[59], nodes[i]);
+  }
+  assert(is_leaf(nodes[59]) && num_nodes(nodes[59]) == 1);
+  printf("remove_child swap-removes and updates aggregates\n");
+
+  // ============ unlink_node ============
+  add_edge(nodes[50], nodes[51], true, false);
+  add_edge(nodes[52], nodes[50], true, false);
+  add_edge(nodes[50], nodes[50], true, true);
+  add_child(nodes[1], nodes[50]);
+  add_child(nodes[50], nodes[53]);
+  unlink_node(nodes[50]);
+  assert(nodeset_is_empty(nodes[50]->edges));
+  assert(nodeset_is_empty(nodes[50]->incoming));
+  assert(nodeset_is_empty(nodes[50]->outgoing));
+  assert(nodeset_is_empty(nodes[50]->children));
+  assert(is_root(nodes[50]) && is_root(nodes[53]));
+  assert(!nodeset_contains(nodes[51]->incoming, nodes[50]));
+  assert(nodeset_is_empty(nodes[52]->outgoing));
+  assert(!nodeset_contains(nodes[52]->edges, nodes[50]));
+  assert(!nodeset_contains(hub->edges, nodes[50]));
+  assert(!nodeset_contains(get_node_children(nodes[1]), nodes[50]));
+  assert(num_nodes(nodes[1]) == 5);
+  // A child moved to another parent keeps that link
+  add_child(nodes[54], nodes[55]);
+  add_child(nodes[56], nodes[55]);
+  unlink_node(nodes[54]);
+  assert(get_node_parent(nodes[55]) == nodes[56]);
+  assert(nodeset_contains(get_node_children(nodes[56]), nodes[55]));
+  unlink_node(hub);
+  for (int i = 1; i < count; i++) {
+    assert(nodeset_is_empty(nodes[i]->incoming));
+    assert(!nodeset_contains(nodes[i]->edges, hub));
+  }
+  unlink_node(NULL);
+  printf("unlink_node removes every reachable entry\n");
+
+  for (int i = 0; i < count; i++) {
+    destroy_node(nodes[i]);
+  }
+  free(nodes);
+  printf("Removal tests passed!\n");
+}
+
+// Same members (matched by id) in the same order, with the same weights
+static void assert_same_set(NodeSet *a, NodeSet *b) {
+  assert(a->size == b->size);
+  for (size_t i = 0; i < a->size; i++) {
+    assert(a->nodes[i]->node_id == b->nodes[i]->node_id);
+    assert(nodeset_weight(a, i) == nodeset_weight(b, i));
+    assert(nodeset_contains(b, b->nodes[i]));
+  }
+}
+
+void test_bulk_edges() {
+  printf("Testing bulk edge insertion...\n");
+  int count = 200;
+  size_t batch = 5000;
+  Node **a = malloc(count * sizeof(Node *));
+  Node **b = malloc(count * sizeof(Node *));
+  Node **src = malloc(batch * sizeof(Node *));
+  Node **dst = malloc(batch * sizeof(Node *));
+  uint64_t state = 99;
+  for (int flags = 0; flags < 4; flags++) {
+    bool directed = flags & 1, bidirectional = flags & 2;
+    for (int i = 0; i < count; i++) {
+      a[i] = create_node(NULL, i);
+      b[i] = create_node(NULL, i);
+    }
+    // Existing edges, some weighted, that the batch repeats
+    add_weighted_edge(a[0], a[1], 7, true, true);
+    add_weighted_edge(b[0], b[1], 7, true, true);
+    add_edge(a[2], a[3], false, false);
+    add_edge(b[2], b[3], false, false);
+    for (size_t i = 0; i < batch; i++) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      int from = (int)((state >> 33) % 16);
+      int to = (int)((state >> 20) % (uint64_t)count);
+      if (i % 3 == 0)
+        from = (int)((state >> 40) % (uint64_t)count);
+      if (i == 7)
+        to = from;
+      if (i == 11) {
+        from = 0;
+        to = 1;
+      }
+      src[i] = b[from];
+      dst[i] = b[to];
+      // NULL entries are skipped, as add_edge skips them
+      if (i == batch - 1)
+        src[i] = NULL;
+      else
+        add_edge(a[from], a[to], directed, bidirectional);
+    }
+    assert(add_edges(src, dst, batch, directed, bidirectional));
+    add_edges(&b[5], &(Node *){NULL}, 1, directed, bidirectional);
+    for (int i = 0; i < count; i++) {
+      assert_same_set(a[i]->edges, b[i]->edges);
+      assert_same_set(a[i]->incoming, b[i]->incoming);
+      assert_same_set(a[i]->outgoing, b[i]->outgoing);
+    }
+    uint32_t weight;
+    assert(get_edge_weight(b[0], b[1], &weight) && weight == 7);
+    for (int i = 0; i < count; i++) {
+      destroy_node(a[i]);
+      destroy_node(b[i]);
+    }
+  }
+  printf("add_edges matches add_edge for every flag combination\n");
+
+  assert(add_edges(NULL, NULL, 0, true, true));
+  assert(!add_edges(NULL, dst, 3, true, true));
+  free(a);
+  free(b);
+  free(src);
+  free(dst);
+  printf("Bulk edge tests passed!\n");
+}
+
+void test_weights() {
+  printf("Testing weighted edges...\n");
+  Node *nodes[40];
+  for (int i = 0; i < 40; i++) {
+    nodes[i] = create_node(NULL, i);
+  }
+  uint32_t weight;
+  add_edge(nodes[0], nodes[1], true, false);
+  assert(nodes[0]->edges->weights == NULL);
+  assert(get_edge_weight(nodes[0], nodes[1], &weight) && weight == 1);
+  for (int i = 2; i < 40; i++) {
+    add_weighted_edge(nodes[0], nodes[i], 100 + i, true, true);
+  }
+  assert(get_edge_weight(nodes[0], nodes[1], &weight) && weight == 1);
+  assert(get_edge_weight(nodes[0], nodes[7], &weight) && weight == 107);
+  assert(get_edge_weight(nodes[7], nodes[0], &weight) && weight == 107);
+  assert(!get_edge_weight(nodes[1], nodes[0], &weight));
+  assert(nodeset_get_weight(nodes[0]->outgoing, nodes[9], &weight) &&
+         weight == 109);
+  assert(nodeset_get_weight(nodes[9]->incoming, nodes[0], &weight) &&
+         weight == 109);
+  add_weighted_edge(nodes[0], nodes[7], 5, false, false);
+  assert(get_edge_weight(nodes[0], nodes[7], &weight) && weight == 5);
+  assert(nodeset_size(nodes[0]->edges) == 39);
+  printf("Weights are stored per adjacency entry\n");
+
+  // Removal keeps every remaining member paired with its own weight
+  NodeSet *edges = nodes[0]->edges;
+  nodeset_remove(edges, nodes[3]);
+  nodeset_swap_remove(edges, nodes[10]);
+  nodeset_swap_remove(edges, nodes[1]);
+  for (size_t i = 0; i < nodeset_size(edges); i++) {
+    int id = (int)edges->nodes[i]->node_id;
+    assert(nodeset_weight(edges, i) == (id == 7 ? 5u : 100u + id));
+  }
+  printf("Weights follow members through removal\n");
+
+  // Bulk fill: reserve, append with repeats, then dedup once
+  NodeSet *bulk = nodeset_create(0);
+  for (int round = 0; round < 2; round++) {
+    // A small set is deduplicated by scanning, a large one via its index
+    int distinct = round ? 40 : 5;
+    size_t total = (size_t)distinct * 3;
+    assert(nodeset_reserve(bulk, total, true));
+    bulk->size = 0;
+    for (size_t i = 0; i < total; i++) {
+      bulk->weights[bulk->size] = (uint32_t)i;
+      bulk->nodes[bulk->size++] = nodes[(i * 7) % (size_t)distinct];
+    }
+    assert(nodeset_dedup(bulk) == total - (size_t)distinct);
+    assert(nodeset_size(bulk) == (size_t)distinct);
+    // The pattern repeats every distinct entries: the first round fixes
+    // the order and the last one the weights
+    for (size_t j = 0; j < (size_t)distinct; j++) {
+      assert(bulk->nodes[j] == nodes[(j * 7) % (size_t)distinct]);
+      assert(nodeset_contains(bulk, bulk->nodes[j]));
+      assert(nodeset_weight(bulk, j) == j + 2 * (size_t)distinct);
+    }
+  }
+  nodeset_destroy(bulk);
+  printf("Bulk appends are deduplicated in one pass\n");
+
+  for (int i = 0; i < 40; i++) {
+    destroy_node(nodes[i]);
+  }
+  printf("Weighted edge tests passed!\n");
+}
+
+void test_nodemap() {
+  printf("Testing NodeMap...\n");
+  NodeMap *map = nodemap_create(0);
+  Node *nodes[100];
+  for (int i = 0; i < 100; i++) {
+    nodes[i] = create_node(NULL, i);
+    assert(nodemap_put(map, nodes[i], (size_t)i * 2));
+  }
+  assert(nodemap_put(map, nodes[7], 1));
+  assert(nodemap_size(map) == 100);
+
+  size_t value;
+  assert(nodemap_get(map, nodes[7], &value) && value == 1);
+  assert(nodemap_get(map, nodes[99], &value) && value == 198);
+  assert(!nodemap_get(map, NULL, &value));
+
+  Node *missing = create_node(NULL, -1);
+  assert(!nodemap_get(map, missing, &value));
+
+  nodemap_destroy(map);
+  destroy_node(missing);
+  for (int i = 0; i < 100; i++) {
+    destroy_node(nodes[i]);
+  }
+  printf("NodeMap tests passed!\n");
+}
+
 void test_queue() {
   printf("Testing Queue...\n");
   NodeQueue *queue = queue_create(2);
@@ -92,11 +435,112 @@ void test_queue() {
   assert(queue_dequeue(queue) == node);
   assert(queue_is_empty(queue) == 1);
 
+  // Interleave so the ring wraps before it grows
+  Node *nodes[10];
+  for (int i = 0; i < 10; i++) {
+    nodes[i] = create_node(&val, (double)i);
+  }
+  int next_in = 0, next_out = 0;
+  while (next_out < 10) {
+    for (int k = 0; k < 3 && next_in < 10; k++) {
+      queue_enqueue(queue, nodes[next_in++]);
+    }
+    assert(queue_dequeue(queue) == nodes[next_out++]);
+    if (next_in == 10) {
+      while (!queue_is_empty(queue)) {
+        assert(queue_dequeue(queue) == nodes[next_out++]);
+      }
+    }
+  }
+  assert(queue->capacity < 10);
+
   queue_destroy(queue);
   destroy_node(node);
+  for (int i = 0; i < 10; i++) {
+    destroy_node(nodes[i]);
+  }
   printf("Queue tests passed!\n");
 }
 
+void test_arena() {
+  printf("Testing GraphArena...\n");
+  GraphArena *arena = arena_create(0);
+  assert(arena_num_nodes(arena) == 0);
+
+  // More nodes than the first chunk holds
+  Node *nodes[1000];
+  for (int i = 0; i < 1000; i++) {
+    nodes[i] = arena_create_node(arena, NULL, (double)i);
+    assert(nodes[i] && nodes[i]->node_id == (double)i);
+    assert(nodeset_is_empty(nodes[i]->edges));
+  }
+  assert(arena_num_nodes(arena) == 1000);
+
+  // Sets spill past their inline storage and get an index
+  for (int i = 1; i < 100; i++) {
+    add_edge(nodes[0], nodes[i], true, true);
+    add_child(nodes[0], nodes[i]);
+  }
+  assert(nodeset_size(nodes[0]->edges) == 99);
+  assert(nodeset_contains(nodes[0]->outgoing, nodes[50]));
+  assert(nodeset_contains(nodes[50]->incoming, nodes[0]));
+  assert(get_node_parent(nodes[99]) == nodes[0]);
+
+  // Destroyed slots are reused
+  destroy_node(nodes[0]);
+  assert(arena_num_nodes(arena) == 999);
+  Node *reused = arena_create_node(arena, NULL, -1.0);
+  assert(reused == nodes[0]);
+  assert(nodeset_is_empty(reused->children) && reused->parent == NULL);
+  add_edge(reused, nodes[1], false, false);
+
+  // Releases everything, including the spilled sets of live nodes
+  arena_destroy(arena);
+  printf("GraphArena tests passed!\n");
+}
+
+void test_relocate() {
+  printf("Testing arena relocation...\n");
+  Node *nodes[20];
+  for (int i = 0; i < 20; i++) {
+    nodes[i] = create_node(NULL, i);
+    if (i > 0)
+      add_child(nodes[0], nodes[i]);
+  }
+  add_weighted_edge(nodes[3], nodes[4], 9, true, false);
+  Node *outside = create_node(NULL, 99);
+  add_edge(nodes[5], outside, false, false);
+
+  // Reverse order; the outside node is referenced but not moved
+  Node *order[20], *moved[20];
+  for (int i = 0; i < 20; i++) {
+    order[i] = nodes[19 - i];
+  }
+  GraphArena *arena = arena_relocate(order, 20, moved);
+  assert(arena && arena_num_nodes(arena) == 20);
+  Node *root = moved[19];
+  assert(root->node_id == 0 && moved[0]->node_id == 19);
+  assert((char *)moved[2] - (char *)moved[1] ==
+         (char *)moved[1] - (char *)moved[0]);
+  assert(root->children->borrowed && nodeset_size(root->children) == 19);
+  assert(root->children->nodes[0] == moved[18]);
+  assert(moved[18]->parent == root);
+  uint32_t weight;
+  assert(get_edge_weight(moved[16], moved[15], &weight) && weight == 9);
+  assert(nodeset_contains(moved[15]->incoming, moved[16]));
+  assert(moved[14]->edges->nodes[0] == outside);
+  assert(num_nodes(root) == 20);
+
+  // Growing a borrowed set copies it out of the arena storage
+  Node *extra = arena_create_node(arena, NULL, 20);
+  add_child(root, extra);
+  assert(!root->children->borrowed && num_nodes(root) == 21);
+  assert(root->children->nodes[0] == moved[18]);
+  arena_destroy(arena);
+  destroy_node(outside);
+  printf("Arena relocation tests passed!\n");
+}
+
 void test_tree_structure() {
   printf("Testing Tree Structure...\n");
   int val1 = 1, val2 = 2, val3 = 3;
@@ -122,6 +566,126 @@ void test_tree_structure() {
   printf("Tree structure tests passed!\n");
 }
 
+// Uncached reference implementations
+int ref_height(Node *node) {
+  int max = -1;
+  for (size_t i = 0; i < nodeset_size(node->children); i++) {
+    int h = ref_height(node->children->nodes[i]);
+    if (h > max)
+      max = h;
+  }
+  return max + 1;
+}
+
+int ref_size(Node *node) {
+  int count = 1;
+  for (size_t i = 0; i < nodeset_size(node->children); i++)
+    count += ref_size(node->children->nodes[i]);
+  return count;
+}
+
+int ref_leaves(Node *node) {
+  if (nodeset_size(node->children) == 0)
+    return 1;
+  int count = 0;
+  for (size_t i = 0; i < nodeset_size(node->children); i++)
+    count += ref_leaves(node->children->nodes[i]);
+  return count;
+}
+
+int ref_diameter(Node *node) {
+  int max1 = 0, max2 = 0, best = 0;
+  for (size_t i = 0; i < nodeset_size(node->children); i++) {
+    Node *child = node->children->nodes[i];
+    int h = ref_height(child);
+    if (h > max1) {
+      max2 = max1;
+      max1 = h;
+    } else if (h > max2) {
+      max2 = h;
+    }
+    int d = ref_diameter(child);
+    if (d > best)
+      best = d;
+  }
+  return max1 + max2 + 1 > best ? max1 + max2 + 1 : best;
+}
+
+void test_aggregates() {
+  printf("Testing cached aggregates...\n");
+  // Grow a random tree, querying subtrees between insertions
+  Node *nodes[500];
+  srand(3);
+  for (int i = 0; i < 500; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    if (i)
+      add_child(nodes[rand() % i], nodes[i]);
+    if (i % 7 == 0) {
+      Node *probe = nodes[rand() % (i + 1)];
+      assert(height(probe) == ref_height(probe));
+      assert(num_nodes(probe) == ref_size(probe));
+      assert(num_leaves(probe) == ref_leaves(probe));
+      assert(diameter(probe) == ref_diameter(probe));
+    }
+  }
+  assert(num_nodes(nodes[0]) == 500);
+  assert(height(nodes[0]) == ref_height(nodes[0]));
+  assert(diameter(nodes[0]) == ref_diameter(nodes[0]));
+
+  // Changes made behind add_child's back need node_invalidate
+  Node *extra = create_node(NULL, 500.0);
+  nodeset_add(nodes[499]->children, extra);
+  node_invalidate(nodes[499]);
+  assert(num_nodes(nodes[0]) == 501);
+  assert(height(nodes[0]) == ref_height(nodes[0]));
+  destroy_node(extra);
+  for (int i = 0; i < 500; i++)
+    destroy_node(nodes[i]);
+
+  // A child listed under two parents: growth below it reaches both
+  Node *p = create_node(NULL, 0.0), *q = create_node(NULL, 1.0);
+  Node *s = create_node(NULL, 2.0), *d = create_node(NULL, 3.0);
+  Node *top = create_node(NULL, 4.0);
+  add_child(top, p);
+  add_child(p, s);
+  add_child(q, s);
+  assert(height(p) == 1 && height(top) == 2 && height(q) == 1);
+  add_child(s, d);
+  assert(height(p) == 2 && height(q) == 2);
+  assert(num_nodes(top) == 4 && diameter(top) == 3);
+  assert(height(p) == 2 && num_nodes(p) == 3);
+  // Once s is listed under one parent again, p's chain caches again
+  remove_child(q, s);
+  nodeset_swap_remove(p->children, s);
+  add_child(p, s);
+  assert(height(top) == 3 && !top->aggregates_dirty);
+  destroy_node(p);
+  destroy_node(q);
+  destroy_node(s);
+  destroy_node(d);
+  destroy_node(top);
+
+  // Deep chains do not recurse
+  int length = 200000;
+  Node **chain = malloc(length * sizeof(Node *));
+  for (int i = 0; i < length; i++) {
+    chain[i] = create_node(NULL, (double)i);
+    if (i)
+      add_child(chain[i - 1], chain[i]);
+  }
+  assert(height(chain[0]) == length - 1);
+  assert(num_nodes(chain[0]) == length);
+  assert(num_leaves(chain[0]) == 1);
+  assert(diameter(chain[0]) == length - 1);
+  add_child(chain[length - 1], create_node(NULL, -1.0));
+  assert(height(chain[0]) == length);
+  destroy_node(chain[length - 1]->children->nodes[0]);
+  for (int i = 0; i < length; i++)
+    destroy_node(chain[i]);
+  free(chain);
+  printf("Cached aggregate tests passed!\n");
+}
+
 void test_traversal() {
   printf("Testing all traversal methods...\n");
 
@@ -165,14 +729,119 @@ void test_traversal() {
   printf("All traversal tests passed!\n");
 }
 
+// Records values into a context; stops at stop_at, skips below skip_at
+typedef struct {
+  int values[MAX_NODES];
+  int count;
+  int stop_at;
+  int skip_at;
+} VisitLog;
+
+VisitResult log_visit(Node *node, void *ctx) {
+  VisitLog *log = (VisitLog *)ctx;
+  int value = *(int *)get_node_value(node);
+  log->values[log->count++] = value;
+  if (value == log->stop_at)
+    return VISIT_STOP;
+  if (value == log->skip_at)
+    return VISIT_SKIP;
+  return VISIT_CONTINUE;
+}
+
+VisitResult count_visit(Node *node, void *ctx) {
+  (void)node;
+  (*(long *)ctx)++;
+  return VISIT_CONTINUE;
+}
+
+void test_visitors() {
+  printf("Testing visitor traversals...\n");
+  Node *root = build_sample_tree();
+
+  VisitLog log = {{0}, 0, 5, -1};
+  assert(preorder_visit(root, log_visit, &log));
+  int stop_expected[] = {1, 2, 4, 7, 5};
+  assert(log.count == 5 && arrays_equal(log.values, stop_expected, 5));
+
+  log = (VisitLog){{0}, 0, -1, 2};
+  assert(!dfs_visit(root, log_visit, &log));
+  int skip_expected[] = {1, 2, 3, 6};
+  assert(log.count == 4 && arrays_equal(log.values, skip_expected, 4));
+
+  log = (VisitLog){{0}, 0, -1, 2};
+  assert(!bfs_visit(root, log_visit, &log));
+  assert(log.count == 4 && arrays_equal(log.values, skip_expected, 4));
+
+  log = (VisitLog){{0}, 0, 4, -1};
+  assert(bfs_visit(root, log_visit, &log));
+  int bfs_stop_expected[] = {1, 2, 3, 4};
+  assert(log.count == 4 && arrays_equal(log.values, bfs_stop_expected, 4));
+
+  // Skip means nothing in postorder; stop still ends the walk
+  log = (VisitLog){{0}, 0, 2, 4};
+  assert(postorder_visit(root, log_visit, &log));
+  int post_expected[] = {7, 4, 8, 5, 2};
+  assert(log.count == 5 && arrays_equal(log.values, post_expected, 5));
+
+  assert(!preorder_visit(NULL, log_visit, &log));
+
+  // Preorder numbering: ids, parents and subtree ranges
+  Node *flat[8];
+  uint32_t parent[8], last[8];
+  NodeMap *ids = nodemap_create(8);
+  assert(preorder_flatten(root, 8, flat, parent, last, ids) == 8);
+  uint32_t parent_expected[] = {UINT32_MAX, 0, 1, 2, 1, 4, 0, 6};
+  uint32_t last_expected[] = {7, 5, 3, 3, 5, 5, 7, 7};
+  int value_expected[] = {1, 2, 4, 7, 5, 8, 3, 6};
+  for (uint32_t i = 0; i < 8; i++) {
+    size_t id;
+    assert(*(int *)flat[i]->value == value_expected[i]);
+    assert(nodemap_get(ids, flat[i], &id) && id == i);
+    assert(parent[i] == parent_expected[i] && last[i] == last_expected[i]);
+  }
+  nodemap_destroy(ids);
+  ids = nodemap_create(8);
+  assert(preorder_flatten(root, 3, flat, parent, last, ids) == 3);
+  assert(last[0] == 2 && last[1] == 2 && last[2] == 2);
+  assert(preorder_flatten(NULL, 8, flat, parent, last, ids) == 0);
+  nodemap_destroy(ids);
+
+  // Deep chains do not recurse
+  int length = 200000;
+  Node **chain = malloc(length * sizeof(Node *));
+  for (int i = 0; i < length; i++) {
+    chain[i] = create_node(NULL, (double)i);
+    if (i)
+      add_child(chain[i - 1], chain[i]);
+  }
+  long count = 0;
+  assert(!preorder_visit(chain[0], count_visit, &count));
+  assert(!postorder_visit(chain[0], count_visit, &count));
+  assert(!bfs_visit(chain[0], count_visit, &count));
+  assert(count == 3L * length);
+  for (int i = 0; i < length; i++)
+    destroy_node(chain[i]);
+  free(chain);
+  printf("Visitor traversal tests passed!\n");
+}
+
 int main() {
   printf("==================\n");
   printf("Running Node tests...\n\n");
 
   test_nodeset();
+  test_nodeset_index();
+  test_removal();
+  test_bulk_edges();
+  test_weights();
+  test_nodemap();
   test_queue();
+  test_arena();
+  test_relocate();
   test_tree_structure();
+  test_aggregates();
   test_traversal();
+  test_visitors();
 
   printf("==================\n");
   printf("All Node tests passed!\n");
@@ -0,0 +1,166 @@
+#include "pagerank.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Power iteration straight over the Node sets, as callers wrote it before
+static void reference_pagerank(CSRGraph *csr, double damping, int iterations,
+                               double *rank) {
+  size_t n = csr->num_nodes;
+  double *next = malloc(n * sizeof(double));
+  for (size_t i = 0; i < n; i++)
+    rank[i] = 1.0 / n;
+  for (int it = 0; it < iterations; it++) {
+    double dangling = 0;
+    for (size_t i = 0; i < n; i++) {
+      if (nodeset_is_empty(csr->nodes[i]->outgoing))
+        dangling += rank[i];
+    }
+    for (size_t v = 0; v < n; v++) {
+      NodeSet *in = csr->nodes[v]->incoming;
+      double sum = 0;
+      for (size_t j = 0; j < in->size; j++) {
+        uint32_t u = csr_index_of(csr, in->nodes[j]);
+        sum += rank[u] / nodeset_size(in->nodes[j]->outgoing);
+      }
+      next[v] = (1 - damping + damping * dangling) / n + damping * sum;
+    }
+    for (size_t i = 0; i < n; i++)
+      rank[i] = next[i];
+  }
+  free(next);
+}
+
+static double rank_sum(const double *rank, size_t n) {
+  double sum = 0;
+  for (size_t i = 0; i < n; i++)
+    sum += rank[i];
+  return sum;
+}
+
+void test_small() {
+  printf("Testing PageRank on small graphs...\n");
+  Node *nodes[4];
+  for (int i = 0; i < 4; i++)
+    nodes[i] = create_node(NULL, i);
+  // A directed 3-cycle is uniform from the start
+  for (int i = 0; i < 3; i++)
+    add_edge(nodes[i], nodes[(i + 1) % 3], true, false);
+  CSRGraph *csr = csr_freeze(nodes, 3);
+  double rank[4];
+  PageRankResult result;
+  assert(pagerank(csr, NULL, rank, &result));
+  assert(result.iterations == 1 && result.delta < 1e-15);
+  for (int i = 0; i < 3; i++)
+    assert(fabs(rank[i] - 1.0 / 3) < 1e-15);
+  csr_destroy(csr);
+  printf("A cycle converges at once\n");
+
+  // Node 3 only receives: its rank is handed back to everyone
+  add_edge(nodes[0], nodes[3], true, false);
+  add_edge(nodes[1], nodes[3], true, false);
+  csr = csr_freeze(nodes, 4);
+  PageRankOptions options = {0.85, 1e-12, 1000, 2};
+  assert(pagerank(csr, &options, rank, &result));
+  assert(result.delta < 1e-12 && result.iterations < 1000);
+  assert(fabs(rank_sum(rank, 4) - 1) < 1e-12);
+  assert(rank[3] > rank[0] && rank[3] > rank[1]);
+  // The fixed point satisfies the update rule
+  double base = (0.15 + 0.85 * rank[3]) / 4;
+  assert(fabs(rank[3] - (base + 0.85 * (rank[0] / 2 + rank[1] / 2))) < 1e-11);
+  assert(fabs(rank[0] - (base + 0.85 * rank[2])) < 1e-11);
+  printf("Dangling rank is spread over all nodes\n");
+
+  options = (PageRankOptions){0.0, 1e-9, 5, 1};
+  assert(pagerank(csr, &options, rank, &result));
+  assert(result.iterations == 1 && rank[3] == 0.25);
+  options = (PageRankOptions){0.85, 0, 7, 1};
+  assert(pagerank(csr, &options, rank, &result) && result.iterations == 7);
+  options.max_iterations = 0;
+  assert(pagerank(csr, &options, rank, &result) && result.iterations == 0);
+  assert(rank[2] == 0.25);
+  printf("Damping and the iteration limit are honored\n");
+
+  options = (PageRankOptions){1.5, 0, 5, 1};
+  assert(!pagerank(csr, &options, rank, NULL));
+  options = (PageRankOptions){NAN, 0, 5, 1};
+  assert(!pagerank(csr, &options, rank, NULL));
+  options = (PageRankOptions){0.85, -1, 5, 1};
+  assert(!pagerank(csr, &options, rank, NULL));
+  assert(!pagerank(NULL, NULL, rank, NULL));
+  assert(!pagerank(csr, NULL, NULL, NULL));
+  csr_destroy(csr);
+  csr = csr_freeze(nodes, 0);
+  assert(pagerank(csr, NULL, rank, &result) && result.iterations == 0);
+  csr_destroy(csr);
+  for (int i = 0; i < 4; i++)
+    destroy_node(nodes[i]);
+  printf("Small graph tests passed!\n");
+}
+
+void test_matches_reference() {
+  printf("Testing PageRank against a reference...\n");
+  int count = 3000;
+  uint64_t state = 12345;
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++)
+    nodes[i] = create_node(NULL, i);
+  // Skewed in-degrees, self-loops, and a tenth of the nodes dangling
+  for (int i = 0; i < count; i++) {
+    if (i % 10 == 0)
+      continue;
+    int degree = 1 + i % 13;
+    for (int j = 0; j < degree; j++) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      int target = (int)((state >> 33) % (uint64_t)count);
+      if (j % 4 == 0)
+        target = target % 50;
+      add_edge(nodes[i], nodes[target], true, false);
+    }
+  }
+  add_edge(nodes[7], nodes[7], true, false);
+  // A hub with a long in-list
+  for (int i = 1; i < count; i += 2)
+    add_edge(nodes[i], nodes[0], true, false);
+
+  CSRGraph *csr = csr_freeze(nodes, count);
+  double *expected = malloc(count * sizeof(double));
+  double *rank = malloc(count * sizeof(double));
+  reference_pagerank(csr, 0.85, 30, expected);
+  int threads[] = {1, 2, 3, 8};
+  for (int t = 0; t < 4; t++) {
+    PageRankOptions options = {0.85, 0, 30, threads[t]};
+    PageRankResult result;
+    assert(pagerank(csr, &options, rank, &result));
+    assert(result.iterations == 30);
+    for (int i = 0; i < count; i++)
+      assert(fabs(rank[i] - expected[i]) < 1e-12);
+    assert(fabs(rank_sum(rank, count) - 1) < 1e-9);
+  }
+  printf("Every thread count matches the reference\n");
+
+  PageRankOptions options = {0.85, 1e-10, 1000, 4};
+  PageRankResult result;
+  assert(pagerank(csr, &options, rank, &result));
+  assert(result.delta < 1e-10 && result.iterations > 5);
+  assert(result.iterations < 1000);
+  for (int i = 1; i < count; i++)
+    assert(rank[0] >= rank[i]);
+  printf("Converges to the tolerance, hub ranked first\n");
+
+  free(expected);
+  free(rank);
+  csr_destroy(csr);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  printf("Reference tests passed!\n");
+}
+
+int main() {
+  test_small();
+  test_matches_reference();
+  printf("All pagerank tests passed!\n");
+  return 0;
+}
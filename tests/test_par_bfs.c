@@ -0,0 +1,139 @@
+#include "par_bfs.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Sequential reference BFS over CSR_OUTGOING
+void reference_bfs(const CSRGraph *graph, uint32_t source, int32_t *dist) {
+  uint32_t *queue = malloc(graph->num_nodes * sizeof(uint32_t));
+  size_t head = 0, tail = 0;
+  for (size_t i = 0; i < graph->num_nodes; i++)
+    dist[i] = -1;
+  dist[source] = 0;
+  queue[tail++] = source;
+  while (head < tail) {
+    uint32_t node = queue[head++];
+    const uint32_t *next = csr_neighbors(graph, CSR_OUTGOING, node);
+    for (size_t i = 0; i < csr_degree(graph, CSR_OUTGOING, node); i++) {
+      if (dist[next[i]] < 0) {
+        dist[next[i]] = dist[node] + 1;
+        queue[tail++] = next[i];
+      }
+    }
+  }
+  free(queue);
+}
+
+Node **build_random_graph(int count, int degree, unsigned seed) {
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  srand(seed);
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < degree; j++)
+      add_edge(nodes[i], nodes[rand() % count], true, false);
+  }
+  return nodes;
+}
+
+void destroy_graph(Node **nodes, int count) {
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+}
+
+void check_against_reference(const CSRGraph *graph, uint32_t source,
+                             int nthreads) {
+  size_t n = graph->num_nodes;
+  int32_t *expected = malloc(n * sizeof(int32_t));
+  int32_t *dist = malloc(n * sizeof(int32_t));
+  uint32_t *parent = malloc(n * sizeof(uint32_t));
+  reference_bfs(graph, source, expected);
+
+  size_t reached = par_bfs(graph, source, nthreads, dist, parent);
+  size_t expected_reached = 0;
+  for (size_t i = 0; i < n; i++) {
+    assert(dist[i] == expected[i]);
+    if (dist[i] < 0) {
+      assert(parent[i] == CSR_NONE);
+      continue;
+    }
+    expected_reached++;
+    if (i == source) {
+      assert(parent[i] == CSR_NONE);
+      continue;
+    }
+    // The parent is one level up and has an edge to the node
+    uint32_t p = parent[i];
+    assert(p < n && dist[p] == dist[i] - 1);
+    const uint32_t *next = csr_neighbors(graph, CSR_OUTGOING, p);
+    bool found = false;
+    for (size_t j = 0; j < csr_degree(graph, CSR_OUTGOING, p); j++)
+      found |= next[j] == i;
+    assert(found);
+  }
+  assert(reached == expected_reached);
+  free(expected);
+  free(dist);
+  free(parent);
+}
+
+void test_small_graph() {
+  printf("Testing par_bfs on a small graph...\n");
+  Node *nodes[6];
+  for (int i = 0; i < 6; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  add_edge(nodes[0], nodes[1], true, false);
+  add_edge(nodes[0], nodes[2], true, false);
+  add_edge(nodes[1], nodes[3], true, false);
+  add_edge(nodes[2], nodes[3], true, false);
+  add_edge(nodes[3], nodes[4], true, false);
+  add_edge(nodes[5], nodes[0], true, false); // 5 is unreachable from 0
+
+  CSRGraph *graph = csr_freeze(nodes, 6);
+  int32_t dist[6];
+  uint32_t parent[6];
+  assert(par_bfs(graph, 0, 2, dist, parent) == 5);
+  assert(dist[0] == 0 && dist[1] == 1 && dist[2] == 1);
+  assert(dist[3] == 2 && dist[4] == 3 && dist[5] == -1);
+  assert(parent[4] == 3 && parent[5] == CSR_NONE);
+
+  assert(par_bfs(graph, 6, 2, dist, parent) == 0);
+  assert(par_bfs(NULL, 0, 2, dist, parent) == 0);
+
+  csr_destroy(graph);
+  for (int i = 0; i < 6; i++)
+    destroy_node(nodes[i]);
+}
+
+void test_sparse_graph() {
+  printf("Testing par_bfs on a sparse graph...\n");
+  // Low degree keeps every level top-down and leaves some nodes unreached
+  Node **nodes = build_random_graph(2000, 1, 7);
+  CSRGraph *graph = csr_freeze(nodes, 2000);
+  for (int threads = 1; threads <= 4; threads++)
+    check_against_reference(graph, 0, threads);
+  csr_destroy(graph);
+  destroy_graph(nodes, 2000);
+}
+
+void test_dense_graph() {
+  printf("Testing par_bfs on a dense graph...\n");
+  // High degree makes the middle levels run bottom-up
+  Node **nodes = build_random_graph(5000, 24, 11);
+  CSRGraph *graph = csr_freeze(nodes, 5000);
+  for (int threads = 1; threads <= 4; threads++) {
+    check_against_reference(graph, 0, threads);
+    check_against_reference(graph, 4999, threads);
+  }
+  csr_destroy(graph);
+  destroy_graph(nodes, 5000);
+}
+
+int main() {
+  test_small_graph();
+  test_sparse_graph();
+  test_dense_graph();
+  printf("All par_bfs tests passed!\n");
+  return 0;
+}
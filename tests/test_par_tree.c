@@ -0,0 +1,122 @@
+#include "par_tree.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void check_stats(TaskPool *pool, Node *root) {
+  TreeStats stats;
+  assert(par_tree_stats(pool, root, &stats));
+  assert(stats.height == height(root));
+  assert(stats.size == num_nodes(root));
+  assert(stats.leaves == num_leaves(root));
+  assert(stats.diameter == diameter(root));
+  assert(par_height(pool, root) == stats.height);
+  assert(par_num_nodes(pool, root) == stats.size);
+  assert(par_num_leaves(pool, root) == stats.leaves);
+  assert(par_diameter(pool, root) == stats.diameter);
+}
+
+// Random recursive tree, a wide star under a chain, and a long chain
+Node **build_trees(int count, Node **roots) {
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  int third = count / 3;
+  srand(5);
+  for (int i = 1; i < third; i++)
+    add_child(nodes[rand() % i], nodes[i]);
+  for (int i = third + 1; i < third + 10; i++)
+    add_child(nodes[i - 1], nodes[i]);
+  for (int i = third + 10; i < 2 * third; i++)
+    add_child(nodes[third + 9], nodes[i]);
+  for (int i = 2 * third + 1; i < count; i++)
+    add_child(nodes[i - 1], nodes[i]);
+  roots[0] = nodes[0];
+  roots[1] = nodes[third];
+  roots[2] = nodes[2 * third];
+  return nodes;
+}
+
+void test_stats() {
+  printf("Testing parallel tree stats...\n");
+  int count = 300000;
+  Node *roots[3];
+  Node **nodes = build_trees(count, roots);
+  for (int t = 0; t < 3; t++)
+    check_stats(NULL, roots[t]);
+  for (int threads = 1; threads <= 4; threads++) {
+    TaskPool *pool = taskpool_create(threads);
+    for (int t = 0; t < 3; t++)
+      check_stats(pool, roots[t]);
+    taskpool_destroy(pool);
+  }
+  TreeStats stats;
+  assert(par_tree_stats(NULL, NULL, &stats) && stats.size == 0);
+  assert(par_height(NULL, NULL) == 0);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  printf("Parallel tree stats tests passed!\n");
+}
+
+typedef struct {
+  atomic_int clock;
+  int *order; // Visit time per node id
+  int stop_id;
+} OrderLog;
+
+VisitResult record_order(Node *node, void *ctx) {
+  OrderLog *log = (OrderLog *)ctx;
+  int id = (int)node->node_id;
+  assert(log->order[id] < 0);
+  log->order[id] = atomic_fetch_add(&log->clock, 1);
+  return id == log->stop_id ? VISIT_STOP : VISIT_CONTINUE;
+}
+
+void test_postorder() {
+  printf("Testing parallel postorder...\n");
+  int count = 30000;
+  Node *roots[3];
+  Node **nodes = build_trees(count, roots);
+  OrderLog log;
+  log.order = malloc(count * sizeof(int));
+  TaskPool *pool = taskpool_create(4);
+  for (int t = 0; t < 3; t++) {
+    for (int i = 0; i < count; i++)
+      log.order[i] = -1;
+    atomic_init(&log.clock, 0);
+    log.stop_id = -1;
+    assert(!par_postorder_visit(pool, roots[t], record_order, &log));
+    assert(atomic_load(&log.clock) == num_nodes(roots[t]));
+    // Every visited node comes after its children
+    for (int i = 0; i < count; i++) {
+      if (log.order[i] < 0)
+        continue;
+      Node *parent = get_node_parent(nodes[i]);
+      if (parent && log.order[(int)parent->node_id] >= 0)
+        assert(log.order[(int)parent->node_id] > log.order[i]);
+    }
+  }
+
+  // Stopping at the root of a subtree prevents its ancestors' visits
+  for (int i = 0; i < count; i++)
+    log.order[i] = -1;
+  atomic_init(&log.clock, 0);
+  log.stop_id = 1;
+  assert(par_postorder_visit(pool, roots[0], record_order, &log));
+  assert(log.order[1] >= 0 && log.order[0] < 0);
+
+  taskpool_destroy(pool);
+  free(log.order);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  printf("Parallel postorder tests passed!\n");
+}
+
+int main() {
+  test_stats();
+  test_postorder();
+  printf("All par_tree tests passed!\n");
+  return 0;
+}
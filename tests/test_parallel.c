@@ -0,0 +1,55 @@
+#include "parallel.h"
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_THREADS 4
+#define NUM_PHASES 100
+
+typedef struct {
+  ParallelBarrier barrier;
+  atomic_int arrived;
+  atomic_int leaders;
+  int seen[NUM_THREADS];
+} PhaseState;
+
+void run_phases(int thread, void *ctx) {
+  PhaseState *state = (PhaseState *)ctx;
+  state->seen[thread]++;
+  for (int phase = 0; phase < NUM_PHASES; phase++) {
+    atomic_fetch_add(&state->arrived, 1);
+    if (parallel_barrier_wait(&state->barrier))
+      atomic_fetch_add(&state->leaders, 1);
+    // Nobody gets past the barrier before everyone has arrived
+    assert(atomic_load(&state->arrived) >= (phase + 1) * NUM_THREADS);
+    parallel_barrier_wait(&state->barrier);
+  }
+}
+
+void test_parallel_run() {
+  printf("Testing parallel_run and barriers...\n");
+  PhaseState state = {0};
+  parallel_barrier_init(&state.barrier, NUM_THREADS);
+  assert(parallel_run(NUM_THREADS, run_phases, &state) == 0);
+  parallel_barrier_destroy(&state.barrier);
+
+  for (int i = 0; i < NUM_THREADS; i++) {
+    assert(state.seen[i] == 1);
+  }
+  assert(atomic_load(&state.arrived) == NUM_THREADS * NUM_PHASES);
+  assert(atomic_load(&state.leaders) == NUM_PHASES);
+  assert(parallel_default_threads() >= 1);
+  printf("Parallel tests passed!\n");
+}
+
+int main() {
+  printf("==================\n");
+  printf("Running parallel tests...\n\n");
+
+  test_parallel_run();
+
+  printf("==================\n");
+  printf("All parallel tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,137 @@
+#include "pbst.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_NODES 1000
+
+void test_versions() {
+  printf("Testing persistent versions...\n");
+  PBST empty = {NULL, 0};
+
+  // ============ insert ============
+  PBST v1 = pbst_insert(&empty, 50);
+  PBST v2 = pbst_insert(&v1, 30);
+  PBST v3 = pbst_insert(&v2, 70);
+  assert(v1.size == 1 && v2.size == 2 && v3.size == 3);
+  assert(pbst_search(&v1, 30) == NULL);
+  assert(pbst_search(&v2, 30) != NULL && pbst_search(&v2, 70) == NULL);
+  assert(pbst_search(&v3, 70) != NULL);
+  printf("PASS: Older versions are unchanged by inserts\n");
+
+  // ============ delete ============
+  PBST v4 = pbst_delete(&v3, 50);
+  assert(v4.size == 2);
+  assert(pbst_search(&v4, 50) == NULL);
+  assert(pbst_search(&v3, 50) != NULL);
+  printf("PASS: Older versions are unchanged by deletes\n");
+
+  // ============ release ============
+  pbst_release(&v1);
+  pbst_release(&v2);
+  pbst_release(&v3);
+  assert(pbst_search(&v4, 30) != NULL && pbst_search(&v4, 70) != NULL);
+  pbst_release(&v4);
+  assert(v4.root == NULL && v4.size == 0);
+  printf("PASS: Versions stay readable until released\n");
+
+  // ============ NULL version ============
+  PBST v5 = pbst_insert(NULL, 5);
+  assert(v5.size == 1 && pbst_search(&v5, 5) != NULL);
+  PBST v6 = pbst_delete(NULL, 5);
+  assert(v6.size == 0 && v6.root == NULL);
+  pbst_release(&v5);
+  printf("PASS: A NULL version reads as the empty tree\n\n");
+}
+
+void test_structure_sharing() {
+  printf("Testing structure sharing...\n");
+  PBST version = {NULL, 0};
+  for (int i = 0; i < 256; i++) {
+    PBST next = pbst_insert(&version, i);
+    pbst_release(&version);
+    version = next;
+  }
+
+  PBST updated = pbst_insert(&version, 1000);
+  PBSTNode *old_nodes[MAX_NODES];
+  PBSTNode *new_nodes[MAX_NODES];
+  int old_index = 0, new_index = 0;
+  pbst_inorder(version.root, old_nodes, &old_index);
+  pbst_inorder(updated.root, new_nodes, &new_index);
+  assert(old_index == 256 && new_index == 257);
+
+  int shared = 0;
+  for (int i = 0; i < 256; i++) {
+    assert(old_nodes[i]->value == i && new_nodes[i]->value == i);
+    if (old_nodes[i] == new_nodes[i])
+      shared++;
+  }
+  assert(shared > 200);
+  printf("PASS: Insert copied %d of 256 nodes\n", 256 - shared);
+
+  pbst_release(&version);
+  pbst_release(&updated);
+  printf("\n");
+}
+
+// The writer deletes values in increasing order, so every version it
+// publishes holds exactly the values from 128 - size up
+static void *read_published(void *arg) {
+  PBSTHandle *handle = (PBSTHandle *)arg;
+  int size;
+  do {
+    PBST version = pbst_acquire(handle);
+    size = version.size;
+    for (int i = 0; i < 128; i++) {
+      assert((pbst_search(&version, i) != NULL) == (i >= 128 - size));
+    }
+    pbst_release(&version);
+  } while (size > 0);
+  return NULL;
+}
+
+void test_concurrent_readers() {
+  printf("Testing readers during updates...\n");
+  PBST version = {NULL, 0};
+  for (int i = 0; i < 128; i++) {
+    PBST next = pbst_insert(&version, i);
+    pbst_release(&version);
+    version = next;
+  }
+
+  PBSTHandle *handle = pbst_handle_create();
+  assert(handle && pbst_publish(handle, &version));
+  pthread_t readers[4];
+  for (int i = 0; i < 4; i++)
+    pthread_create(&readers[i], NULL, read_published, handle);
+  for (int i = 0; i < 128; i++) {
+    PBST next = pbst_delete(&version, i);
+    pbst_release(&version);
+    version = next;
+    assert(pbst_publish(handle, &version));
+  }
+  for (int i = 0; i < 4; i++)
+    pthread_join(readers[i], NULL);
+
+  assert(version.size == 0 && version.root == NULL);
+  PBST last = pbst_acquire(handle);
+  assert(last.size == 0 && last.root == NULL);
+  pbst_handle_destroy(handle);
+  printf("PASS: Readers saw only whole versions while the writer emptied "
+         "the tree\n\n");
+}
+
+int main() {
+  printf("==================\n");
+  printf("Running persistent BST tests...\n\n");
+
+  test_versions();
+  test_structure_sharing();
+  test_concurrent_readers();
+
+  printf("All persistent BST tests passed!\n");
+  printf("==================\n");
+  return 0;
+}
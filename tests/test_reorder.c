@@ -0,0 +1,200 @@
+#include "reorder.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void check_permutation(const uint32_t *order, size_t n) {
+  bool *seen = calloc(n, sizeof(bool));
+  for (size_t i = 0; i < n; i++) {
+    assert(order[i] < n && !seen[order[i]]);
+    seen[order[i]] = true;
+  }
+  free(seen);
+}
+
+// Largest |position(u) - position(v)| over CSR_EDGES
+size_t bandwidth(const CSRGraph *graph, const uint32_t *order) {
+  size_t n = graph->num_nodes, widest = 0;
+  size_t *position = malloc(n * sizeof(size_t));
+  for (size_t i = 0; i < n; i++)
+    position[order[i]] = i;
+  for (uint32_t u = 0; u < n; u++) {
+    const uint32_t *nb = csr_neighbors(graph, CSR_EDGES, u);
+    for (size_t j = 0; j < csr_degree(graph, CSR_EDGES, u); j++) {
+      size_t a = position[u], b = position[nb[j]];
+      size_t width = a > b ? a - b : b - a;
+      if (width > widest)
+        widest = width;
+    }
+  }
+  free(position);
+  return widest;
+}
+
+void test_orders() {
+  printf("Testing reorder permutations...\n");
+  // A 30x30 grid created in shuffled order
+  int side = 30, n = side * side;
+  Node **grid = malloc(n * sizeof(Node *));
+  for (int i = 0; i < n; i++)
+    grid[i] = create_node(NULL, (double)i);
+  for (int i = 0; i < n; i++) {
+    if (i % side + 1 < side)
+      add_edge(grid[i], grid[i + 1], false, true);
+    if (i + side < n)
+      add_edge(grid[i], grid[i + side], false, true);
+  }
+  srand(61);
+  for (int i = n - 1; i > 0; i--) {
+    int j = rand() % (i + 1);
+    Node *tmp = grid[i];
+    grid[i] = grid[j];
+    grid[j] = tmp;
+  }
+  CSRGraph *graph = csr_freeze(grid, n);
+  uint32_t *order = malloc(n * sizeof(uint32_t));
+  uint32_t *identity = malloc(n * sizeof(uint32_t));
+  for (int i = 0; i < n; i++)
+    identity[i] = i;
+  size_t shuffled = bandwidth(graph, identity);
+  for (int method = REORDER_BFS; method <= REORDER_DEGREE; method++) {
+    assert(reorder_compute(graph, (ReorderMethod)method, order));
+    check_permutation(order, n);
+  }
+  assert(reorder_compute(graph, REORDER_RCM, order));
+  // A grid's bandwidth is about its side after RCM
+  assert(bandwidth(graph, order) <= 2 * (size_t)side);
+  assert(shuffled > 10 * (size_t)side);
+  assert(reorder_compute(graph, REORDER_DEGREE, order));
+  for (int i = 1; i < n; i++)
+    assert(csr_degree(graph, CSR_EDGES, order[i - 1]) >=
+           csr_degree(graph, CSR_EDGES, order[i]));
+  assert(!reorder_compute(NULL, REORDER_BFS, order));
+  csr_destroy(graph);
+  for (int i = 0; i < n; i++)
+    destroy_node(grid[i]);
+  free(grid);
+  free(order);
+  free(identity);
+
+  // BFS from the root lays a tree out level by level
+  Node *tree[40];
+  for (int i = 0; i < 40; i++) {
+    tree[i] = create_node(NULL, (double)i);
+    if (i > 0)
+      add_child(tree[(i - 1) / 3], tree[i]);
+  }
+  graph = csr_freeze_from(tree[39]);
+  order = malloc(graph->num_nodes * sizeof(uint32_t));
+  assert(reorder_compute(graph, REORDER_BFS, order));
+  for (size_t i = 1; i < graph->num_nodes; i++)
+    assert(depth(graph->nodes[order[i - 1]]) <= depth(graph->nodes[order[i]]));
+  for (size_t i = 0; i < graph->num_nodes; i++)
+    destroy_node(graph->nodes[i]);
+  csr_destroy(graph);
+  free(order);
+  printf("Reorder permutation tests passed!\n");
+}
+
+// Structure fingerprint by node_id, independent of node addresses
+double fingerprint(Node *node) {
+  double sum = node->node_id * 7 + (node->parent ? node->parent->node_id : -1);
+  NodeSet *sets[4] = {node->edges, node->incoming, node->outgoing,
+                      node->children};
+  for (int k = 0; k < 4; k++)
+    for (size_t j = 0; j < nodeset_size(sets[k]); j++)
+      sum += (k + 1) * (j + 1) *
+             (sets[k]->nodes[j]->node_id + nodeset_weight(sets[k], j));
+  return sum;
+}
+
+void test_relocation() {
+  printf("Testing node relocation...\n");
+  srand(62);
+  int count = 3000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  Node **relocated = malloc(count * sizeof(Node *));
+  double *expected = malloc(count * sizeof(double));
+  for (int i = 0; i < count; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    if (i > 0)
+      add_child(nodes[rand() % (i < 10 ? i : 10)], nodes[i]);
+  }
+  for (int i = 0; i < 4 * count; i++)
+    add_weighted_edge(nodes[rand() % count], nodes[rand() % count],
+                      (uint32_t)(rand() % 9), rand() % 2, rand() % 2);
+  int tree_height = height(nodes[0]);
+  for (int i = 0; i < count; i++)
+    expected[i] = fingerprint(nodes[i]);
+
+  GraphArena *previous = NULL;
+  for (int method = REORDER_BFS; method <= REORDER_DEGREE; method++) {
+    GraphArena *arena =
+        reorder_nodes(nodes, count, (ReorderMethod)method, relocated);
+    assert(arena && arena_num_nodes(arena) == (size_t)count);
+    for (int i = 0; i < count; i++) {
+      Node *node = relocated[i];
+      assert(node->arena == arena);
+      assert(fingerprint(node) == expected[(int)node->node_id]);
+      // One contiguous block in the new order
+      if (i > 0)
+        assert((char *)node - (char *)relocated[i - 1] ==
+               (char *)relocated[1] - (char *)relocated[0]);
+      nodes[(int)node->node_id] = node;
+    }
+    assert(height(nodes[0]) == tree_height);
+    assert(nodes[0]->children->borrowed);
+    // Sets copied out of the shared storage keep working
+    Node *extra = arena_create_node(arena, NULL, -1.0);
+    add_child(nodes[0], extra);
+    assert(!nodes[0]->children->borrowed);
+    assert(nodeset_contains(nodes[0]->children, nodes[1]));
+    assert(num_nodes(nodes[0]) == count + 1);
+    nodeset_swap_remove(nodes[0]->children, extra);
+    node_invalidate(nodes[0]);
+    destroy_node(extra);
+    for (int i = 0; i < count; i++)
+      expected[i] = fingerprint(nodes[i]);
+    // Each pass destroyed its input, so the previous arena is empty
+    assert(arena_num_nodes(previous) == 0);
+    arena_destroy(previous);
+    previous = arena;
+  }
+  arena_destroy(previous);
+  free(nodes);
+  free(relocated);
+  free(expected);
+  printf("Node relocation tests passed!\n");
+}
+
+void test_graph() {
+  printf("Testing graph reordering...\n");
+  Graph *graph = graph_create(0);
+  for (int i = 0; i < 500; i++)
+    graph_add_node(graph, NULL, i * 0.5);
+  for (int i = 0; i < 2000; i++)
+    graph_add_edge_by_id(graph, (rand() % 500) * 0.5, (rand() % 500) * 0.5,
+                         false, true);
+  double before = 0;
+  for (int i = 0; i < 500; i++)
+    before += fingerprint(graph_find(graph, i * 0.5));
+  assert(reorder_graph(graph, REORDER_RCM));
+  double after = 0;
+  for (int i = 0; i < 500; i++) {
+    Node *node = graph_find(graph, i * 0.5);
+    assert(node && node->node_id == i * 0.5 && node->arena == graph->arena);
+    after += fingerprint(node);
+  }
+  assert(before == after);
+  assert(graph_add_node(graph, NULL, 1000.0));
+  graph_destroy(graph);
+  printf("Graph reordering tests passed!\n");
+}
+
+int main() {
+  test_orders();
+  test_relocation();
+  test_graph();
+  printf("All reorder tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,238 @@
+#include "snapshot.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char path[] = "/tmp/test_snapshotXXXXXX";
+
+static bool encode_int(FILE *out, void *value, void *ctx) {
+  int *calls = (int *)ctx;
+  (*calls)++;
+  // Variable length: nothing for NULL, otherwise the int as text
+  if (!value)
+    return true;
+  return fprintf(out, "%d", *(int *)value) > 0;
+}
+
+static void *decode_int(const void *data, size_t size, void *ctx) {
+  (void)ctx;
+  if (size == 0)
+    return NULL;
+  char text[32];
+  memcpy(text, data, size);
+  text[size] = '\0';
+  int *value = malloc(sizeof(int));
+  *value = atoi(text);
+  return value;
+}
+
+static bool encode_fail(FILE *out, void *value, void *ctx) {
+  (void)out;
+  (void)value;
+  (void)ctx;
+  return false;
+}
+
+// A weighted, directed mesh with a tree over it; values on every other node
+static Graph *build_sample_graph(int count, int *values) {
+  Graph *graph = graph_create(0);
+  for (int i = 0; i < count; i++) {
+    values[i] = i * 10;
+    graph_add_node(graph, i % 2 ? NULL : &values[i], (double)(i * 3 + 1));
+  }
+  Node **nodes = graph->nodes;
+  for (int i = 0; i < count; i++) {
+    add_weighted_edge(nodes[i], nodes[(i * 7 + 1) % count], (uint32_t)i + 5,
+                      true, false);
+    add_edge(nodes[i], nodes[(i + 1) % count], false, true);
+    if (i > 0)
+      add_child(nodes[(i - 1) / 3], nodes[i]);
+  }
+  // A hub large enough for an indexed set
+  for (int i = 1; i < count; i++)
+    add_edge(nodes[0], nodes[i], true, false);
+  return graph;
+}
+
+static bool same_arrays(const void *a, const void *b, size_t bytes) {
+  return bytes == 0 || memcmp(a, b, bytes) == 0;
+}
+
+void test_roundtrip() {
+  printf("Testing snapshot roundtrip...\n");
+  int count = 200;
+  int values[200];
+  Graph *graph = build_sample_graph(count, values);
+  int calls = 0;
+  assert(snapshot_write(path, graph->nodes, graph->num_nodes, encode_int,
+                        &calls));
+  assert(calls == count);
+  char temp[64];
+  snprintf(temp, sizeof(temp), "%s.tmp", path);
+  assert(access(temp, F_OK) != 0);
+
+  Snapshot *snapshot = snapshot_open(path);
+  assert(snapshot && snapshot_validate(snapshot));
+  CSRGraph *expected = csr_freeze(graph->nodes, graph->num_nodes);
+  const CSRGraph *view = &snapshot->graph;
+  size_t n = expected->num_nodes;
+  assert(view->num_nodes == n && view->nodes == NULL);
+  assert(same_arrays(view->node_ids, expected->node_ids, n * sizeof(double)));
+  assert(same_arrays(view->parent, expected->parent, n * sizeof(uint32_t)));
+  for (int kind = 0; kind < CSR_KINDS; kind++) {
+    size_t entries = expected->offsets[kind][n];
+    assert(same_arrays(view->offsets[kind], expected->offsets[kind],
+                       (n + 1) * sizeof(uint64_t)));
+    assert(same_arrays(view->neighbors[kind], expected->neighbors[kind],
+                       entries * sizeof(uint32_t)));
+    assert((view->weights[kind] == NULL) == (expected->weights[kind] == NULL));
+    if (view->weights[kind])
+      assert(same_arrays(view->weights[kind], expected->weights[kind],
+                         entries * sizeof(uint32_t)));
+  }
+  assert(view->weights[CSR_OUTGOING] && !view->weights[CSR_CHILDREN]);
+  assert(csr_height(view, 0) == csr_height(expected, 0));
+  assert(csr_num_nodes(view, 0) == count);
+  assert(csr_index_of(view, graph->nodes[0]) == CSR_NONE);
+  printf("The mapped view matches csr_freeze\n");
+
+  size_t size;
+  const char *blob = snapshot_value(snapshot, 4, &size);
+  assert(blob && size == 2 && memcmp(blob, "40", 2) == 0);
+  assert(snapshot_value(snapshot, 5, &size) && size == 0);
+  assert(snapshot_value(snapshot, (uint32_t)count, &size) == NULL);
+  printf("Values are read in place\n");
+
+  Graph *thawed = snapshot_to_graph(snapshot, decode_int, NULL);
+  assert(thawed && graph_num_nodes(thawed) == graph_num_nodes(graph));
+  for (size_t i = 0; i < graph->num_nodes; i++) {
+    Node *a = graph->nodes[i];
+    Node *b = thawed->nodes[i];
+    assert(a->node_id == b->node_id && graph_find(thawed, b->node_id) == b);
+    assert((a->parent == NULL) == (b->parent == NULL));
+    assert(!a->parent || a->parent->node_id == b->parent->node_id);
+    if (a->value)
+      assert(b->value && *(int *)b->value == *(int *)a->value);
+    else
+      assert(b->value == NULL);
+    NodeSet *as[4] = {a->edges, a->incoming, a->outgoing, a->children};
+    NodeSet *bs[4] = {b->edges, b->incoming, b->outgoing, b->children};
+    for (int k = 0; k < 4; k++) {
+      assert(as[k]->size == bs[k]->size);
+      for (size_t j = 0; j < as[k]->size; j++) {
+        assert(as[k]->nodes[j]->node_id == bs[k]->nodes[j]->node_id);
+        assert(nodeset_weight(as[k], j) == nodeset_weight(bs[k], j));
+        assert(nodeset_contains(bs[k], bs[k]->nodes[j]));
+      }
+    }
+    free(b->value);
+  }
+  assert(thawed->nodes[0]->outgoing->index != NULL);
+  printf("The thawed graph matches the original\n");
+
+  graph_destroy(thawed);
+  csr_destroy(expected);
+  snapshot_close(snapshot);
+  graph_destroy(graph);
+}
+
+void test_without_values() {
+  printf("Testing snapshots without values...\n");
+  int values[50];
+  Graph *graph = build_sample_graph(50, values);
+  assert(snapshot_write(path, graph->nodes, graph->num_nodes, NULL, NULL));
+  Snapshot *snapshot = snapshot_open(path);
+  assert(snapshot && snapshot_validate(snapshot));
+  assert(snapshot->value_offsets == NULL);
+  assert(snapshot_value(snapshot, 0, NULL) == NULL);
+  Graph *thawed = snapshot_to_graph(snapshot, decode_int, NULL);
+  assert(thawed && thawed->nodes[0]->value == NULL);
+  graph_destroy(thawed);
+  snapshot_close(snapshot);
+
+  // A partial list drops edges leaving it, as csr_freeze does
+  assert(snapshot_write(path, graph->nodes, 10, NULL, NULL));
+  snapshot = snapshot_open(path);
+  assert(snapshot && snapshot->graph.num_nodes == 10);
+  assert(snapshot_validate(snapshot));
+  snapshot_close(snapshot);
+
+  assert(snapshot_write(path, NULL, 0, encode_int, &(int){0}));
+  snapshot = snapshot_open(path);
+  assert(snapshot && snapshot->graph.num_nodes == 0);
+  assert(snapshot_validate(snapshot));
+  thawed = snapshot_to_graph(snapshot, NULL, NULL);
+  assert(thawed && graph_num_nodes(thawed) == 0);
+  graph_destroy(thawed);
+  snapshot_close(snapshot);
+  graph_destroy(graph);
+  printf("Empty and partial snapshots load\n");
+}
+
+// Overwrites bytes of the snapshot file at offset
+static void patch_file(long offset, const void *data, size_t size) {
+  FILE *file = fopen(path, "r+b");
+  assert(file && fseek(file, offset, SEEK_SET) == 0);
+  assert(fwrite(data, 1, size, file) == size);
+  fclose(file);
+}
+
+void test_rejects() {
+  printf("Testing damaged snapshots...\n");
+  int values[50];
+  Graph *graph = build_sample_graph(50, values);
+  assert(snapshot_open("/nonexistent/graph.snap") == NULL);
+  assert(!snapshot_write(path, NULL, 3, NULL, NULL));
+
+  // A failed encode leaves the previous snapshot in place
+  assert(snapshot_write(path, graph->nodes, graph->num_nodes, NULL, NULL));
+  assert(!snapshot_write(path, graph->nodes, 5, encode_fail, NULL));
+  Snapshot *snapshot = snapshot_open(path);
+  assert(snapshot && snapshot->graph.num_nodes == 50);
+  snapshot_close(snapshot);
+
+  // Truncated
+  assert(truncate(path, 100) == 0);
+  assert(snapshot_open(path) == NULL);
+
+  // Bad magic, then a neighbor out of range
+  assert(snapshot_write(path, graph->nodes, graph->num_nodes, NULL, NULL));
+  patch_file(0, "X", 1);
+  assert(snapshot_open(path) == NULL);
+  assert(snapshot_write(path, graph->nodes, graph->num_nodes, NULL, NULL));
+  snapshot = snapshot_open(path);
+  char *base = (char *)snapshot->map;
+  long neighbors = (long)((char *)snapshot->graph.neighbors[CSR_EDGES] - base);
+  snapshot_close(snapshot);
+  uint32_t bad = 50;
+  patch_file(neighbors, &bad, sizeof(bad));
+  snapshot = snapshot_open(path);
+  assert(snapshot && !snapshot_validate(snapshot));
+  snapshot_close(snapshot);
+  printf("Damaged files are refused or fail validation\n");
+
+  // Graph needs distinct ids
+  Node *twins[2] = {create_node(NULL, 7.0), create_node(NULL, 7.0)};
+  assert(snapshot_write(path, twins, 2, NULL, NULL));
+  snapshot = snapshot_open(path);
+  assert(snapshot && snapshot_to_graph(snapshot, NULL, NULL) == NULL);
+  snapshot_close(snapshot);
+  destroy_node(twins[0]);
+  destroy_node(twins[1]);
+  graph_destroy(graph);
+  printf("Repeated ids are refused by snapshot_to_graph\n");
+}
+
+int main() {
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  close(fd);
+  test_roundtrip();
+  test_without_values();
+  test_rejects();
+  unlink(path);
+  printf("All snapshot tests passed!\n");
+  return 0;
+}
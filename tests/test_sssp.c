@@ -0,0 +1,169 @@
+#include "sssp.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Bellman-Ford over the same view, as a reference
+void reference(const CSRGraph *graph, CSRKind kind, uint32_t source,
+               uint64_t *dist) {
+  for (size_t i = 0; i < graph->num_nodes; i++)
+    dist[i] = SSSP_INF;
+  dist[source] = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (uint32_t u = 0; u < graph->num_nodes; u++) {
+      if (dist[u] == SSSP_INF)
+        continue;
+      const uint32_t *neighbors = csr_neighbors(graph, kind, u);
+      const uint32_t *weights = csr_weights(graph, kind, u);
+      for (size_t j = 0; j < csr_degree(graph, kind, u); j++) {
+        uint64_t d = dist[u] + (weights ? weights[j] : 1);
+        if (d < dist[neighbors[j]]) {
+          dist[neighbors[j]] = d;
+          changed = true;
+        }
+      }
+    }
+  }
+}
+
+// Sums the weights along a path, or SSSP_INF if some step is not an edge
+uint64_t path_length(const CSRGraph *graph, CSRKind kind, uint32_t *path,
+                     size_t len) {
+  uint64_t total = 0;
+  for (size_t i = 0; i + 1 < len; i++) {
+    const uint32_t *neighbors = csr_neighbors(graph, kind, path[i]);
+    const uint32_t *weights = csr_weights(graph, kind, path[i]);
+    uint64_t best = SSSP_INF;
+    for (size_t j = 0; j < csr_degree(graph, kind, path[i]); j++) {
+      uint64_t w = weights ? weights[j] : 1;
+      if (neighbors[j] == path[i + 1] && w < best)
+        best = w;
+    }
+    if (best == SSSP_INF)
+      return SSSP_INF;
+    total += best;
+  }
+  return total;
+}
+
+Node **random_graph(int count, int edges, bool directed, uint32_t max_weight) {
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  for (int i = 0; i < edges; i++) {
+    Node *u = nodes[rand() % count], *v = nodes[rand() % count];
+    uint32_t w = (uint32_t)(rand() % max_weight);
+    if (max_weight > 1000 && rand() % 2)
+      w = (uint32_t)rand() << 1; // Spread keys over high radix buckets
+    add_weighted_edge(u, v, w, directed, !directed);
+  }
+  return nodes;
+}
+
+void check_graph(Node **nodes, int count, CSRKind kind) {
+  CSRGraph *graph = csr_freeze(nodes, count);
+  uint64_t *dist = malloc(count * sizeof(uint64_t));
+  uint64_t *expected = malloc(count * sizeof(uint64_t));
+  uint32_t *parent = malloc(count * sizeof(uint32_t));
+  uint32_t *path = malloc(count * sizeof(uint32_t));
+  SSSPSearch *search = sssp_search_create(graph, kind);
+  assert(search);
+  for (int round = 0; round < 5; round++) {
+    uint32_t source = (uint32_t)(rand() % count);
+    assert(sssp_dijkstra(graph, kind, source, dist, parent));
+    reference(graph, kind, source, expected);
+    for (int i = 0; i < count; i++) {
+      assert(dist[i] == expected[i]);
+      if (i == (int)source || dist[i] == SSSP_INF) {
+        assert(parent[i] == CSR_NONE);
+      } else {
+        uint32_t hop[2] = {parent[i], (uint32_t)i};
+        assert(dist[parent[i]] + path_length(graph, kind, hop, 2) == dist[i]);
+      }
+    }
+    for (int q = 0; q < 50; q++) {
+      uint32_t target = (uint32_t)(rand() % count);
+      size_t len;
+      uint64_t d = sssp_search_path(search, source, target, path, &len);
+      assert(d == expected[target]);
+      if (d == SSSP_INF) {
+        assert(len == 0);
+        continue;
+      }
+      assert(path[0] == source && path[len - 1] == target);
+      assert(path_length(graph, kind, path, len) == d);
+      assert(sssp_search_path(search, source, target, NULL, NULL) == d);
+    }
+  }
+  sssp_search_destroy(search);
+  csr_destroy(graph);
+  free(dist);
+  free(expected);
+  free(parent);
+  free(path);
+}
+
+void test_random_graphs() {
+  printf("Testing Dijkstra and bidirectional search...\n");
+  srand(41);
+  int count = 400;
+  uint32_t max_weights[] = {1, 10, 1u << 20};
+  for (int w = 0; w < 3; w++) {
+    Node **nodes = random_graph(count, 4 * count, true, max_weights[w]);
+    check_graph(nodes, count, CSR_OUTGOING);
+    check_graph(nodes, count, CSR_INCOMING);
+    for (int i = 0; i < count; i++)
+      destroy_node(nodes[i]);
+    free(nodes);
+    nodes = random_graph(count, 2 * count, false, max_weights[w]);
+    check_graph(nodes, count, CSR_EDGES);
+    for (int i = 0; i < count; i++)
+      destroy_node(nodes[i]);
+    free(nodes);
+  }
+  printf("Random graph tests passed!\n");
+}
+
+void test_small_cases() {
+  printf("Testing shortest path edge cases...\n");
+  // 0 -> 1 -> 2 costs 2 + 3; the direct edge costs 10; 3 is isolated
+  Node *nodes[4];
+  for (int i = 0; i < 4; i++)
+    nodes[i] = create_node(NULL, (double)i);
+  add_weighted_edge(nodes[0], nodes[1], 2, true, false);
+  add_weighted_edge(nodes[1], nodes[2], 3, true, false);
+  add_weighted_edge(nodes[0], nodes[2], 10, true, false);
+  CSRGraph *graph = csr_freeze(nodes, 4);
+  uint64_t dist[4];
+  uint32_t parent[4], path[4];
+  size_t len;
+  assert(sssp_dijkstra(graph, CSR_OUTGOING, 0, dist, parent));
+  assert(dist[2] == 5 && parent[2] == 1 && dist[3] == SSSP_INF);
+  assert(sssp_dijkstra(graph, CSR_OUTGOING, 0, dist, NULL));
+  assert(!sssp_dijkstra(graph, CSR_OUTGOING, 4, dist, parent));
+
+  SSSPSearch *search = sssp_search_create(graph, CSR_OUTGOING);
+  assert(sssp_search_path(search, 0, 2, path, &len) == 5);
+  assert(len == 3 && path[0] == 0 && path[1] == 1 && path[2] == 2);
+  assert(sssp_search_path(search, 2, 0, path, &len) == SSSP_INF && len == 0);
+  assert(sssp_search_path(search, 1, 1, path, &len) == 0);
+  assert(len == 1 && path[0] == 1);
+  assert(sssp_search_path(search, 0, 3, NULL, NULL) == SSSP_INF);
+  assert(sssp_search_path(search, 0, 9, NULL, NULL) == SSSP_INF);
+  sssp_search_destroy(search);
+  assert(sssp_search_create(graph, CSR_CHILDREN) == NULL);
+
+  csr_destroy(graph);
+  for (int i = 0; i < 4; i++)
+    destroy_node(nodes[i]);
+  printf("Edge case tests passed!\n");
+}
+
+int main() {
+  test_small_cases();
+  test_random_graphs();
+  printf("All sssp tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,129 @@
+#include "subtree.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+void naive_aggregate(Node *node, double *sum, double *max, size_t *count) {
+  double value = subtree_project_double(node, NULL);
+  *sum += value;
+  if (value > *max)
+    *max = value;
+  (*count)++;
+  for (size_t i = 0; i < nodeset_size(node->children); i++)
+    naive_aggregate(node->children->nodes[i], sum, max, count);
+}
+
+void check_node(SubtreeIndex *index, Node *node) {
+  double sum = 0.0, max = -INFINITY;
+  size_t count = 0;
+  naive_aggregate(node, &sum, &max, &count);
+  assert(subtree_sum(index, node) == sum);
+  assert(subtree_max(index, node) == max);
+  assert(subtree_count(index, node) == count);
+}
+
+void test_aggregates() {
+  printf("Testing subtree aggregates...\n");
+  int count = 3000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  double *values = malloc(count * sizeof(double));
+  srand(21);
+  for (int i = 0; i < count; i++) {
+    values[i] = (double)(rand() % 1000 - 500);
+    nodes[i] = create_node(&values[i], (double)i);
+    if (i > 0)
+      add_child(nodes[rand() % i], nodes[i]);
+  }
+  SubtreeIndex *index = subtree_create(nodes[0], subtree_project_double, NULL);
+  assert(index && index->size == (size_t)count);
+  for (int i = 0; i < count; i += 7)
+    check_node(index, nodes[i]);
+
+  // Point updates through the projection and directly
+  for (int round = 0; round < 2000; round++) {
+    int i = rand() % count;
+    values[i] = (double)(rand() % 1000 - 500);
+    if (round % 2)
+      assert(subtree_refresh(index, nodes[i]));
+    else
+      assert(subtree_set(index, nodes[i], values[i]));
+    assert(subtree_value(index, nodes[i]) == values[i]);
+    if (round % 50 == 0) {
+      check_node(index, nodes[0]);
+      check_node(index, nodes[rand() % count]);
+    }
+  }
+  for (int i = 0; i < count; i += 3)
+    check_node(index, nodes[i]);
+
+  Node *stranger = create_node(NULL, -1.0);
+  assert(isnan(subtree_sum(index, stranger)));
+  assert(isnan(subtree_max(index, stranger)));
+  assert(isnan(subtree_value(index, stranger)));
+  assert(subtree_count(index, stranger) == 0);
+  assert(!subtree_set(index, stranger, 1.0));
+
+  // New nodes show up after a rebuild
+  add_child(nodes[5], stranger);
+  double old_sum = subtree_sum(index, nodes[0]);
+  assert(subtree_rebuild(index));
+  assert(subtree_count(index, stranger) == 1);
+  assert(subtree_value(index, stranger) == 0.0);
+  assert(subtree_sum(index, nodes[0]) == old_sum);
+  check_node(index, nodes[5]);
+  assert(subtree_create(NULL, subtree_project_double, NULL) == NULL);
+  assert(subtree_create(nodes[0], NULL, NULL) == NULL);
+
+  subtree_destroy(index);
+  destroy_node(stranger);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  free(values);
+  printf("Subtree aggregate tests passed!\n");
+}
+
+double project_id(Node *node, void *ctx) {
+  return node->node_id * *(double *)ctx;
+}
+
+void test_projection() {
+  printf("Testing subtree projection and deep chains...\n");
+  int count = 100000;
+  Node **nodes = malloc(count * sizeof(Node *));
+  for (int i = 0; i < count; i++) {
+    nodes[i] = create_node(NULL, (double)i);
+    if (i > 0)
+      add_child(nodes[i - 1], nodes[i]);
+  }
+  double scale = 2.0;
+  SubtreeIndex *index = subtree_create(nodes[0], project_id, &scale);
+  assert(index);
+  // sum of 2 * i for i in [k, count)
+  int k = count - 1000;
+  double expected = (double)(count - 1 + k) * (count - k);
+  assert(subtree_sum(index, nodes[k]) == expected);
+  assert(subtree_max(index, nodes[k]) == 2.0 * (count - 1));
+  assert(subtree_count(index, nodes[0]) == (size_t)count);
+
+  SubtreeIndex *single = subtree_create(nodes[count - 1], project_id, &scale);
+  assert(single->size == 1);
+  assert(subtree_sum(single, nodes[count - 1]) == 2.0 * (count - 1));
+  assert(subtree_set(single, nodes[count - 1], -3.0));
+  assert(subtree_max(single, nodes[count - 1]) == -3.0);
+  subtree_destroy(single);
+
+  subtree_destroy(index);
+  for (int i = 0; i < count; i++)
+    destroy_node(nodes[i]);
+  free(nodes);
+  printf("Subtree projection tests passed!\n");
+}
+
+int main() {
+  test_aggregates();
+  test_projection();
+  printf("All subtree tests passed!\n");
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include "taskpool.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+  Task task;
+  TaskPool *pool;
+  int n;
+  long result;
+} FibTask;
+
+void run_fib(Task *task) {
+  FibTask *fib = (FibTask *)task;
+  if (fib->n < 2) {
+    fib->result = fib->n;
+    return;
+  }
+  FibTask left = {{run_fib, false}, fib->pool, fib->n - 1, 0};
+  FibTask right = {{run_fib, false}, fib->pool, fib->n - 2, 0};
+  taskpool_spawn(fib->pool, &left.task);
+  taskpool_spawn(fib->pool, &right.task);
+  taskpool_wait(fib->pool, &right.task);
+  taskpool_wait(fib->pool, &left.task);
+  fib->result = left.result + right.result;
+}
+
+long fib_with(TaskPool *pool, int n) {
+  FibTask root = {{run_fib, false}, pool, n, 0};
+  taskpool_run(pool, &root.task);
+  return root.result;
+}
+
+void test_fork_join() {
+  printf("Testing spawn and wait...\n");
+  // Without a pool everything runs inline
+  assert(fib_with(NULL, 20) == 6765);
+  for (int threads = 1; threads <= 4; threads++) {
+    TaskPool *pool = taskpool_create(threads);
+    assert(taskpool_threads(pool) == threads);
+    // Far more tasks than deque slots, and repeated runs on one pool
+    assert(fib_with(pool, 22) == 17711);
+    assert(fib_with(pool, 15) == 610);
+    taskpool_destroy(pool);
+  }
+  printf("Spawn and wait tests passed!\n");
+}
+
+void test_hungry() {
+  printf("Testing taskpool_hungry...\n");
+  // Outside a run nobody is hungry
+  TaskPool *pool = taskpool_create(2);
+  assert(!taskpool_hungry(pool));
+  assert(!taskpool_hungry(NULL));
+  taskpool_destroy(pool);
+  printf("taskpool_hungry tests passed!\n");
+}
+
+int main() {
+  test_fork_join();
+  test_hungry();
+  printf("All taskpool tests passed!\n");
+  return 0;
+}